@@ -0,0 +1,73 @@
+#include "BodySink.h"
+
+#include <algorithm>
+
+#include "Core/Utils/CoreUtils.h"
+
+namespace {
+
+// Receive buffers up to this size are kept for the following requests
+constexpr size_t kMaxRetainedBodySize = 4 * 1024 * 1024;
+
+// Content-Length is trusted only up to this size when preallocating the receive buffer
+constexpr int64_t kMaxReservedBodySize = 64 * 1024 * 1024;
+
+}
+
+bool MemoryBodySink::begin(int64_t contentLength) {
+    if (contentLength > 0) {
+        buffer_.reserve(static_cast<size_t>(std::min(contentLength, kMaxReservedBodySize)));
+    }
+    return true;
+}
+
+bool MemoryBodySink::write(const char* data, size_t size) {
+    buffer_.append(data, size);
+    return true;
+}
+
+void MemoryBodySink::end() {
+}
+
+const std::string& MemoryBodySink::data() const {
+    return buffer_;
+}
+
+std::string MemoryBodySink::take() {
+    std::string res = std::move(buffer_);
+    buffer_.clear();
+    return res;
+}
+
+void MemoryBodySink::clear() {
+    if (buffer_.capacity() > kMaxRetainedBodySize) {
+        // Assigning an empty string may keep the allocation
+        std::string().swap(buffer_);
+    } else {
+        buffer_.clear();
+    }
+}
+
+FileBodySink::FileBodySink(std::string fileName) : fileName_(std::move(fileName)) {
+}
+
+FileBodySink::~FileBodySink() {
+    end();
+}
+
+bool FileBodySink::begin(int64_t) {
+    end();
+    file_ = IuCoreUtils::fopen_utf8(fileName_.c_str(), "wb");
+    return file_ != nullptr;
+}
+
+bool FileBodySink::write(const char* data, size_t size) {
+    return file_ && fwrite(data, 1, size, file_) == size;
+}
+
+void FileBodySink::end() {
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef IU_CORE_NETWORK_BODYSINK_H
+#define IU_CORE_NETWORK_BODYSINK_H
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "Core/Utils/CoreTypes.h"
+
+/**
+ * Receives the response body chunk by chunk while it is being downloaded, so the body can be processed
+ * (parsed, hashed, written out) as it arrives, without being kept in memory as a whole.
+ *
+ * Methods are called on the thread performing the transfer.
+ */
+class BodySink {
+public:
+    virtual ~BodySink() = default;
+
+    /**
+     * Called before the first chunk of a response.
+     * @param contentLength - size announced by the server, -1 if unknown. For compressed responses
+     * this is the encoded size.
+     * @return false to abort the transfer.
+     */
+    virtual bool begin(int64_t contentLength) = 0;
+
+    /**
+     * @return false to abort the transfer.
+     */
+    virtual bool write(const char* data, size_t size) = 0;
+
+    /**
+     * Called when the transfer is finished, successfully or not, if begin() was called.
+     */
+    virtual void end() = 0;
+};
+
+/**
+ * Keeps the body in memory. The buffer keeps its capacity for the following responses,
+ * unless an unusually large one was received.
+ */
+class MemoryBodySink : public BodySink {
+public:
+    MemoryBodySink() = default;
+
+    bool begin(int64_t contentLength) override;
+    bool write(const char* data, size_t size) override;
+    void end() override;
+
+    const std::string& data() const;
+    // Moves the body out, the next one is received into a new buffer
+    std::string take();
+    void clear();
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(MemoryBodySink);
+    std::string buffer_;
+};
+
+/**
+ * Writes the body to a file, which is created when the first chunk arrives.
+ */
+class FileBodySink : public BodySink {
+public:
+    explicit FileBodySink(std::string fileName);
+    ~FileBodySink() override;
+
+    bool begin(int64_t contentLength) override;
+    bool write(const char* data, size_t size) override;
+    void end() override;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(FileBodySink);
+    std::string fileName_;
+    FILE* file_ = nullptr;
+};
+
+#endif
@@ -0,0 +1,281 @@
+#include "CurlMultiReactor.h"
+
+#include <algorithm>
+#include <future>
+
+#include "NetworkClient.h"
+
+namespace {
+
+// Upper bound for a single curl_multi_poll() call when there is nothing else to wait for
+constexpr int kMaxPollTimeoutMs = 1000;
+
+}
+
+CurlMultiReactor::CurlMultiReactor()
+{
+    NetworkClient::curl_init();
+    multi_ = curl_multi_init();
+}
+
+CurlMultiReactor::~CurlMultiReactor()
+{
+    stop();
+    curl_multi_cleanup(multi_);
+}
+
+void CurlMultiReactor::start()
+{
+    if (thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        exited_ = false;
+    }
+    stopSignal_ = false;
+    thread_ = std::thread(&CurlMultiReactor::run, this);
+}
+
+void CurlMultiReactor::stop(std::chrono::milliseconds drainTimeout)
+{
+    if (!thread_.joinable()) {
+        return;
+    }
+    drainDeadline_ = Clock::now() + drainTimeout;
+    stopSignal_ = true;
+    curl_multi_wakeup(multi_);
+    thread_.join();
+}
+
+void CurlMultiReactor::stopDetached(std::unique_ptr<CurlMultiReactor> reactor, Task onStopped,
+    std::chrono::milliseconds drainTimeout)
+{
+    std::thread([reactor = std::move(reactor), onStopped = std::move(onStopped), drainTimeout]() mutable {
+        reactor->stop(drainTimeout);
+        reactor = nullptr;
+        if (onStopped) {
+            onStopped();
+        }
+    }).detach();
+}
+
+bool CurlMultiReactor::enqueue(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (exited_) {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    curl_multi_wakeup(multi_);
+    return true;
+}
+
+bool CurlMultiReactor::post(Task task)
+{
+    return enqueue(std::move(task));
+}
+
+void CurlMultiReactor::invoke(const Task& task)
+{
+    if (isReactorThread()) {
+        task();
+        return;
+    }
+    std::promise<void> done;
+    std::future<void> future = done.get_future();
+
+    bool queued = enqueue([&task, &done] {
+        try {
+            task();
+            done.set_value();
+        } catch (...) {
+            done.set_exception(std::current_exception());
+        }
+    });
+
+    if (!queued) {
+        // Event loop is not running, nobody else can touch the state
+        task();
+        return;
+    }
+    future.get();
+}
+
+CurlMultiReactor::TimerId CurlMultiReactor::scheduleAt(Clock::time_point when, Task task)
+{
+    TimerId id;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        id = nextTimerId_++;
+        timers_.emplace(when, Timer{ id, std::move(task) });
+    }
+    curl_multi_wakeup(multi_);
+    return id;
+}
+
+void CurlMultiReactor::cancelTimer(TimerId id)
+{
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = std::find_if(timers_.begin(), timers_.end(), [id](const auto& t) {
+        return t.second.id == id;
+    });
+    if (it != timers_.end()) {
+        timers_.erase(it);
+    }
+}
+
+bool CurlMultiReactor::addTransfer(CURL* handle, CompletionCallback callback)
+{
+    if (curl_multi_add_handle(multi_, handle) != CURLM_OK) {
+        return false;
+    }
+    transfers_[handle] = std::move(callback);
+    return true;
+}
+
+void CurlMultiReactor::removeTransfer(CURL* handle)
+{
+    auto it = transfers_.find(handle);
+    if (it == transfers_.end()) {
+        return;
+    }
+    curl_multi_remove_handle(multi_, handle);
+    transfers_.erase(it);
+}
+
+bool CurlMultiReactor::isReactorThread() const
+{
+    return threadId_.load() == std::this_thread::get_id();
+}
+
+void CurlMultiReactor::run()
+{
+    threadId_ = std::this_thread::get_id();
+
+    while (true) {
+        runPendingTasks();
+
+        if (!stopSignal_) {
+            runDueTimers();
+        }
+
+        int running = 0;
+        curl_multi_perform(multi_, &running);
+        processMessages();
+
+        if (stopSignal_ && (transfers_.empty() || Clock::now() >= drainDeadline_)) {
+            break;
+        }
+
+        curl_multi_poll(multi_, nullptr, 0, calcPollTimeout(), nullptr);
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        exited_ = true;
+        timers_.clear();
+    }
+    // Tasks which were queued before exit still have to be run, somebody may be waiting for them
+    runPendingTasks();
+    abortTransfers();
+    threadId_ = std::thread::id();
+}
+
+void CurlMultiReactor::runPendingTasks()
+{
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        tasks.swap(tasks_);
+    }
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void CurlMultiReactor::runDueTimers()
+{
+    std::vector<Task> due;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        auto now = Clock::now();
+        auto it = timers_.begin();
+        while (it != timers_.end() && it->first <= now) {
+            due.push_back(std::move(it->second.task));
+            it = timers_.erase(it);
+        }
+    }
+    for (auto& task : due) {
+        task();
+    }
+}
+
+void CurlMultiReactor::processMessages()
+{
+    CURLMsg* msg;
+    int msgsLeft = 0;
+
+    while ((msg = curl_multi_info_read(multi_, &msgsLeft)) != nullptr) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+        CURL* handle = msg->easy_handle;
+        CURLcode result = msg->data.result;
+
+        curl_multi_remove_handle(multi_, handle);
+
+        auto it = transfers_.find(handle);
+        if (it == transfers_.end()) {
+            continue;
+        }
+        // The callback is allowed to start a new transfer on the same handle
+        CompletionCallback callback = std::move(it->second);
+        transfers_.erase(it);
+        if (callback) {
+            callback(result);
+        }
+    }
+}
+
+int CurlMultiReactor::calcPollTimeout()
+{
+    auto now = Clock::now();
+    auto deadline = now + std::chrono::milliseconds(kMaxPollTimeoutMs);
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (!tasks_.empty()) {
+            return 0;
+        }
+        if (!stopSignal_ && !timers_.empty()) {
+            deadline = std::min(deadline, timers_.begin()->first);
+        }
+    }
+    if (stopSignal_) {
+        deadline = std::min(deadline, drainDeadline_);
+    }
+    if (deadline <= now) {
+        return 0;
+    }
+    // Round up, otherwise we would wake up slightly before the deadline and spin
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now + std::chrono::microseconds(999));
+    return static_cast<int>(ms.count());
+}
+
+void CurlMultiReactor::abortTransfers()
+{
+    std::map<CURL*, CompletionCallback> transfers;
+    transfers.swap(transfers_);
+    for (auto& it : transfers) {
+        curl_multi_remove_handle(multi_, it.first);
+    }
+    // Callbacks may own the easy handles, so they are run only after the handles were detached.
+    // Somebody may be waiting for the result
+    for (auto& it : transfers) {
+        if (it.second) {
+            it.second(CURLE_ABORTED_BY_CALLBACK);
+        }
+    }
+}
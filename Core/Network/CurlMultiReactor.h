@@ -0,0 +1,111 @@
+#ifndef IU_CORE_NETWORK_CURLMULTIREACTOR_H
+#define IU_CORE_NETWORK_CURLMULTIREACTOR_H
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <curl/curl.h>
+#include "Core/Utils/CoreTypes.h"
+
+/**
+ * Single-threaded event loop built on top of curl_multi.
+ *
+ * Drives any number of easy handles from one thread, and also runs posted tasks and timers
+ * on that same thread, so that users of the reactor can keep their state single-threaded.
+ *
+ * post(), invoke(), scheduleAt() and cancelTimer() are thread-safe.
+ * addTransfer() and removeTransfer() must be called on the reactor thread
+ * (from a task, a timer or a completion callback).
+ */
+class CurlMultiReactor {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = std::function<void()>;
+    using CompletionCallback = std::function<void(CURLcode)>;
+    using TimerId = uint64_t;
+
+    CurlMultiReactor();
+    ~CurlMultiReactor();
+
+    void start();
+
+    /**
+     * Stops the event loop. Transfers which are still in flight (e.g. logout requests)
+     * are given at most drainTimeout to complete, after that they are aborted.
+     */
+    void stop(std::chrono::milliseconds drainTimeout = std::chrono::milliseconds(500));
+
+    /**
+     * Same as stop(), but returns at once: the event loop is stopped, and the reactor destroyed,
+     * by a new detached thread, which calls onStopped last. Keeps a UI thread from waiting for the drain.
+     */
+    static void stopDetached(std::unique_ptr<CurlMultiReactor> reactor, Task onStopped,
+        std::chrono::milliseconds drainTimeout = std::chrono::milliseconds(500));
+
+    /**
+     * Queues task for the reactor thread. Returns false if the event loop is not running,
+     * in that case the task is dropped.
+     */
+    bool post(Task task);
+
+    /**
+     * Runs task on the reactor thread and waits for it to finish.
+     * If called from the reactor thread, the task is executed immediately.
+     */
+    void invoke(const Task& task);
+
+    TimerId scheduleAt(Clock::time_point when, Task task);
+    void cancelTimer(TimerId id);
+
+    /**
+     * Starts driving a prepared easy handle. The callback is invoked on the reactor thread
+     * once the transfer is finished, or with CURLE_ABORTED_BY_CALLBACK if it is aborted by stop().
+     * It is not invoked for a transfer removed by removeTransfer().
+     * Returns false if the handle could not be added.
+     */
+    bool addTransfer(CURL* handle, CompletionCallback callback);
+    void removeTransfer(CURL* handle);
+
+    bool isReactorThread() const;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CurlMultiReactor);
+
+    struct Timer {
+        TimerId id;
+        Task task;
+    };
+
+    bool enqueue(Task task);
+    void run();
+    void runPendingTasks();
+    void runDueTimers();
+    void processMessages();
+    int calcPollTimeout();
+    void abortTransfers();
+
+    CURLM* multi_;
+    std::thread thread_;
+    std::atomic<std::thread::id> threadId_;
+    std::atomic_bool stopSignal_{ false };
+    Clock::time_point drainDeadline_;
+
+    std::mutex mutex_;
+    std::vector<Task> tasks_;
+    std::multimap<Clock::time_point, Timer> timers_;
+    TimerId nextTimerId_ = 1;
+    bool exited_ = true;
+
+    // Accessed only from the reactor thread
+    std::map<CURL*, CompletionCallback> transfers_;
+};
+
+#endif
@@ -13,6 +13,7 @@
 #include "Core/Utils/CoreUtils.h"
 #include "Core/Utils/StringUtils.h"
 #include "CurlShare.h"
+#include "CurlMultiReactor.h"
 
 #ifdef USE_OPENSSL
 #include <openssl/ssl.h>
@@ -36,6 +37,19 @@ size_t simple_read_callback(void *ptr, size_t size, size_t nmemb, void *stream)
     return  fread(ptr, size, nmemb, static_cast<FILE*>(stream));
 }
 
+// Header names are ASCII, so locale-independent case folding is enough
+char asciiLower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool headerNameLess(std::string_view a, std::string_view b)
+{
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+        return asciiLower(x) < asciiLower(y);
+    });
+}
+
 #if defined(USE_OPENSSL) 
 char CertFileName[1024] = "";
 
@@ -150,19 +164,28 @@ void NetworkClient::clearProxy() {
 
 int NetworkClient::private_writer(char *data, size_t size, size_t nmemb)
 {
-    if(!m_OutFileName.empty())
-    {
-        if(!m_hOutFile)
-            if ((m_hOutFile = IuCoreUtils::fopen_utf8(m_OutFileName.c_str(), "wb")) == nullptr) {
+    size_t length = size * nmemb;
+    if (!activeSink_) {
+        if (!bodySink_ && !m_OutFileName.empty()) {
+            bodySink_ = std::make_shared<FileBodySink>(m_OutFileName);
+        }
+        activeSink_ = bodySink_ ? bodySink_.get() : &bodyBuffer_;
+        curl_off_t contentLength = -1;
+        curl_easy_getinfo(curl_handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength);
+        // A failed sink aborts the transfer with CURLE_WRITE_ERROR
+        if (!activeSink_->begin(contentLength)) {
+            return 0;
+        }
+    }
+    return activeSink_->write(data, length) ? static_cast<int>(length) : 0;
+}
 
-                throw NetworkClient::AbortedException("Unable to create output file");
-            }
-               
-        fwrite(data, size,nmemb, m_hOutFile);
+void NetworkClient::private_end_body()
+{
+    if (activeSink_) {
+        activeSink_->end();
+        activeSink_ = nullptr;
     }
-    else
-        internalBuffer.append(data, size * nmemb);
-    return size * nmemb;
 }
 
 int NetworkClient::private_header_writer(char *data, size_t size, size_t nmemb)
@@ -199,12 +222,15 @@ NetworkClient::NetworkClient()
 {
     curl_init();
     enableResponseCodeChecking_ = true;
-    m_hOutFile = nullptr;
+    activeSink_ = nullptr;
+    responseHeadersParsed_ = false;
+    asyncRequestId_ = 0;
     chunkOffset_ = -1;
     chunkSize_ = -1;
     m_uploadingFileReadBytes = 0;
     chunk_ = nullptr;
     curlShare_ = nullptr;
+    reactor_ = nullptr;
     m_CurrentFileSize = -1;
     m_uploadingFile = nullptr;
     *m_errorBuffer = 0;
@@ -297,6 +323,7 @@ void NetworkClient::addQueryParamFile(const std::string& name, const std::string
 
 void NetworkClient::setUrl(const std::string& url)
 {
+    pinnedRequest_ = nullptr;
     m_url = url;
     curl_easy_setopt(curl_handle, CURLOPT_URL, url.c_str());
 }
@@ -392,7 +419,7 @@ bool NetworkClient::doUploadMultipartData()
 
     curl_easy_setopt(curl_handle, CURLOPT_HTTPPOST, formpost);
     m_currentActionType = ActionType::atUpload;
-    curl_result = curl_easy_perform(curl_handle);
+    private_perform();
     closeFileList(openedFiles);
     curl_formfree(formpost);
     return private_on_finish_request();
@@ -400,9 +427,9 @@ bool NetworkClient::doUploadMultipartData()
 
 bool NetworkClient::private_on_finish_request()
 {
+    private_end_body();
     private_checkResponse();
     private_cleanup_after();
-    private_parse_headers();
     if (curl_result != CURLE_OK)
     {
         if (curl_result == CURLE_ABORTED_BY_CALLBACK) {
@@ -416,7 +443,22 @@ bool NetworkClient::private_on_finish_request()
 
 std::string NetworkClient::responseBody()
 {
-    return internalBuffer;
+    return bodyBuffer_.data();
+}
+
+std::string_view NetworkClient::responseBodyView() const
+{
+    return bodyBuffer_.data();
+}
+
+std::string NetworkClient::takeResponseBody()
+{
+    return bodyBuffer_.take();
+}
+
+void NetworkClient::setBodySink(std::shared_ptr<BodySink> sink)
+{
+    bodySink_ = std::move(sink);
 }
 
 int NetworkClient::responseCode()
@@ -432,6 +474,228 @@ void NetworkClient::addQueryHeader(const std::string& name, const std::string& v
 }
 
 bool NetworkClient::doGet(const std::string & url)
+{
+    private_prepareGet(url);
+    private_perform();
+    return private_on_finish_request();
+
+}
+
+bool NetworkClient::doPost(const std::string& data)
+{
+    private_preparePost(data);
+    private_perform();
+    return private_on_finish_request();
+}
+
+void NetworkClient::prepareGet(const std::string &url)
+{
+    private_prepareGet(url);
+}
+
+void NetworkClient::preparePost(const std::string& data)
+{
+    // The body must stay alive until the transfer is finished
+    m_postData = data;
+    private_preparePost(m_postData);
+}
+
+NetworkClient::PreparedRequest::PreparedRequest(std::string url, std::string method,
+    const std::vector<std::pair<std::string, std::string>>& headers, std::string body) :
+    url_(std::move(url)), method_(std::move(method)), body_(std::move(body)), headers_(nullptr)
+{
+    bool expect = false;
+    for (const auto& header : headers) {
+        if (header.second == "\n") {
+            headers_ = curl_slist_append(headers_, (header.first + ";").c_str());
+        } else {
+            headers_ = curl_slist_append(headers_, (header.first + ": " + header.second).c_str());
+        }
+        expect = expect || header.first == "Expect";
+    }
+    // Like other requests, do not wait for "100 Continue"
+    if (!expect) {
+        headers_ = curl_slist_append(headers_, "Expect: ");
+    }
+}
+
+NetworkClient::PreparedRequest::~PreparedRequest()
+{
+    curl_slist_free_all(headers_);
+}
+
+const std::string& NetworkClient::PreparedRequest::url() const
+{
+    return url_;
+}
+
+const std::string& NetworkClient::PreparedRequest::body() const
+{
+    return body_;
+}
+
+void NetworkClient::prepareRequest(std::shared_ptr<const PreparedRequest> request)
+{
+    private_reset_headers();
+    bodyBuffer_.clear();
+    m_currentActionType = request->method_ == "GET" ? ActionType::atGet : ActionType::atPost;
+    if (pinnedRequest_ == request) {
+        // All options are still set on the handle
+        return;
+    }
+
+    // The request carries its own headers
+    m_QueryHeaders.clear();
+    m_url = request->url_;
+    private_initTransfer();
+    curl_slist_free_all(chunk_);
+    chunk_ = nullptr;
+
+    curl_easy_setopt(curl_handle, CURLOPT_URL, m_url.c_str());
+    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, request->headers_);
+    curl_easy_setopt(curl_handle, CURLOPT_CUSTOMREQUEST, NULL);
+    curl_easy_setopt(curl_handle, CURLOPT_UPLOAD, 0L);
+    if (m_currentActionType == ActionType::atGet) {
+        curl_easy_setopt(curl_handle, CURLOPT_HTTPGET, 1L);
+    } else {
+        curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, request->body_.data());
+        curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, static_cast<long>(request->body_.size()));
+        if (!request->method_.empty() && request->method_ != "POST") {
+            curl_easy_setopt(curl_handle, CURLOPT_CUSTOMREQUEST, request->method_.c_str());
+        }
+    }
+    pinnedRequest_ = std::move(request);
+}
+
+bool NetworkClient::doRequest(std::shared_ptr<const PreparedRequest> request)
+{
+    prepareRequest(std::move(request));
+    private_perform();
+    return private_on_finish_request();
+}
+
+bool NetworkClient::completeRequest(CURLcode result)
+{
+    curl_result = result;
+    return private_on_finish_request();
+}
+
+void NetworkClient::setReactor(CurlMultiReactor* reactor)
+{
+    reactor_ = reactor;
+}
+
+void NetworkClient::performAsync(RequestCallback callback)
+{
+    private_startAsync([this, callback = std::move(callback)](CURLcode result, bool cancelled) {
+        bool success = false;
+        try {
+            success = completeRequest(result);
+        } catch (const AbortedException&) {
+        }
+        if (callback && !cancelled) {
+            callback(success);
+        }
+    });
+}
+
+std::future<bool> NetworkClient::performAsync()
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> future = promise->get_future();
+
+    private_startAsync([this, promise](CURLcode result, bool) {
+        try {
+            promise->set_value(completeRequest(result));
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return future;
+}
+
+std::future<bool> NetworkClient::doGetAsync(const std::string& url)
+{
+    prepareGet(url);
+    return performAsync();
+}
+
+std::future<bool> NetworkClient::doPostAsync(const std::string& data)
+{
+    preparePost(data);
+    return performAsync();
+}
+
+std::future<bool> NetworkClient::doRequestAsync(std::shared_ptr<const PreparedRequest> request)
+{
+    prepareRequest(std::move(request));
+    return performAsync();
+}
+
+void NetworkClient::cancelAsync()
+{
+    if (!asyncCompletion_) {
+        return;
+    }
+    reactor_->removeTransfer(curl_handle);
+    private_finishAsync(CURLE_ABORTED_BY_CALLBACK, true);
+}
+
+bool NetworkClient::asyncRequestInProgress() const
+{
+    return static_cast<bool>(asyncCompletion_);
+}
+
+void NetworkClient::private_startAsync(std::function<void(CURLcode, bool)> completion)
+{
+    // No request is in flight, so the reactor thread does not touch the client yet
+    asyncCompletion_ = std::move(completion);
+    uint64_t id = ++asyncRequestId_;
+
+    if (!reactor_) {
+        private_finishAsync(CURLE_FAILED_INIT, false);
+        return;
+    }
+    auto start = [this, id] {
+        // The request was cancelled before it was started
+        if (id != asyncRequestId_ || !asyncCompletion_) {
+            return;
+        }
+        if (!reactor_->addTransfer(curl_handle, [this](CURLcode result) { private_finishAsync(result, false); })) {
+            private_finishAsync(CURLE_FAILED_INIT, false);
+        }
+    };
+    if (reactor_->isReactorThread()) {
+        start();
+    } else if (!reactor_->post(start)) {
+        private_finishAsync(CURLE_FAILED_INIT, false);
+    }
+}
+
+void NetworkClient::private_finishAsync(CURLcode result, bool cancelled)
+{
+    auto completion = std::move(asyncCompletion_);
+    asyncCompletion_ = nullptr;
+    // The client may be reused, or destroyed, as soon as the completion has reported the result
+    completion(result, cancelled);
+}
+
+void NetworkClient::private_perform()
+{
+    if (reactor_ && !reactor_->isReactorThread()) {
+        std::promise<CURLcode> done;
+        std::future<CURLcode> future = done.get_future();
+        private_startAsync([&done](CURLcode result, bool) {
+            done.set_value(result);
+        });
+        curl_result = future.get();
+        return;
+    }
+    curl_result = curl_easy_perform(curl_handle);
+}
+
+void NetworkClient::private_prepareGet(const std::string& url)
 {
     if(!url.empty())
         setUrl(url);
@@ -440,18 +704,17 @@ bool NetworkClient::doGet(const std::string & url)
     if(!private_apply_method())
         curl_easy_setopt(curl_handle, CURLOPT_HTTPGET, 1);
     m_currentActionType = ActionType::atGet;
-    curl_result = curl_easy_perform(curl_handle);
-    return private_on_finish_request();
-
 }
 
-bool NetworkClient::doPost(const std::string& data)
+void NetworkClient::private_preparePost(const std::string& data)
 {
     private_initTransfer();
     if(!private_apply_method())
    curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
-    std::string postData;
-    std::vector<QueryParam>::iterator it, end = m_QueryParams.end();
+
+    if(data.empty()) {
+        std::string postData;
+        std::vector<QueryParam>::iterator it, end = m_QueryParams.end();
 
         for(it=m_QueryParams.begin(); it!=end; ++it)
         {
@@ -460,19 +723,16 @@ bool NetworkClient::doPost(const std::string& data)
                 postData+= urlEncode(it->name)+"="+urlEncode(it->value)+"&";
             }
         }
-
-    if(data.empty()) {
-        curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, postData.data());
-        curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, (long)postData.length());
+        m_postData = std::move(postData);
+        curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, m_postData.data());
+        curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, (long)m_postData.length());
     }
     else {
         curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, (const char*)data.data());
         curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, (long)data.length());
     }
 
-    m_currentActionType = ActionType::atPost;    
-    curl_result = curl_easy_perform(curl_handle);
-    return private_on_finish_request();
+    m_currentActionType = ActionType::atPost;
 }
 
 std::string NetworkClient::urlEncode(const std::string& str)
@@ -504,6 +764,8 @@ void NetworkClient::setUserAgent(const std::string& userAgentStr)
  
 void NetworkClient::private_initTransfer()
 {
+    // Options of another request replace those of the pinned one
+    pinnedRequest_ = nullptr;
     private_cleanup_before();
     curl_easy_setopt(curl_handle, CURLOPT_USERAGENT, m_userAgent.c_str());
 
@@ -550,7 +812,7 @@ void NetworkClient::private_checkResponse()
         if (!errDescr.empty()) {
             errorDescr += errDescr  + "\r\n";
         }
-        errorDescr += internalBuffer;
+        errorDescr += bodyBuffer_.data();
         if (logger_) {
             logger_->logNetworkError(!treatErrorsAsWarnings_, errorDescr);
         }
@@ -606,42 +868,78 @@ void NetworkClient::setProgressCallback(const ProgressCallback& func)
 
 void NetworkClient::private_parse_headers()
 {
-    auto headers = IuStringUtils::SplitSV(m_headerBuffer, "\n");
-
-    for (const auto &it: headers) {
-        auto parts = IuStringUtils::SplitSV(it, ":", 2);
-
-        if (parts.size() == 2) {
-            std::string name(IuStringUtils::TrimSV(parts[0]));
-            std::string value(IuStringUtils::TrimSV(parts[1]));
-            m_ResponseHeaders.emplace_back(name, value);
+    if (responseHeadersParsed_) {
+        return;
+    }
+    responseHeadersParsed_ = true;
+    std::string_view text = m_headerBuffer;
+
+    while (!text.empty()) {
+        size_t lineEnd = text.find('\n');
+        std::string_view line = text.substr(0, lineEnd);
+        text = lineEnd == std::string_view::npos ? std::string_view() : text.substr(lineEnd + 1);
+
+        // The buffer holds every response of a redirected transfer, only the last one is kept
+        if (line.substr(0, 5) == "HTTP/") {
+            responseHeaders_.clear();
+            continue;
+        }
+        size_t colon = line.find(':');
+        if (colon != std::string_view::npos) {
+            std::string_view name = IuStringUtils::TrimSV(line.substr(0, colon));
+            std::string_view value = IuStringUtils::TrimSV(line.substr(colon + 1));
+            responseHeaders_.push_back({ name, value });
         }
     }
+
+    responseHeaderIndex_.resize(responseHeaders_.size());
+    for (size_t i = 0; i < responseHeaderIndex_.size(); i++) {
+        responseHeaderIndex_[i] = i;
+    }
+    // Stable, so that a repeated header resolves to its first occurrence
+    std::stable_sort(responseHeaderIndex_.begin(), responseHeaderIndex_.end(), [this](size_t a, size_t b) {
+        return NetworkClientInternal::headerNameLess(responseHeaders_[a].name, responseHeaders_[b].name);
+    });
+}
+
+void NetworkClient::private_reset_headers()
+{
+    // Keeps the capacity, the next response has about the same headers
+    m_headerBuffer.clear();
+    responseHeaders_.clear();
+    responseHeaderIndex_.clear();
+    responseHeadersParsed_ = false;
 }
 
 std::string NetworkClient::responseHeaderByName(const std::string& name)
 {
-    std::vector<CustomHeaderItem>::iterator it, end = m_ResponseHeaders.end();
-    
-    for(it = m_ResponseHeaders.begin(); it!=end; ++it)
-    {
-        if(it->name == name)
-            return it->value;
-    }
-    return std::string();
+    return std::string(responseHeaderView(name));
+}
 
+std::string_view NetworkClient::responseHeaderView(std::string_view name)
+{
+    private_parse_headers();
+    auto it = std::lower_bound(responseHeaderIndex_.begin(), responseHeaderIndex_.end(), name, [this](size_t index, std::string_view key) {
+        return NetworkClientInternal::headerNameLess(responseHeaders_[index].name, key);
+    });
+    if (it == responseHeaderIndex_.end() || NetworkClientInternal::headerNameLess(name, responseHeaders_[*it].name)) {
+        return std::string_view();
+    }
+    return responseHeaders_[*it].value;
 }
 
 int NetworkClient::responseHeaderCount()
 {
-    return m_ResponseHeaders.size();
+    private_parse_headers();
+    return static_cast<int>(responseHeaders_.size());
 }
 
 std::string NetworkClient::responseHeaderByIndex(int index, std::string& name)
 {
-    if (index >= 0 && static_cast<size_t>(index) < m_ResponseHeaders.size()) {
-        name = m_ResponseHeaders[index].name;
-        return m_ResponseHeaders[index].value;
+    private_parse_headers();
+    if (index >= 0 && static_cast<size_t>(index) < responseHeaders_.size()) {
+        name = responseHeaders_[index].name;
+        return std::string(responseHeaders_[index].value);
     }
     return std::string();
 }
@@ -656,9 +954,8 @@ void NetworkClient::private_cleanup_before()
         if(it->name == "Expect" ) { add = false; break; }
     }
     addQueryHeader("Expect", "");
-    m_ResponseHeaders.clear();
-    internalBuffer.clear();
-    m_headerBuffer.clear();
+    private_reset_headers();
+    bodyBuffer_.clear();
 }
 
 void NetworkClient::private_cleanup_after()
@@ -666,16 +963,13 @@ void NetworkClient::private_cleanup_after()
     m_currentActionType = ActionType::atNone;
     m_QueryHeaders.clear();
     m_QueryParams.clear();
-    if(m_hOutFile)
-    {
-        fclose(m_hOutFile);
-        m_hOutFile = nullptr;
-    }
     m_OutFileName.clear();
+    bodySink_ = nullptr;
     m_method.clear();
     curl_easy_setopt(curl_handle, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(-1));
 
     m_uploadData.clear();
+    m_postData.clear();
     m_uploadingFile = nullptr;
     chunkOffset_ = -1;
     chunkSize_ = -1;
@@ -804,7 +1098,7 @@ bool NetworkClient::doUpload(const std::string& fileName, const std::string &dat
 
     curl_easy_setopt(curl_handle, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(m_currentUploadDataSize));
     
-    curl_result = curl_easy_perform(curl_handle);
+    private_perform();
     if(m_uploadingFile)
          fclose(m_uploadingFile);
     bool res = private_on_finish_request();
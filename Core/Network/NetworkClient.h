@@ -22,17 +22,22 @@
 #define IU_CORE_NETWORK_NETWORK_CLIENT_H
 
 
+#include <functional>
+#include <future>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 
 #include <curl/curl.h>
+#include "BodySink.h"
 #include "INetworkClient.h"
 #include "Core/Utils/CoreUtils.h"
 #include "Core/Utils/CoreTypes.h"
 
 class CurlShare;
+class CurlMultiReactor;
 
 /**
 @brief  HTTP/FTP client (libcurl wrapper).
@@ -54,6 +59,35 @@ class NetworkClient: public INetworkClient
         
         /*! @endcond */
 
+        /**
+         * Request which is sent repeatedly without changes, e.g. polling. URL, method, headers and body
+         * are converted to curl's form once, on construction. Immutable, may be shared between clients.
+         */
+        class PreparedRequest {
+            public:
+                /**
+                 * @param method - "GET", "POST" or a custom method, the body is sent with any method except GET.
+                 * @param headers - name and value pairs, see addQueryHeader().
+                 */
+                PreparedRequest(std::string url, std::string method,
+                    const std::vector<std::pair<std::string, std::string>>& headers, std::string body);
+                ~PreparedRequest();
+
+                PreparedRequest(const PreparedRequest&) = delete;
+                PreparedRequest& operator=(const PreparedRequest&) = delete;
+
+                const std::string& url() const;
+                const std::string& body() const;
+
+            private:
+                friend class NetworkClient;
+
+                std::string url_;
+                std::string method_;
+                std::string body_;
+                struct curl_slist* headers_;
+        };
+
         NetworkClient();
         ~NetworkClient() override;
 
@@ -125,8 +159,97 @@ class NetworkClient: public INetworkClient
         @include networkclient_get_file.nut
         */
         bool doGet(const std::string &url) override;
+
+        /**
+         * Prepares a GET request without performing it, so the transfer can be driven 
+         * by a curl multi handle (see CurlMultiReactor). 
+         * completeRequest() must be called when the transfer is finished.
+         */
+        void prepareGet(const std::string &url);
+
+        /**
+         * Prepares a POST request without performing it. The request body is copied.
+         * completeRequest() must be called when the transfer is finished.
+         */
+        void preparePost(const std::string& data);
+
+        /**
+         * Prepares a prepared request without performing it. The first time, the request is pinned to the
+         * easy handle; as long as no other request is made with this client, repeating it only resets
+         * the response. The client holds a reference to the request while it is pinned.
+         * completeRequest() must be called when the transfer is finished.
+         */
+        void prepareRequest(std::shared_ptr<const PreparedRequest> request);
+
+        /**
+         * Performs a prepared request, see prepareRequest().
+         */
+        bool doRequest(std::shared_ptr<const PreparedRequest> request);
+
+        /**
+         * Finishes a request started by prepareGet()/preparePost()/prepareRequest().
+         * @param result - the result code reported by curl_multi for this transfer.
+         */
+        bool completeRequest(CURLcode result);
+
+        /**
+         * Called on the reactor thread when an asynchronous request is finished,
+         * with the result of completeRequest(). An aborted request is reported as a failure.
+         */
+        using RequestCallback = std::function<void(bool success)>;
+
+        /**
+         * Drives the transfers of this client by a reactor shared with other clients, which is
+         * required by the asynchronous methods. The blocking methods, when called from any other thread
+         * than the reactor's, are then performed on the reactor as well and wait for the result.
+         * The reactor is not owned by the client and must outlive its transfers.
+         */
+        void setReactor(CurlMultiReactor* reactor);
+
+        /**
+         * Starts the request prepared by prepareGet()/preparePost()/prepareRequest() on the reactor and returns
+         * immediately. May be called from any thread; the client must not be used, nor destroyed, until the request
+         * is finished, except for reading the response from the callback.
+         */
+        void performAsync(RequestCallback callback);
+
+        /**
+         * Same as performAsync(RequestCallback), the future receives the result, or AbortedException.
+         * Must not be waited for on the reactor thread.
+         */
+        std::future<bool> performAsync();
+
+        std::future<bool> doGetAsync(const std::string& url);
+        std::future<bool> doPostAsync(const std::string& data);
+        std::future<bool> doRequestAsync(std::shared_ptr<const PreparedRequest> request);
+
+        /**
+         * Aborts the asynchronous request in flight, if any. Must be called on the reactor thread.
+         * The callback is not invoked, a future receives AbortedException.
+         */
+        void cancelAsync();
+
+        bool asyncRequestInProgress() const;
+
         std::string responseBody() override;
 
+        /**
+         * Returns the response body without copying it. Valid until the next request or takeResponseBody().
+         */
+        std::string_view responseBodyView() const;
+
+        /**
+         * Moves the response body out of the client. The next response is received into a new buffer,
+         * otherwise the buffer is reused by the following requests.
+         */
+        std::string takeResponseBody();
+
+        /**
+         * Passes the body of the next response to the sink as it arrives, instead of keeping it
+         * for responseBody(). Like other request options, the sink is reset after the request.
+         */
+        void setBodySink(std::shared_ptr<BodySink> sink);
+
         /**
          * Returns the response code (for example, 200 means HTTP OK).
          */
@@ -142,7 +265,16 @@ class NetworkClient: public INetworkClient
          * Returns all response headers
          */
         std::string responseHeaderText() override;
+        /**
+         * Returns the value of the first response header with this name, compared case-insensitively.
+         * Headers are parsed on the first access after a request. After a redirect only the headers of the final
+         * response are looked up, responseHeaderText() returns those of all the responses.
+         */
         std::string responseHeaderByName(const std::string& name) override;
+        /**
+         * Same as responseHeaderByName(), without copying. The view is valid until the next request.
+         */
+        std::string_view responseHeaderView(std::string_view name);
         std::string responseHeaderByIndex(int index, std::string& name) override;
 
         /**
@@ -192,6 +324,9 @@ class NetworkClient: public INetworkClient
         void clearProxy() override;
         /*! @endcond */
         void setReferer(const std::string &str) override;
+        /**
+         * Writes the body of the next response to the file, see FileBodySink.
+         */
         void setOutputFile(const std::string &str) override;
         /*! @cond PRIVATE */
         void setUploadBufferSize(int size) override;
@@ -249,6 +384,13 @@ class NetworkClient: public INetworkClient
             }
         };
 
+        struct ResponseHeader
+        {
+            // Point into m_headerBuffer
+            std::string_view name;
+            std::string_view value;
+        };
+
         struct QueryParam
         {
             bool isFile;
@@ -267,12 +409,19 @@ class NetworkClient: public INetworkClient
         static int private_seek_callback(void *userp, curl_off_t offset, int origin);
         static int set_sockopts(void * clientp, curl_socket_t sockfd, curlsocktype purpose);
         bool private_apply_method();
+        void private_prepareGet(const std::string& url);
+        void private_preparePost(const std::string& data);
         void private_parse_headers();
+        void private_reset_headers();
+        void private_end_body();
         void private_cleanup_before();
         void private_cleanup_after();
         bool private_on_finish_request();
         void private_initTransfer();
         void private_checkResponse();
+        void private_perform();
+        void private_startAsync(std::function<void(CURLcode, bool)> completion);
+        void private_finishAsync(CURLcode result, bool cancelled);
         public:
         /*! @cond PRIVATE */
         static void curl_init();
@@ -283,11 +432,13 @@ class NetworkClient: public INetworkClient
 
         int m_UploadBufferSize;
         CURL *curl_handle;
-        FILE *m_hOutFile;
         std::string m_OutFileName;
         FILE *m_uploadingFile;
         int64_t m_uploadingFileReadBytes;
         std::string m_uploadData;
+        std::string m_postData;
+        // Request whose options are currently set on the easy handle
+        std::shared_ptr<const PreparedRequest> pinnedRequest_;
         ActionType m_currentActionType;
         int m_nUploadDataOffset;
         CallBackData m_bodyFuncData;
@@ -299,8 +450,16 @@ class NetworkClient: public INetworkClient
         int64_t m_currentUploadDataSize;
         std::vector<QueryParam> m_QueryParams;
         std::vector<CustomHeaderItem> m_QueryHeaders;
-        std::vector<CustomHeaderItem> m_ResponseHeaders;
-        std::string internalBuffer;
+        // Parsed from m_headerBuffer on first access, in the order received
+        std::vector<ResponseHeader> responseHeaders_;
+        // Positions in responseHeaders_ ordered by name, case-insensitively
+        std::vector<size_t> responseHeaderIndex_;
+        bool responseHeadersParsed_;
+        // Built-in sink of the response body, unless another one is set
+        MemoryBodySink bodyBuffer_;
+        std::shared_ptr<BodySink> bodySink_;
+        // Sink receiving the current response, null until its first chunk
+        BodySink* activeSink_;
         std::string m_headerBuffer;
         std::string m_userAgent;
         std::string errorLogIdString_;
@@ -312,6 +471,10 @@ class NetworkClient: public INetworkClient
         int64_t chunkSize_;
         bool treatErrorsAsWarnings_;
         CurlShare* curlShare_;
+        CurlMultiReactor* reactor_;
+        // Completion of the asynchronous request in flight, reactor thread only
+        std::function<void(CURLcode result, bool cancelled)> asyncCompletion_;
+        uint64_t asyncRequestId_;
         std::shared_ptr<ProxyProvider> proxyProvider_;
         Logger* logger_;
         static std::mutex _mutex;
@@ -1,400 +1,233 @@
 #include <Windows.h>
 
-#include <sstream>
-#include <thread>
+#include <algorithm>
+#include <cwchar>
+#include <functional>
 #include <map>
+#include <memory>
+#include <string>
+#include <vector>
 
-#include <json/json.h>
-#include <json/value.h>
-#include "Core/Network/NetworkClient.h"
 #include "API/RainmeterAPI.h"
-#include "Core/Utils/CryptoUtils.h"
-#include "Core/Utils/StringUtils.h"
-
-double GetPrivateProfileDouble(LPCTSTR section, LPCTSTR key, double def, LPCTSTR path)
-{
-    TCHAR buf[100] {'\0'};
-    ::GetPrivateProfileString(section, key, L"NOTFOUND", buf, std::size(buf), path);
-
-    if (::wcscmp(buf, L"NOTFOUND") == 0 || ::wcscmp(buf, L"") == 0) {
-        return def;
-    }
-    return ::_wtof(buf);
-}
+#include "Core/Network/CurlMultiReactor.h"
+#include "Core/Utils/CoreUtils.h"
+#include "Plugin/Settings.h"
+#include "Plugin/Worker.h"
 
 enum class MeasureType
 {
     mtDownload,
-    mtUpload
+    mtUpload,
+    mtPollJitter,
+    mtMissedPolls,
+    mtSampleAge,
+    mtAggregate,
+    mtHistory,
+    mtPercentile
 };
 
-class Worker;
-
-struct Settings{
-    std::string routerUrl;
-    std::string login;
-    std::string password;
-    std::string proxy;
-    std::string command;
-    std::string requestType;
-    std::string downloadFieldJsonPath;
-    std::string uploadFieldJsonPath;
-    double downloadDivider{};
-    double uploadDivider{};
-
-    std::vector<std::string> interfaces;
-    int proxyPort = 0;
-};
+MeasureType parseMeasureType(const std::wstring& val) {
+    if (val == L"upload") {
+        return MeasureType::mtUpload;
+    } else if (val == L"jitter") {
+        return MeasureType::mtPollJitter;
+    } else if (val == L"missedpolls") {
+        return MeasureType::mtMissedPolls;
+    } else if (val == L"age") {
+        return MeasureType::mtSampleAge;
+    } else if (val == L"history") {
+        return MeasureType::mtHistory;
+    }
+    return MeasureType::mtDownload;
+}
 
-class SettingsLoader
-{
-public:
-    static std::unique_ptr<Settings> loadSettings(void* rm, LPCWSTR routerID, LPCTSTR configFile) {
-        WCHAR loginW[256]{};
-        WCHAR passwordW[256]{};
-        WCHAR urlW[256]{};
-        WCHAR proxyW[256]{};
-        WCHAR interfaceW[1024]{};
-        WCHAR commandW[256] {};
-        WCHAR requestTypeW[50] {};
-        WCHAR downloadFieldW[256] {};
-        WCHAR uploadFieldW[256] {};
-
-
-        GetPrivateProfileString(routerID, L"URL", L"http://192.168.1.1", urlW, std::size(urlW), configFile);
-        GetPrivateProfileString(routerID, L"Login", L"admin", loginW, std::size(loginW), configFile);
-        GetPrivateProfileString(routerID, L"Password", L"", passwordW, std::size(passwordW), configFile);
-        GetPrivateProfileString(routerID, L"Proxy", L"", proxyW, std::size(proxyW), configFile);
-        GetPrivateProfileString(routerID, L"Interface", L"ISP", interfaceW, std::size(interfaceW), configFile);
-        GetPrivateProfileString(routerID, L"Command", L"", commandW, std::size(commandW), configFile);
-        GetPrivateProfileString(routerID, L"RequestType", L"", requestTypeW, std::size(requestTypeW), configFile);
-        GetPrivateProfileString(routerID, L"DownloadField", L"", downloadFieldW, std::size(downloadFieldW), configFile);
-        GetPrivateProfileString(routerID, L"UploadField", L"", uploadFieldW, std::size(uploadFieldW), configFile);
-        
-
-        if (!lstrlen(passwordW)) {
-            RmLog(rm, LOG_ERROR, (std::wstring(L"No password set for ") + routerID + std::wstring(L" in config file ") + configFile).c_str());
-            return {};
+// Types like "avg5m", "peak1h" or "min1m"
+bool parseAggregateType(const std::wstring& val, AggregateType& type, AggregateWindow& window) {
+    static const std::pair<const wchar_t*, AggregateType> types[] = {
+        { L"avg", AggregateType::Average }, { L"peak", AggregateType::Peak }, { L"min", AggregateType::Minimum }
+    };
+    static const std::pair<const wchar_t*, AggregateWindow> windows[] = {
+        { L"1m", AggregateWindow::OneMinute }, { L"5m", AggregateWindow::FiveMinutes }, { L"1h", AggregateWindow::OneHour }
+    };
+    for (const auto& t : types) {
+        for (const auto& w : windows) {
+            if (val == std::wstring(t.first) + w.first) {
+                type = t.second;
+                window = w.second;
+                return true;
+            }
         }
-
-        std::unique_ptr<Settings> res = std::make_unique<Settings>();
-        res->downloadDivider = GetPrivateProfileDouble(routerID, L"DownloadDivider", 1000000.0, configFile);
-        res->uploadDivider = GetPrivateProfileDouble(routerID, L"UploadDivider", 1000000.0, configFile);
-
-        res->proxyPort = GetPrivateProfileInt(routerID, L"ProxyPort", 8080, configFile);
-
-        res->routerUrl = IuCoreUtils::WstringToUtf8(urlW);
-        res->login = IuCoreUtils::WstringToUtf8(loginW);
-        res->password = IuCoreUtils::WstringToUtf8(passwordW);
-        res->proxy = IuCoreUtils::WstringToUtf8(proxyW);
-        res->command = IuCoreUtils::WstringToUtf8(commandW);
-        res->requestType = IuCoreUtils::WstringToUtf8(requestTypeW);
-        res->downloadFieldJsonPath = IuCoreUtils::WstringToUtf8(downloadFieldW);
-        res->uploadFieldJsonPath = IuCoreUtils::WstringToUtf8(uploadFieldW);
-        std::string interfaces = IuCoreUtils::WstringToUtf8(interfaceW);
-        IuStringUtils::Split(interfaces, ",", res->interfaces);
-        return res;
     }
-};
+    return false;
+}
 
-class Worker
-{
-public:
-    Worker(void *rm, std::shared_ptr<Settings> settings) {
-        stopSignal = false;
-        rm_ = rm;
-        settings_ = std::move(settings);
+// Types like "p95" or "p99.9"
+bool parsePercentile(const std::wstring& val, double& percentile) {
+    if (val.size() < 2 || val[0] != L'p') {
+        return false;
     }
-
-    ~Worker() {
-        try {
-            abort();
-        } catch(...) {
-            
-        }
+    wchar_t* end = nullptr;
+    double res = wcstod(val.c_str() + 1, &end);
+    if (*end || !(res > 0.0 && res <= 100.0)) {
+        return false;
     }
+    percentile = res;
+    return true;
+}
 
-    void start() {
-        if (started_) {
-            return;
+struct Measure {
+    MeasureType mt = MeasureType::mtDownload;
+    void* rm = nullptr;
+    std::wstring routerID;
+    std::string interf;
+    // Index of the interface in worker's speed table, resolved on Reload()
+    size_t slot = 0;
+    bool subscribed = false;
+    Direction direction = Direction::Download;
+    AggregateType aggregateType = AggregateType::Average;
+    AggregateWindow aggregateWindow = AggregateWindow::OneMinute;
+    double percentile = 95.0;
+    int64_t percentileWindow = 3600;
+    // Graph of the last historyRange seconds, recomputed when it shifts by a point
+    int64_t historyRange = 3600;
+    size_t historyPoints = 220;
+    ULONGLONG historyTime = 0;
+    double historyPeak = 0.0;
+    std::vector<PlotPoint> historyPlot;
+    std::wstring historyString;
+    // Results of section variable functions by call, e.g. "Average(300)", dropped on every Update()
+    std::map<std::wstring, std::wstring> functionResults;
+    std::shared_ptr<Worker> worker;
+
+    void unsubscribe() {
+        if (subscribed) {
+            worker->unsubscribe(slot);
+            subscribed = false;
         }
-        thread_ = std::thread(&Worker::run, this);
     }
+};
 
-    void run() {
-        nc_ = std::make_unique<NetworkClient>();
-        if (!settings_->proxy.empty() && settings_->proxyPort > 0) {
-            nc_->setProxy(settings_->proxy, settings_->proxyPort, CURLPROXY_HTTP);
-        }
+// Points of the graph as "x,y;x,y;...", x being seconds since the start of the range
+void updateHistoryPlot(Measure* measure) {
+    ULONGLONG now = GetTickCount64();
+    ULONGLONG refresh = std::max<ULONGLONG>(1000, measure->historyRange * 1000 / measure->historyPoints);
+    if (measure->historyTime && now - measure->historyTime < refresh) {
+        return;
+    }
+    measure->historyTime = now;
+    measure->worker->getHistoryPlot(measure->slot, measure->direction, measure->historyRange, measure->historyPoints,
+        measure->historyPlot);
+
+    measure->historyPeak = 0.0;
+    measure->historyString.clear();
+    wchar_t buf[64];
+    for (const PlotPoint& point : measure->historyPlot) {
+        swprintf(buf, std::size(buf), measure->historyString.empty() ? L"%.1f,%.6g" : L";%.1f,%.6g", point.x, point.y);
+        measure->historyString += buf;
+        measure->historyPeak = std::max(measure->historyPeak, point.y);
+    }
+}
 
-        nc_->setCurlOptionInt(CURLOPT_CONNECTTIMEOUT, 5);
+// Ranges of section variable functions, in seconds
+constexpr int64_t kMaxStatisticRange = 7 * 24 * 60 * 60;
+constexpr int64_t kMaxPercentileRange = 24 * 60 * 60;
 
-        while (!stopSignal) {
-            if (!authenticated) {
-                if (!authenticate()) {
-                    Sleep(1000);
-                    continue;
-                }
-            }
-            if (stopSignal) {
-                break;
-            }
-            loadData();
-            Sleep(1000);
-        }
-        logout();
-        std::unique_lock<std::mutex> lk(dataMutex_);
-        downloadSpeed_.clear();
-        uploadSpeed_.clear();
-        nc_ = nullptr;
+bool parseNumber(const WCHAR* arg, double& value) {
+    wchar_t* end = nullptr;
+    value = wcstod(arg, &end);
+    while (end != arg && iswspace(*end)) {
+        ++end;
     }
+    return end != arg && !*end;
+}
 
-    void abort() {
-        stopSignal = true;
-        if (thread_.joinable()) {
-            thread_.join();
-        }
+bool parseRange(const WCHAR* arg, int64_t maxRange, int64_t& seconds) {
+    double value = 0.0;
+    if (!parseNumber(arg, value) || !(value >= 1.0)) {
+        return false;
     }
+    seconds = static_cast<int64_t>(std::min(value, static_cast<double>(maxRange)));
+    return true;
+}
 
-    void setProxyPort(int port) {
-        proxyPort_ = port;
+/**
+ * Result of a section variable function, computed once per update of the measure,
+ * so any number of meters may ask the same question.
+ */
+LPCWSTR functionResult(Measure* measure, const wchar_t* name, const int argc, const WCHAR* argv[],
+    const std::function<double()>& compute) {
+    std::wstring call = name;
+    call += L'(';
+    for (int i = 0; i < argc; i++) {
+        call += i ? L"," : L"";
+        call += argv[i];
     }
+    call += L')';
 
-    double getUploadSpeed(const std::string& interf) const {
-        std::unique_lock<std::mutex> lk(dataMutex_);
-        if (!interf.empty()) {
-            auto it = uploadSpeed_.find(interf);
-            if (it != uploadSpeed_.end()) {
-                return it->second;
-            }
-            return 0.0;
-        }
-        return uploadSpeed_.empty() ? 0.0: uploadSpeed_.begin()->second;
+    auto it = measure->functionResults.find(call);
+    if (it == measure->functionResults.end()) {
+        wchar_t buf[64];
+        swprintf(buf, std::size(buf), L"%.6f", compute());
+        it = measure->functionResults.emplace(call, buf).first;
     }
+    return it->second.c_str();
+}
 
-    double getDownloadSpeed(const std::string& interf) const {
-        std::unique_lock<std::mutex> lk(dataMutex_);
-        if (!interf.empty()) {
-            auto it = downloadSpeed_.find(interf);
-            if (it != downloadSpeed_.end()) {
-                return it->second;
-            }
-            return 0.0;
-        }
-        return downloadSpeed_.empty() ? 0.0: downloadSpeed_.begin()->second;
+// [&Measure:Average(seconds)], [&Measure:Peak(seconds)], [&Measure:Minimum(seconds)]
+LPCWSTR statisticFunction(void* data, const wchar_t* name, AggregateType type, const int argc, const WCHAR* argv[]) {
+    auto* measure = static_cast<Measure*>(data);
+    int64_t seconds = 0;
+    if (argc != 1 || !parseRange(argv[0], kMaxStatisticRange, seconds)) {
+        RmLog(measure->rm, LOG_ERROR, (std::wstring(name) + L"() expects a number of seconds").c_str());
+        return nullptr;
     }
+    if (!measure->worker) {
+        return nullptr;
+    }
+    return functionResult(measure, name, argc, argv, [measure, type, seconds] {
+        return measure->worker->getStatistic(measure->slot, measure->direction, type, seconds);
+    });
+}
 
-private:
-    std::shared_ptr<Settings> settings_;
-    void* rm_;
-    bool started_ = false;
-    std::thread thread_;
-    std::unique_ptr<NetworkClient> nc_;
-    ULONGLONG lastAuthErrorTime_ = 0;
-    
-    int proxyPort_ = 0;
-    std::atomic_bool stopSignal = false;
-    mutable std::mutex dataMutex_;
-
-    std::map<std::string, std::atomic<double>> uploadSpeed_;
-    std::map<std::string, std::atomic<double>> downloadSpeed_;
-
-    bool authenticated = false;
-
-    bool authenticate() {
-        if (lastAuthErrorTime_ && (GetTickCount64() - lastAuthErrorTime_ < 10000)) {
-            return false;
-        }
-        nc_->doGet(settings_->routerUrl + "/auth");
-
-        std::string challenge = nc_->responseHeaderByName("X-NDM-Challenge");
-
-
-        std::string realm = nc_->responseHeaderByName("X-NDM-Realm");
-
-        if (challenge.empty() || realm.empty()) {
-            std::wstring msg = std::wstring(L"Failed to obtain realm token. Response code : ")
-                + std::to_wstring(nc_->responseCode()) + L", CURL error: " + IuCoreUtils::Utf8ToWstring(nc_->errorString());
-            RmLog(rm_, LOG_ERROR, msg.c_str());
-            return false;
-        }
-        nc_->setUrl(settings_->routerUrl + "/auth");
-
-        std::string hash = IuCoreUtils::CryptoUtils::CalcSHA256HashFromString(challenge +
-            IuCoreUtils::CryptoUtils::CalcMD5HashFromString(settings_->login + ":" + realm + ":" + settings_->password)
-        );
-
-        Json::Value val;
-        val["login"] = settings_->login;
-        val["password"] = hash;
-
-        std::ostringstream stream;
-        stream << val;
-
-        nc_->addQueryHeader("Content-Type", "application/json");
-        nc_->doPost(stream.str());
+std::map<std::wstring,std::weak_ptr<Worker>> workers;
 
-        if (nc_->responseCode() != 200) {
-            std::wstring msg = std::wstring(L"Authentication failed on router. Response code : ")
-                + std::to_wstring(nc_->responseCode()) + L", CURL error: " + IuCoreUtils::Utf8ToWstring(nc_->errorString());
-            RmLog(rm_, LOG_ERROR, msg.c_str());
-            lastAuthErrorTime_ = GetTickCount64();
-            return false;
-        }
+// All routers are polled from a single thread, started with the first router and stopped with the last one
+std::unique_ptr<CurlMultiReactor> reactor;
 
-        authenticated = true;
-        return true;
+CurlMultiReactor* getReactor() {
+    if (!reactor) {
+        reactor = std::make_unique<CurlMultiReactor>();
+        reactor->start();
     }
+    return reactor.get();
+}
 
-    bool logout() {
-        nc_->setUrl(settings_->routerUrl + "/auth");
-        nc_->setMethod("DELETE");
-        nc_->doPost({});
-
-        return nc_->responseCode() == 200;
+// Stops the reactor when no worker is left. Their logout requests are drained by a separate thread,
+// which keeps the plugin loaded until it is done, so that Finalize() does not wait for the router.
+void releaseReactor() {
+    for (auto it = workers.begin(); it != workers.end();) {
+        it = it->second.expired() ? workers.erase(it) : std::next(it);
     }
-
-    void loadData() {
-        bool success = false;
-        nc_->setUrl(settings_->routerUrl + "/rci/" + (settings_->command.empty() ? "show/interface/rrd" : settings_->command));
-        bool isCustomRequest = !settings_->command.empty();
-        std::string requestBody;
-        Json::Value root(Json::arrayValue);
-        if (!isCustomRequest) {
-            for (auto& el : settings_->interfaces) {
-                Json::Value rrd1;
-                rrd1["name"] = el;
-                rrd1["attribute"] = "rxspeed";
-                rrd1["detail"] = 0;
-
-                Json::Value rrd2;
-                rrd2["name"] = el;
-                rrd2["attribute"] = "txspeed";
-                rrd2["detail"] = 0;
-
-                root.append(rrd1);
-                root.append(rrd2);
-            }
-        } else {
-            for (auto& el : settings_->interfaces) {
-                Json::Value item;
-                item["name"] = el;
-                root.append(item);
-            }
-        }
-
-        if (settings_->requestType.empty()) {
-            Json::StreamWriterBuilder builder;
-            builder["commentStyle"] = "None";
-            builder["indentation"] = "   ";
-            requestBody = Json::writeString(builder, root);
-
-            nc_->addQueryHeader("Content-Type", "application/json");
-            nc_->doPost(requestBody);
-        } else if (settings_->requestType == "GET") {
-            nc_->doGet({});
-        } else {
-            nc_->setMethod(settings_->requestType);
-            nc_->doPost(requestBody);
-        }
-    
-        if (nc_->responseCode() == 200) {
-            Json::Value val;
-            Json::Reader reader;
-            if (reader.parse(nc_->responseBody(), val, false)) {
-                try {
-                    Json::Value& rrdObj = val;
-
-                    if (rrdObj.isArray()) {
-                        //int index = measure->mt == MeasureType::mtUpload ? 1 : 0;
-                        std::unique_lock<std::mutex> lk(dataMutex_);
-                        for (int i = 0; i < settings_->interfaces.size(); ++i)  {
-
-                            auto& interf = settings_->interfaces[i];
-
-                            if (isCustomRequest) {
-                                if (!settings_->downloadFieldJsonPath.empty()) {
-                                    Json::Path p(settings_->downloadFieldJsonPath);
-                                    const Json::Value& res = p.resolve(rrdObj[i]);
-                                    std::string str = res.asString();
-                                    
-                                    downloadSpeed_[interf] = atof(str.c_str()) / settings_->downloadDivider;
-                                }
-                                if (!settings_->uploadFieldJsonPath.empty()) {
-                                    Json::Path p(settings_->uploadFieldJsonPath);
-                                    const Json::Value& res = p.resolve(rrdObj[i]);
-                                    std::string str = res.asString();
-
-                                    uploadSpeed_[interf] = atof(str.c_str()) / settings_->uploadDivider;
-                                }
-                            } else {
-
-                                int offset = static_cast<int>(i * 2);
-                                Json::Value& status = rrdObj[offset]["status"];
-
-                                if (status.isArray() && status[0]["status"] == "error") {
-                                    std::wstring msg = std::wstring(L"Server answered with error: ") + IuCoreUtils::Utf8ToWstring(status[0]["message"].asCString());
-                                    RmLog(rm_, LOG_ERROR, msg.c_str());
-                                }
-
-                                Json::Value& data2 = rrdObj[offset]["data"];
-
-                                if (!data2.empty()) {
-                                    Json::Value download = *data2.begin();
-                                    downloadSpeed_[interf] = download["v"].asDouble() / settings_->downloadDivider;
-                                }
-
-                                Json::Value& status2 = rrdObj[offset + 1]["status"];
-                                if (status2.isArray() && status2[0]["status"] == "error") {
-                                    std::wstring msg = std::wstring(L"Server answered with error: ") + IuCoreUtils::Utf8ToWstring(status2[0]["message"].asCString());
-                                    RmLog(rm_, LOG_ERROR, msg.c_str());
-                                }
-
-                                Json::Value& data3 = rrdObj[offset + 1]["data"];
-                                if (!data3.empty()) {
-                                    Json::Value upload = *data3.begin();
-                                    uploadSpeed_[interf] = upload["v"].asDouble() / settings_->uploadDivider;
-                                }
-                            }
-                        }
-                        success = true;
-                    } 
-                } catch (const std::exception& ex) {
-                    RmLog(rm_, LOG_ERROR, IuCoreUtils::Utf8ToWstring(ex.what()).c_str());
-                }
-            }
-        }
-        else {
-            if (nc_->responseCode() == 401) {
-                authenticated = false;
-            }
-            std::wstring msg = std::wstring(L"Failed to get data from router. Response code: ")
-                + std::to_wstring(nc_->responseCode()) + L", CURL error: " + IuCoreUtils::Utf8ToWstring(nc_->errorString());
-
-            RmLog(rm_, LOG_ERROR, msg.c_str());
-        }
-
-        if (!success) {
-            std::unique_lock<std::mutex> lk(dataMutex_);
-            downloadSpeed_.clear();
-            uploadSpeed_.clear();
-        }
+    if (!workers.empty() || !reactor) {
+        return;
     }
-};
-
-struct Measure {
-    MeasureType mt = MeasureType::mtDownload;
-    void* rm = nullptr;
-    std::wstring routerID;
-    std::string interf;
-    std::shared_ptr<Worker> worker;
-};
-
-std::map<std::wstring,std::weak_ptr<Worker>> workers;
+    HMODULE module = nullptr;
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, reinterpret_cast<LPCWSTR>(&releaseReactor), &module)) {
+        reactor->stop();
+        reactor = nullptr;
+        return;
+    }
+    CurlMultiReactor::stopDetached(std::move(reactor), [module] {
+        // Does not return, the few bytes of the thread's own state are left behind
+        FreeLibraryAndExitThread(module, 0);
+    });
+}
 
 PLUGIN_EXPORT void Initialize(void** data, void* rm) {
     auto* measure = new Measure;
     *data = measure;
+    // Section variable functions log errors even if the router could not be set up
+    measure->rm = rm;
     LPCWSTR rmDataFile = RmGetSettingsFile();
     LPCWSTR routerID = RmReadString(rm, L"Router", L"KeeneticPlugin");
     std::shared_ptr<Worker> worker = workers[routerID].lock();
@@ -403,7 +236,7 @@ PLUGIN_EXPORT void Initialize(void** data, void* rm) {
         if (!settings) {
             return;
         }
-        workers[routerID] = worker = std::make_shared<Worker>(rm, settings);
+        workers[routerID] = worker = std::make_shared<Worker>(rm, settings, getReactor());
         worker->start();
     }
     measure->worker = worker;
@@ -417,13 +250,39 @@ PLUGIN_EXPORT void Reload(void* data, void* rm, double* maxValue) {
 
     if (value) {
         std::wstring val = value;
-        measure->mt = val == L"upload" ? MeasureType::mtUpload : MeasureType::mtDownload;
+        if (parseAggregateType(val, measure->aggregateType, measure->aggregateWindow)) {
+            measure->mt = MeasureType::mtAggregate;
+        } else if (parsePercentile(val, measure->percentile)) {
+            measure->mt = MeasureType::mtPercentile;
+        } else {
+            measure->mt = parseMeasureType(val);
+        }
     }
 
+    LPCWSTR direction = RmReadString(rm, L"Direction", L"download");
+    measure->direction = direction && std::wstring(direction) == L"upload" ? Direction::Upload : Direction::Download;
+
+    measure->historyRange = std::max(1, RmReadInt(rm, L"Range", 3600));
+    measure->historyPoints = static_cast<size_t>(std::max(2, RmReadInt(rm, L"Points", 220)));
+    measure->historyTime = 0;
+    // Quantile sketches are kept for a day
+    measure->percentileWindow = std::min(std::max(1, RmReadInt(rm, L"Window", 3600)), 86400);
+
     LPCWSTR interf = RmReadString(rm, L"Interface", L"");
     if (interf) {
         measure->interf = IuCoreUtils::WstringToUtf8(interf);
     }
+
+    if (measure->worker) {
+        measure->unsubscribe();
+        measure->slot = measure->worker->resolveInterface(measure->interf);
+        if (!measure->worker->isValidSlot(measure->slot)) {
+            RmLog(rm, LOG_WARNING, (L"Interface '" + IuCoreUtils::Utf8ToWstring(measure->interf) + L"' is not listed in the router settings").c_str());
+        } else if (measure->mt != MeasureType::mtPollJitter && measure->mt != MeasureType::mtMissedPolls) {
+            measure->worker->subscribe(measure->slot);
+            measure->subscribed = true;
+        }
+    }
 }
 
 PLUGIN_EXPORT double Update(void* data) {
@@ -431,18 +290,73 @@ PLUGIN_EXPORT double Update(void* data) {
     if (!measure->worker) {
         return {};
     }
-    return measure->mt == MeasureType::mtDownload ? measure->worker->getDownloadSpeed(measure->interf)
-        : measure->worker->getUploadSpeed(measure->interf);
+    measure->worker->notifyUpdate();
+    measure->functionResults.clear();
+
+    switch (measure->mt) {
+    case MeasureType::mtUpload:
+        return measure->worker->getUploadSpeed(measure->slot);
+    case MeasureType::mtPollJitter:
+        return measure->worker->getPollJitter();
+    case MeasureType::mtMissedPolls:
+        return measure->worker->getMissedPolls();
+    case MeasureType::mtSampleAge:
+        return measure->worker->getSampleAge(measure->slot);
+    case MeasureType::mtAggregate:
+        return measure->worker->getAggregate(measure->slot, measure->direction, measure->aggregateType, measure->aggregateWindow);
+    case MeasureType::mtHistory:
+        updateHistoryPlot(measure);
+        return measure->historyPeak;
+    case MeasureType::mtPercentile:
+        return measure->worker->getPercentile(measure->slot, measure->direction, measure->percentile, measure->percentileWindow);
+    default:
+        return measure->worker->getDownloadSpeed(measure->slot);
+    }
+}
+
+PLUGIN_EXPORT LPCWSTR GetString(void* data) {
+    auto* measure = static_cast<Measure*>(data);
+    if (measure->mt == MeasureType::mtHistory) {
+        return measure->historyString.c_str();
+    }
+    return nullptr;
+}
+
+PLUGIN_EXPORT LPCWSTR Average(void* data, const int argc, const WCHAR* argv[]) {
+    return statisticFunction(data, L"Average", AggregateType::Average, argc, argv);
+}
+
+PLUGIN_EXPORT LPCWSTR Peak(void* data, const int argc, const WCHAR* argv[]) {
+    return statisticFunction(data, L"Peak", AggregateType::Peak, argc, argv);
+}
+
+PLUGIN_EXPORT LPCWSTR Minimum(void* data, const int argc, const WCHAR* argv[]) {
+    return statisticFunction(data, L"Minimum", AggregateType::Minimum, argc, argv);
+}
+
+// [&Measure:Percentile(percentile, seconds)]
+PLUGIN_EXPORT LPCWSTR Percentile(void* data, const int argc, const WCHAR* argv[]) {
+    auto* measure = static_cast<Measure*>(data);
+    double percentile = 0.0;
+    int64_t seconds = 0;
+    if (argc != 2 || !parseNumber(argv[0], percentile) || !(percentile > 0.0 && percentile <= 100.0)
+        || !parseRange(argv[1], kMaxPercentileRange, seconds)) {
+        RmLog(measure->rm, LOG_ERROR, L"Percentile() expects a percentile (0-100] and a number of seconds");
+        return nullptr;
+    }
+    if (!measure->worker) {
+        return nullptr;
+    }
+    return functionResult(measure, L"Percentile", argc, argv, [measure, percentile, seconds] {
+        return measure->worker->getPercentile(measure->slot, measure->direction, percentile, seconds);
+    });
 }
 
 PLUGIN_EXPORT void Finalize(void* data) {
     auto* measure = static_cast<Measure*>(data);
-    // Worker belongs to at least two "Measures".
-    // Worker thread will exit on destruction, no need to call here.
-    // TODO: Reload settings on skin refresh
-    /*
-     * if (measure->worker) {
-        measure->worker->abort();
-    }*/
+    measure->unsubscribe();
+    // The worker is shared by the measures of its router, the last one destroys it, which cancels
+    // its timers and request on the reactor and starts the logout. The reactor is released after the last worker.
     delete measure;
+    releaseReactor();
 }
@@ -0,0 +1,64 @@
+#include "CounterRate.h"
+
+namespace {
+
+// Faster than any port of the router (10 Gbit/s), larger deltas can only be resets
+constexpr double kMaxBytesPerSecond = 1.25e9;
+
+// Allowance for readings taken close to each other while the counters are updated in chunks
+constexpr double kMaxBurstBytes = 1024.0 * 1024.0;
+
+constexpr uint64_t kCounter32 = uint64_t(1) << 32;
+
+}
+
+ByteCounterRate::ByteCounterRate(int64_t maxInterval) : maxInterval_(maxInterval) {
+}
+
+ByteCounterRate::Result ByteCounterRate::update(int64_t time, uint64_t rxBytes, uint64_t txBytes,
+    double& rxRate, double& txRate) {
+    // Nothing is known about the counters in between, a reboot may have reset them
+    if (!valid_ || time <= time_ || time - time_ > maxInterval_) {
+        valid_ = true;
+        time_ = time;
+        rxBytes_ = rxBytes;
+        txBytes_ = txBytes;
+        return Result::Baseline;
+    }
+
+    double seconds = static_cast<double>(time - time_) / 1e6;
+    uint64_t rx = 0;
+    uint64_t tx = 0;
+    bool counted = delta(rxBytes_, rxBytes, seconds, rx) && delta(txBytes_, txBytes, seconds, tx);
+    time_ = time;
+    rxBytes_ = rxBytes;
+    txBytes_ = txBytes;
+    if (!counted) {
+        return Result::Reset;
+    }
+    rxRate = static_cast<double>(rx) / seconds;
+    txRate = static_cast<double>(tx) / seconds;
+    return Result::Rate;
+}
+
+void ByteCounterRate::reset() {
+    valid_ = false;
+}
+
+bool ByteCounterRate::delta(uint64_t previous, uint64_t current, double seconds, uint64_t& bytes) {
+    double limit = kMaxBytesPerSecond * seconds + kMaxBurstBytes;
+    if (current >= previous) {
+        bytes = current - previous;
+        return static_cast<double>(bytes) <= limit;
+    }
+    // A 32-bit counter wraps every few seconds at gigabit speeds
+    if (previous < kCounter32) {
+        bytes = kCounter32 - previous + current;
+        if (static_cast<double>(bytes) <= limit) {
+            return true;
+        }
+    }
+    // Unsigned arithmetic wraps at 64 bits
+    bytes = current - previous;
+    return static_cast<double>(bytes) <= limit;
+}
@@ -0,0 +1,73 @@
+#ifndef KEENETIC_PLUGIN_COUNTERRATE_H
+#define KEENETIC_PLUGIN_COUNTERRATE_H
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+/**
+ * Values extracted from one element of the show/interface/stat response.
+ */
+struct InterfaceCounters {
+    // Cumulative byte counters, as reported by the router
+    uint64_t rxBytes = 0;
+    uint64_t txBytes = 0;
+    // False if the element has no byte counters
+    bool hasValue = false;
+    // The first entry of the "status" array reports an error
+    bool failed = false;
+    std::string message;
+};
+
+/**
+ * Rates of an interface computed from consecutive readings of its cumulative byte counters.
+ *
+ * Routers keep the counters in 32 or 64 bits, a counter smaller than the previous reading is taken
+ * as a wraparound if the wrapped delta is plausible for the time elapsed, otherwise as a reset
+ * (interface restart, router reboot), which only starts a new baseline.
+ *
+ * The plausible delta grows with the time elapsed, so after a long gap a reset counter would pass
+ * for a wrap: readings further apart than maxInterval start a new baseline instead.
+ */
+class ByteCounterRate {
+public:
+    enum class Result {
+        // Rates are computed
+        Rate,
+        // First reading, or the previous one is not usable
+        Baseline,
+        // A counter was reset, the reading is a new baseline
+        Reset
+    };
+
+    /**
+     * @param maxInterval - longest time between readings which are compared, in microseconds,
+     * e.g. a few poll intervals.
+     */
+    explicit ByteCounterRate(int64_t maxInterval = std::numeric_limits<int64_t>::max());
+
+    /**
+     * @param time - when the counters were read, in microseconds, must increase.
+     * @param rxRate, txRate - receive the rates in bytes per second if Result::Rate is returned.
+     */
+    Result update(int64_t time, uint64_t rxBytes, uint64_t txBytes, double& rxRate, double& txRate);
+
+    // Forgets the baseline
+    void reset();
+
+private:
+    /**
+     * Bytes counted between two readings, false if the counter was reset.
+     */
+    static bool delta(uint64_t previous, uint64_t current, double seconds, uint64_t& bytes);
+
+    int64_t maxInterval_;
+    bool valid_ = false;
+    int64_t time_ = 0;
+    uint64_t rxBytes_ = 0;
+    uint64_t txBytes_ = 0;
+};
+
+#endif
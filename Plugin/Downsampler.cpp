@@ -0,0 +1,70 @@
+#include "Downsampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+void Downsampler::lttb(const double* x, const double* y, size_t size, size_t threshold, std::vector<PlotPoint>& out) {
+    out.clear();
+    if (threshold >= size) {
+        for (size_t i = 0; i < size; i++) {
+            out.push_back(PlotPoint{ x[i], y[i] });
+        }
+        return;
+    }
+    if (threshold < 3) {
+        // No buckets between the first and the last point
+        if (threshold > 0) {
+            out.push_back(PlotPoint{ x[0], y[0] });
+        }
+        if (threshold > 1) {
+            out.push_back(PlotPoint{ x[size - 1], y[size - 1] });
+        }
+        return;
+    }
+
+    out.reserve(threshold);
+    out.push_back(PlotPoint{ x[0], y[0] });
+
+    // Points between the first and the last one are split into threshold - 2 buckets
+    double every = static_cast<double>(size - 2) / (threshold - 2);
+    size_t kept = 0;
+    for (size_t bucket = 0; bucket < threshold - 2; bucket++) {
+        size_t begin = static_cast<size_t>(std::floor(bucket * every)) + 1;
+        size_t end = static_cast<size_t>(std::floor((bucket + 1) * every)) + 1;
+
+        // Average of the next bucket, which is the last point for the last bucket
+        size_t nextBegin = end;
+        size_t nextEnd = std::min(static_cast<size_t>(std::floor((bucket + 2) * every)) + 1, size);
+        double sumX = 0.0;
+        double sumY = 0.0;
+        for (size_t i = nextBegin; i < nextEnd; i++) {
+            sumX += x[i];
+            sumY += y[i];
+        }
+        double cx = sumX / (nextEnd - nextBegin);
+        double cy = sumY / (nextEnd - nextBegin);
+
+        // Doubled triangle area as a linear function of the candidate point
+        double ax = x[kept];
+        double ay = y[kept];
+        double p = ax - cx;
+        double q = cy - ay;
+        double r = -p * ay - q * ax;
+        const double* bx = x + begin;
+        const double* by = y + begin;
+        size_t count = end - begin;
+        size_t best = 0;
+        double bestArea = -1.0;
+        for (size_t i = 0; i < count; i++) {
+            double area = std::fabs(p * by[i] + q * bx[i] + r);
+            bool larger = area > bestArea;
+            bestArea = larger ? area : bestArea;
+            best = larger ? i : best;
+        }
+
+        kept = begin + best;
+        out.push_back(PlotPoint{ x[kept], y[kept] });
+    }
+
+    out.push_back(PlotPoint{ x[size - 1], y[size - 1] });
+}
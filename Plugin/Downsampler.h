@@ -0,0 +1,31 @@
+#ifndef KEENETIC_PLUGIN_DOWNSAMPLER_H
+#define KEENETIC_PLUGIN_DOWNSAMPLER_H
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+struct PlotPoint {
+    double x;
+    double y;
+};
+
+/**
+ * Largest-Triangle-Three-Buckets downsampling (Sveinn Steinarsson, 2013). The first and the last points
+ * are kept, from every bucket in between the point forming the largest triangle with the point kept
+ * from the previous bucket and the average of the next bucket, so peaks and the shape of the line survive.
+ *
+ * Coordinates are passed as separate arrays and the inner loops are branchless, so the compiler may vectorize them.
+ * The area of a triangle is linear in the candidate point, so each candidate costs two multiplications.
+ */
+class Downsampler {
+public:
+    /**
+     * Reduces the points to at most threshold ones, x must be ascending.
+     * Points are copied as is when there are not more than threshold of them.
+     */
+    static void lttb(const double* x, const double* y, size_t size, size_t threshold, std::vector<PlotPoint>& out);
+};
+
+#endif
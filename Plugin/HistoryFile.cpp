@@ -0,0 +1,245 @@
+#include "HistoryFile.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Blocks start at a page boundary
+constexpr uint64_t kHeaderSize = 4096;
+static_assert(sizeof(HistoryFileHeader) <= kHeaderSize, "The header does not fit before the blocks");
+// The current block, the free one and at least one more
+constexpr uint64_t kMinBlocks = 3;
+
+}
+
+HistoryFile::~HistoryFile() {
+    close();
+}
+
+bool HistoryFile::open(const std::wstring& fileName, size_t blocks) {
+    close();
+    blockCount_ = std::max<uint64_t>(kMinBlocks, blocks);
+    uint64_t fileSize = kHeaderSize + blockCount_ * SampleBlock::kSize;
+
+    file_ = ::CreateFileW(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return fail("Unable to open the file, error " + std::to_string(::GetLastError()));
+    }
+
+    // The header of a file of another size cannot match, the file is started over anyway
+    LARGE_INTEGER currentSize{};
+    if (!::GetFileSizeEx(file_, &currentSize)) {
+        return fail("Unable to get the file size, error " + std::to_string(::GetLastError()));
+    }
+    if (static_cast<uint64_t>(currentSize.QuadPart) != fileSize) {
+        LARGE_INTEGER newSize{};
+        newSize.QuadPart = static_cast<LONGLONG>(fileSize);
+        if (!::SetFilePointerEx(file_, newSize, nullptr, FILE_BEGIN) || !::SetEndOfFile(file_)) {
+            return fail("Unable to resize the file, error " + std::to_string(::GetLastError()));
+        }
+    }
+
+    mapping_ = ::CreateFileMappingW(file_, nullptr, PAGE_READWRITE, static_cast<DWORD>(fileSize >> 32),
+        static_cast<DWORD>(fileSize & 0xffffffff), nullptr);
+    if (!mapping_) {
+        return fail("Unable to map the file, error " + std::to_string(::GetLastError()));
+    }
+    void* view = ::MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!view) {
+        return fail("Unable to map the file, error " + std::to_string(::GetLastError()));
+    }
+    header_ = static_cast<HistoryFileHeader*>(view);
+    blocks_ = static_cast<char*>(view) + kHeaderSize;
+
+    if (!header_->matches(blockCount_)) {
+        reset();
+        return true;
+    }
+
+    const HistoryCommitState* state = header_->committed();
+    if (!state || !writer_.resume(blockAt(state->block), state->count, state->bits)) {
+        reset();
+        return true;
+    }
+    sequence_ = state->sequence;
+    block_ = state->block;
+    size_ = 0;
+    for (uint64_t block = firstBlock(); block <= block_; block++) {
+        size_ += blockHeader(block).count;
+    }
+    return true;
+}
+
+void HistoryFile::close() {
+    if (header_) {
+        ::FlushViewOfFile(header_, 0);
+        ::UnmapViewOfFile(header_);
+        header_ = nullptr;
+        blocks_ = nullptr;
+    }
+    if (mapping_) {
+        ::CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+    sequence_ = block_ = 0;
+    size_ = 0;
+}
+
+bool HistoryFile::isOpen() const {
+    return header_ != nullptr;
+}
+
+bool HistoryFile::fail(const std::string& message) {
+    error_ = message;
+    close();
+    return false;
+}
+
+void HistoryFile::reset() {
+    header_->reset(blockCount_);
+    sequence_ = block_ = 0;
+    size_ = 0;
+    writer_.start(blockAt(0));
+}
+
+void HistoryFile::commit(uint64_t block, uint32_t count, uint32_t bits) {
+    uint64_t sequence = sequence_ + 1;
+    header_->commit(sequence, block, count, bits);
+    sequence_ = sequence;
+    block_ = block;
+}
+
+void* HistoryFile::blockAt(uint64_t block) const {
+    return blocks_ + (block % blockCount_) * SampleBlock::kSize;
+}
+
+const SampleBlockHeader& HistoryFile::blockHeader(uint64_t block) const {
+    return *static_cast<const SampleBlockHeader*>(blockAt(block));
+}
+
+uint64_t HistoryFile::firstBlock() const {
+    // One block is kept free for the block being started
+    return block_ - std::min(block_, blockCount_ - 2);
+}
+
+uint64_t HistoryFile::findBlock(int64_t time) const {
+    // Blocks are ordered by time, every header lies on its own page, so a linear scan of a large
+    // file would touch all of them on each read
+    uint64_t first = firstBlock();
+    uint64_t last = block_;
+    while (first < last) {
+        uint64_t middle = first + (last - first) / 2;
+        const SampleBlockHeader& header = blockHeader(middle);
+        if (header.count && header.lastTime < time) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+void HistoryFile::append(const HistoryRecord& record) {
+    if (!header_ || record.time <= lastTime()) {
+        return;
+    }
+    if (writer_.append(record)) {
+        commit(block_, writer_.header().count, writer_.header().bits);
+        size_++;
+        return;
+    }
+
+    // The current block is full and already complete, the committed state never covers the next one
+    if (block_ - firstBlock() == blockCount_ - 2) {
+        size_ -= blockHeader(firstBlock()).count;
+    }
+    writer_.start(blockAt(block_ + 1));
+    if (writer_.append(record)) {
+        commit(block_ + 1, writer_.header().count, writer_.header().bits);
+        size_++;
+    }
+}
+
+size_t HistoryFile::size() const {
+    return size_;
+}
+
+int64_t HistoryFile::lastTime() const {
+    return size_ ? writer_.header().lastTime : std::numeric_limits<int64_t>::min();
+}
+
+void HistoryFile::read(int64_t from, int64_t to, std::vector<HistoryRecord>& records) const {
+    if (!size_) {
+        return;
+    }
+    for (uint64_t block = findBlock(from); block <= block_; block++) {
+        const SampleBlockHeader& header = blockHeader(block);
+        if (!header.count || header.lastTime < from) {
+            continue;
+        }
+        if (header.firstTime >= to) {
+            break;
+        }
+        SampleBlock::Reader reader(blockAt(block));
+        HistoryRecord record;
+        while (reader.next(record) && record.time < to) {
+            if (record.time >= from) {
+                records.push_back(record);
+            }
+        }
+    }
+}
+
+HistorySummary HistoryFile::summarize(int64_t from, int64_t to) const {
+    HistorySummary res;
+    auto add = [&res](const SampleSummary& download, const SampleSummary& upload, size_t count) {
+        for (auto item : { std::make_pair(&res.download, &download), std::make_pair(&res.upload, &upload) }) {
+            SampleSummary& summary = *item.first;
+            if (!res.count) {
+                summary = *item.second;
+            } else {
+                summary.minimum = std::min(summary.minimum, item.second->minimum);
+                summary.maximum = std::max(summary.maximum, item.second->maximum);
+                summary.sum += item.second->sum;
+            }
+        }
+        res.count += count;
+    };
+    if (!size_) {
+        return res;
+    }
+
+    for (uint64_t block = findBlock(from); block <= block_; block++) {
+        const SampleBlockHeader& header = blockHeader(block);
+        if (!header.count || header.lastTime < from) {
+            continue;
+        }
+        if (header.firstTime >= to) {
+            break;
+        }
+        if (header.firstTime >= from && header.lastTime < to) {
+            add(header.download, header.upload, header.count);
+            continue;
+        }
+        SampleBlock::Reader reader(blockAt(block));
+        HistoryRecord record;
+        while (reader.next(record) && record.time < to) {
+            if (record.time >= from) {
+                SampleSummary download{ record.download, record.download, record.download };
+                SampleSummary upload{ record.upload, record.upload, record.upload };
+                add(download, upload, 1);
+            }
+        }
+    }
+    return res;
+}
+
+const std::string& HistoryFile::error() const {
+    return error_;
+}
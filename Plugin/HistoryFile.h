@@ -0,0 +1,106 @@
+#ifndef KEENETIC_PLUGIN_HISTORYFILE_H
+#define KEENETIC_PLUGIN_HISTORYFILE_H
+
+#pragma once
+
+#include <Windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Core/Utils/CoreTypes.h"
+#include "HistoryHeader.h"
+#include "SampleBlock.h"
+
+struct HistorySummary {
+    size_t count = 0;
+    SampleSummary download;
+    SampleSummary upload;
+};
+
+/**
+ * Speed history of one interface stored on disk, so that long-range graphs survive restarts of Rainmeter.
+ *
+ * The file holds a header followed by a fixed number of compressed blocks (see SampleBlock) used
+ * as a ring buffer, so its size is bounded and appending is an update of the memory-mapped view,
+ * which never blocks on the disk. The header keeps two copies of the commit state, see HistoryFileHeader:
+ * a torn header write falls back to the previous state, samples past the committed ones are ignored,
+ * and the block being started is never referenced by the committed state, so the file is consistent
+ * after a crash of the process at any point.
+ *
+ * The view is flushed only by close(), until then the system writes the modified pages out in any order.
+ * A power loss or a crash of the system may therefore leave a header newer than its blocks,
+ * such failures are not covered.
+ *
+ * Not thread-safe.
+ */
+class HistoryFile {
+public:
+    HistoryFile() = default;
+    ~HistoryFile();
+
+    /**
+     * Opens or creates the file of the given number of blocks, one of which is always kept free.
+     * A file with another number of blocks or a damaged header is started over.
+     * @return false if the file could not be opened or mapped, see error().
+     */
+    bool open(const std::wstring& fileName, size_t blocks);
+    void close();
+    bool isOpen() const;
+
+    /**
+     * Appends a record, overwriting the oldest block if the file is full.
+     * Records not newer than the last one (e.g. after the system clock is set back) are skipped.
+     */
+    void append(const HistoryRecord& record);
+
+    // Number of records
+    size_t size() const;
+
+    // Time of the newest record, or INT64_MIN if the file is empty
+    int64_t lastTime() const;
+
+    /**
+     * Appends the records with from <= time < to to records, oldest first.
+     * Only the blocks overlapping the range are decoded.
+     */
+    void read(int64_t from, int64_t to, std::vector<HistoryRecord>& records) const;
+
+    /**
+     * Minimum, maximum and sum of the records with from <= time < to.
+     * Blocks lying entirely inside the range are not decoded.
+     */
+    HistorySummary summarize(int64_t from, int64_t to) const;
+
+    // Reason of the last failure
+    const std::string& error() const;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(HistoryFile);
+
+    bool fail(const std::string& message);
+    void reset();
+    void commit(uint64_t block, uint32_t count, uint32_t bits);
+    void* blockAt(uint64_t block) const;
+    const SampleBlockHeader& blockHeader(uint64_t block) const;
+    // Index of the oldest block holding records
+    uint64_t firstBlock() const;
+    // Index of the oldest block holding records not older than time
+    uint64_t findBlock(int64_t time) const;
+
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+    HistoryFileHeader* header_ = nullptr;
+    char* blocks_ = nullptr;
+    uint64_t blockCount_ = 0;
+    // Committed state: sequence number and the total number of blocks started before the current one
+    uint64_t sequence_ = 0;
+    uint64_t block_ = 0;
+    SampleBlock::Writer writer_;
+    size_t size_ = 0;
+    std::string error_;
+};
+
+#endif
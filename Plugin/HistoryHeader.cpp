@@ -0,0 +1,64 @@
+#include "HistoryHeader.h"
+
+#include <cstring>
+#include <initializer_list>
+
+#include "SampleBlock.h"
+
+namespace {
+
+constexpr char kMagic[8] = { 'K', 'N', 'H', 'I', 'S', 'T', '\0', '\0' };
+constexpr uint32_t kVersion = 2;
+
+// FNV-1a
+uint64_t checksum(uint64_t sequence, uint64_t block, uint32_t count, uint32_t bits) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint64_t value : { sequence, block, (static_cast<uint64_t>(count) << 32) | bits }) {
+        for (int i = 0; i < 8; i++) {
+            hash ^= (value >> (i * 8)) & 0xff;
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+bool intact(const HistoryCommitState& state) {
+    return state.checksum == checksum(state.sequence, state.block, state.count, state.bits);
+}
+
+}
+
+void HistoryFileHeader::reset(uint64_t blockCount) {
+    std::memset(this, 0, sizeof(HistoryFileHeader));
+    std::memcpy(magic, kMagic, sizeof(kMagic));
+    version = kVersion;
+    blockSize = SampleBlock::kSize;
+    this->blockCount = blockCount;
+    for (HistoryCommitState& s : states) {
+        s.checksum = checksum(0, 0, 0, 0);
+    }
+}
+
+bool HistoryFileHeader::matches(uint64_t blockCount) const {
+    return std::memcmp(magic, kMagic, sizeof(kMagic)) == 0 && version == kVersion && blockSize == SampleBlock::kSize
+        && this->blockCount == blockCount;
+}
+
+const HistoryCommitState* HistoryFileHeader::committed() const {
+    const HistoryCommitState* res = nullptr;
+    for (const HistoryCommitState& s : states) {
+        if (intact(s) && (!res || s.sequence > res->sequence)) {
+            res = &s;
+        }
+    }
+    return res;
+}
+
+void HistoryFileHeader::commit(uint64_t sequence, uint64_t block, uint32_t count, uint32_t bits) {
+    HistoryCommitState& s = states[sequence % 2];
+    s.sequence = sequence;
+    s.block = block;
+    s.count = count;
+    s.bits = bits;
+    s.checksum = checksum(sequence, block, count, bits);
+}
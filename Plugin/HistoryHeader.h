@@ -0,0 +1,47 @@
+#ifndef KEENETIC_PLUGIN_HISTORYHEADER_H
+#define KEENETIC_PLUGIN_HISTORYHEADER_H
+
+#pragma once
+
+#include <cstdint>
+
+// Position of the newest record of a history file, see HistoryFile
+struct HistoryCommitState {
+    uint64_t sequence;
+    // Total number of blocks started before the current one
+    uint64_t block;
+    // Records and encoded bits of the current block
+    uint32_t count;
+    uint32_t bits;
+    uint64_t checksum;
+};
+
+/**
+ * Header at the start of a history file, read and written in place in the mapped view.
+ *
+ * Keeps two copies of the commit state, written alternately: a write torn by a crash damages
+ * only the copy being written, whose checksum then does not match, and the other copy still
+ * holds the previous state. Does not depend on how the file is mapped, so recovery is tested
+ * without Windows.
+ */
+struct HistoryFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockSize;
+    uint64_t blockCount;
+    HistoryCommitState states[2];
+
+    // Starts an empty history of blockCount blocks
+    void reset(uint64_t blockCount);
+
+    // Whether the header is of the current format and describes a file of blockCount blocks
+    bool matches(uint64_t blockCount) const;
+
+    // The intact copy of the commit state with the higher sequence number, nullptr if both are damaged
+    const HistoryCommitState* committed() const;
+
+    // Overwrites the older copy, sequence must be the committed one plus one
+    void commit(uint64_t sequence, uint64_t block, uint32_t count, uint32_t bits);
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "InterfaceHistory.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr int64_t kWindowDurations[] = { 60 * 1000, 5 * 60 * 1000, 60 * 60 * 1000 };
+
+// 10 minutes at 1 s, 2 hours at 10 s, a day at 1 min and a week at 10 min
+const std::vector<RollupPyramid::Level> kRollupLevels = {
+    { 1000, 600 }, { 10 * 1000, 720 }, { 60 * 1000, 1440 }, { 10 * 60 * 1000, 1008 }
+};
+
+// An hour in 1 min panes and a day in 10 min panes
+const std::vector<SlidingQuantiles::Tier> kQuantileTiers = {
+    { 60 * 1000, 60 }, { 10 * 60 * 1000, 144 }
+};
+
+// Polls may come slightly more often than the poll interval while the scheduler shifts its phase
+size_t windowCapacity(int64_t duration, int64_t pollInterval) {
+    int64_t samples = duration / std::max<int64_t>(1, pollInterval);
+    return static_cast<size_t>(samples + samples / 4 + 2);
+}
+
+}
+
+InterfaceHistory::InterfaceHistory(size_t interfaces, std::chrono::milliseconds pollInterval) :
+    size_(interfaces),
+    published_(std::make_unique<std::atomic<double>[]>(interfaces * 2 * kWindowCount * kAggregateCount)) {
+    std::vector<int64_t> windows(std::begin(kWindowDurations), std::end(kWindowDurations));
+    std::vector<size_t> capacities;
+    for (int64_t duration : windows) {
+        capacities.push_back(windowCapacity(duration, pollInterval.count()));
+    }
+    series_.reserve(interfaces * 2);
+    rollups_.reserve(interfaces * 2);
+    quantiles_.reserve(interfaces * 2);
+    for (size_t i = 0; i < interfaces * 2; i++) {
+        series_.emplace_back(windows, capacities);
+        rollups_.emplace_back(kRollupLevels);
+        quantiles_.emplace_back(kQuantileTiers);
+    }
+    for (size_t i = 0; i < interfaces * 2 * kWindowCount * kAggregateCount; i++) {
+        published_[i].store(0.0, std::memory_order_relaxed);
+    }
+}
+
+RollingSeries& InterfaceHistory::series(size_t slot, Direction direction) {
+    return series_[slot * 2 + (direction == Direction::Upload ? 1 : 0)];
+}
+
+size_t InterfaceHistory::valueIndex(size_t slot, Direction direction, AggregateType type, size_t window) const {
+    size_t seriesIndex = slot * 2 + (direction == Direction::Upload ? 1 : 0);
+    return (seriesIndex * kWindowCount + window) * kAggregateCount + static_cast<size_t>(type);
+}
+
+void InterfaceHistory::add(size_t slot, int64_t time, const InterfaceSpeed& speed) {
+    if (slot >= size_) {
+        return;
+    }
+    series(slot, Direction::Download).push(time, speed.download);
+    series(slot, Direction::Upload).push(time, speed.upload);
+    publish(slot);
+
+    std::lock_guard<std::mutex> lk(rollupMutex_);
+    rollups_[slot * 2].add(time, speed.download);
+    rollups_[slot * 2 + 1].add(time, speed.upload);
+    quantiles_[slot * 2].add(time, speed.download);
+    quantiles_[slot * 2 + 1].add(time, speed.upload);
+}
+
+void InterfaceHistory::merge(size_t slot, Direction direction, const std::vector<SpeedSample>& samples) {
+    if (slot >= size_) {
+        return;
+    }
+    RollingSeries& s = series(slot, direction);
+    {
+        std::lock_guard<std::mutex> lk(rollupMutex_);
+        size_t index = slot * 2 + (direction == Direction::Upload ? 1 : 0);
+        RollupPyramid& rollup = rollups_[index];
+        SlidingQuantiles& quantiles = quantiles_[index];
+        for (const SpeedSample& sample : samples) {
+            if (sample.time > s.lastTime()) {
+                s.push(sample.time, sample.value);
+                rollup.add(sample.time, sample.value);
+                quantiles.add(sample.time, sample.value);
+            }
+        }
+    }
+    publish(slot);
+}
+
+void InterfaceHistory::expire(size_t slot, int64_t now) {
+    if (slot >= size_) {
+        return;
+    }
+    series(slot, Direction::Download).expire(now);
+    series(slot, Direction::Upload).expire(now);
+    publish(slot);
+}
+
+void InterfaceHistory::clear(size_t slot) {
+    if (slot >= size_) {
+        return;
+    }
+    series(slot, Direction::Download).clear();
+    series(slot, Direction::Upload).clear();
+    publish(slot);
+
+    std::lock_guard<std::mutex> lk(rollupMutex_);
+    rollups_[slot * 2].clear();
+    rollups_[slot * 2 + 1].clear();
+    quantiles_[slot * 2].clear();
+    quantiles_[slot * 2 + 1].clear();
+}
+
+void InterfaceHistory::publish(size_t slot) {
+    // Every measure reads a single value, so the values need not be published atomically as a whole
+    for (Direction direction : { Direction::Download, Direction::Upload }) {
+        const RollingSeries& s = series(slot, direction);
+        for (size_t w = 0; w < kWindowCount; w++) {
+            RollingSeries::Aggregates agg = s.aggregates(w);
+            published_[valueIndex(slot, direction, AggregateType::Average, w)].store(agg.average, std::memory_order_relaxed);
+            published_[valueIndex(slot, direction, AggregateType::Peak, w)].store(agg.peak, std::memory_order_relaxed);
+            published_[valueIndex(slot, direction, AggregateType::Minimum, w)].store(agg.minimum, std::memory_order_relaxed);
+        }
+    }
+}
+
+double InterfaceHistory::read(size_t slot, Direction direction, AggregateType type, AggregateWindow window) const {
+    if (slot >= size_) {
+        return 0.0;
+    }
+    return published_[valueIndex(slot, direction, type, static_cast<size_t>(window))].load(std::memory_order_relaxed);
+}
+
+int64_t InterfaceHistory::query(size_t slot, Direction direction, int64_t from, int64_t to, int64_t resolution,
+    std::vector<RollupBucket>& buckets) const {
+    if (slot >= size_) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lk(rollupMutex_);
+    return rollups_[slot * 2 + (direction == Direction::Upload ? 1 : 0)].query(from, to, resolution, buckets);
+}
+
+double InterfaceHistory::quantile(size_t slot, Direction direction, int64_t now, int64_t window, double q) const {
+    if (slot >= size_) {
+        return 0.0;
+    }
+    std::lock_guard<std::mutex> lk(rollupMutex_);
+    return quantiles_[slot * 2 + (direction == Direction::Upload ? 1 : 0)].quantile(now, window, q);
+}
+
+int64_t InterfaceHistory::retention() const {
+    return kRollupLevels.back().duration * static_cast<int64_t>(kRollupLevels.back().buckets);
+}
+
+size_t InterfaceHistory::memoryUsage() const {
+    if (series_.empty()) {
+        return 0;
+    }
+    return (series_[0].memoryUsage() + rollups_[0].memoryUsage() + quantiles_[0].memoryUsage()) * 2;
+}
@@ -0,0 +1,117 @@
+#ifndef KEENETIC_PLUGIN_INTERFACEHISTORY_H
+#define KEENETIC_PLUGIN_INTERFACEHISTORY_H
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Core/Utils/CoreTypes.h"
+#include "QuantileSketch.h"
+#include "RollingSeries.h"
+#include "RollupPyramid.h"
+#include "SpeedTable.h"
+
+enum class Direction {
+    Download,
+    Upload
+};
+
+enum class AggregateType {
+    Average,
+    Peak,
+    Minimum
+};
+
+enum class AggregateWindow {
+    OneMinute,
+    FiveMinutes,
+    OneHour
+};
+
+struct SpeedSample {
+    int64_t time;
+    double value;
+};
+
+/**
+ * Recent speeds of all interfaces of a router, with rolling aggregates over the last minute, 5 minutes and hour,
+ * rollups of the last week at 1 s, 10 s, 1 min and 10 min resolution for graphs,
+ * and quantile sketches of the last day in 1 min and 10 min panes.
+ *
+ * Samples are added by the reactor thread, which also publishes the aggregates after every update.
+ * The published values may be read from any thread without locking, rollups and sketches are guarded by a mutex.
+ */
+class InterfaceHistory {
+public:
+    InterfaceHistory(size_t interfaces, std::chrono::milliseconds pollInterval);
+
+    /**
+     * Adds a sample of the interface, time is in milliseconds and must not decrease.
+     */
+    void add(size_t slot, int64_t time, const InterfaceSpeed& speed);
+
+    /**
+     * Adds samples obtained elsewhere (e.g. the router's own history) to one direction of the interface.
+     * Samples must be sorted by time, those not newer than the latest known sample are skipped.
+     */
+    void merge(size_t slot, Direction direction, const std::vector<SpeedSample>& samples);
+
+    /**
+     * Drops expired samples of the interface when no fresh sample is available.
+     */
+    void expire(size_t slot, int64_t now);
+
+    /**
+     * Forgets all samples of the interface.
+     */
+    void clear(size_t slot);
+
+    double read(size_t slot, Direction direction, AggregateType type, AggregateWindow window) const;
+
+    /**
+     * Rollup buckets of the interface overlapping [from, to), see RollupPyramid::query().
+     * May be called from any thread.
+     * @return bucket duration in milliseconds, zero if the slot is invalid.
+     */
+    int64_t query(size_t slot, Direction direction, int64_t from, int64_t to, int64_t resolution,
+        std::vector<RollupBucket>& buckets) const;
+
+    /**
+     * Speed at the quantile q (0..1) of the samples of the interface within window before now,
+     * see SlidingQuantiles::quantile(). May be called from any thread.
+     */
+    double quantile(size_t slot, Direction direction, int64_t now, int64_t window, double q) const;
+
+    // Time covered by the rollups, in milliseconds
+    int64_t retention() const;
+
+    // Bytes taken by the samples, rollups and sketches of one interface, bounded by the poll interval
+    size_t memoryUsage() const;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(InterfaceHistory);
+
+    static constexpr size_t kWindowCount = 3;
+    static constexpr size_t kAggregateCount = 3;
+
+    RollingSeries& series(size_t slot, Direction direction);
+    void publish(size_t slot);
+    size_t valueIndex(size_t slot, Direction direction, AggregateType type, size_t window) const;
+
+    size_t size_;
+    // Two series per interface: download and upload
+    std::vector<RollingSeries> series_;
+    std::unique_ptr<std::atomic<double>[]> published_;
+    // Same layout as series_
+    std::vector<RollupPyramid> rollups_;
+    std::vector<SlidingQuantiles> quantiles_;
+    // Guards rollups_ and quantiles_
+    mutable std::mutex rollupMutex_;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "JsonFieldPath.h"
+
+#include <cstdlib>
+#include <limits>
+
+bool JsonFieldPath::compile(const std::string& path, std::string& error) {
+    components_.clear();
+    size_t pos = 0;
+    const size_t len = path.size();
+
+    while (pos < len) {
+        char c = path[pos];
+        if (c == '[') {
+            size_t start = ++pos;
+            uint64_t index = 0;
+            while (pos < len && path[pos] >= '0' && path[pos] <= '9') {
+                index = index * 10 + (path[pos] - '0');
+                if (index > std::numeric_limits<Json::ArrayIndex>::max()) {
+                    error = "array index is too large at position " + std::to_string(start);
+                    return false;
+                }
+                ++pos;
+            }
+            if (pos == start || pos >= len || path[pos] != ']') {
+                error = "expected array index followed by ']' at position " + std::to_string(start);
+                return false;
+            }
+            ++pos;
+            Component component;
+            component.index = static_cast<Json::ArrayIndex>(index);
+            component.isIndex = true;
+            components_.push_back(std::move(component));
+        } else if (c == ']') {
+            error = "unexpected ']' at position " + std::to_string(pos);
+            return false;
+        } else {
+            if (c == '.') {
+                ++pos;
+            }
+            size_t start = pos;
+            while (pos < len && path[pos] != '[' && path[pos] != '.') {
+                ++pos;
+            }
+            if (pos == start) {
+                error = "empty field name at position " + std::to_string(start);
+                return false;
+            }
+            if (path.compare(start, pos - start, "%") == 0) {
+                error = "path arguments ('%') are not supported";
+                return false;
+            }
+            Component component;
+            component.key = path.substr(start, pos - start);
+            components_.push_back(std::move(component));
+        }
+    }
+    return true;
+}
+
+bool JsonFieldPath::empty() const {
+    return components_.empty();
+}
+
+const std::vector<JsonFieldPath::Component>& JsonFieldPath::components() const {
+    return components_;
+}
+
+const Json::Value* JsonFieldPath::resolve(const Json::Value& root) const {
+    const Json::Value* node = &root;
+    for (const auto& component : components_) {
+        if (component.isIndex) {
+            if (!node->isArray() || component.index >= node->size()) {
+                return nullptr;
+            }
+            node = &(*node)[component.index];
+        } else {
+            if (!node->isObject()) {
+                return nullptr;
+            }
+            node = node->find(component.key.data(), component.key.data() + component.key.size());
+            if (!node) {
+                return nullptr;
+            }
+        }
+    }
+    return node;
+}
+
+double JsonFieldPath::readNumber(const Json::Value& root) const {
+    const Json::Value* value = resolve(root);
+    if (!value) {
+        return 0.0;
+    }
+    if (value->isNumeric()) {
+        return value->asDouble();
+    }
+    if (value->isString()) {
+        // Some commands report counters as strings
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        if (value->getString(&begin, &end)) {
+            return parseNumber(begin, end);
+        }
+    }
+    return 0.0;
+}
+
+double JsonFieldPath::parseNumber(const char* begin, const char* end) {
+    return std::strtod(std::string(begin, end).c_str(), nullptr);
+}
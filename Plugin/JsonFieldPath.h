@@ -0,0 +1,56 @@
+#ifndef KEENETIC_PLUGIN_JSONFIELDPATH_H
+#define KEENETIC_PLUGIN_JSONFIELDPATH_H
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <json/value.h>
+
+/**
+ * Path to a field of a JSON document in JsonCpp path syntax (".name", "[index]"),
+ * parsed once when the settings are loaded and then applied to every response.
+ *
+ * Unlike Json::Path, malformed paths are rejected, and "%" arguments are not supported.
+ */
+class JsonFieldPath {
+public:
+    JsonFieldPath() = default;
+
+    /**
+     * Parses the path. Empty path is valid and resolves to nothing.
+     * @param error - receives the reason if the path is malformed.
+     */
+    bool compile(const std::string& path, std::string& error);
+
+    bool empty() const;
+
+    /**
+     * Returns the field, or nullptr if any component of the path is missing.
+     */
+    const Json::Value* resolve(const Json::Value& root) const;
+
+    /**
+     * Reads the field as a number. Numeric strings are accepted as well,
+     * missing and non-numeric fields read as zero.
+     */
+    double readNumber(const Json::Value& root) const;
+
+    // Conversion of numeric strings, shared by all parsers so they read the same values
+    static double parseNumber(const char* begin, const char* end);
+
+    struct Component {
+        std::string key;
+        Json::ArrayIndex index = 0;
+        bool isIndex = false;
+    };
+
+    // For parsers which walk the document themselves
+    const std::vector<Component>& components() const;
+
+private:
+    std::vector<Component> components_;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "PollScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Fraction of the phase error corrected on each poll, keeps the loop stable against noisy frame times
+constexpr double kPhaseGain = 0.5;
+
+// Safety margin between the expected arrival of the response and the next frame
+constexpr std::chrono::milliseconds kFrameGuard(30);
+
+// Weight of the latest sample in the smoothed request latency
+constexpr double kLatencySmoothing = 0.2;
+
+template<class Rep, class Period>
+int64_t floorDiv(std::chrono::duration<Rep, Period> a, std::chrono::duration<Rep, Period> b) {
+    int64_t q = a / b;
+    if ((a % b).count() != 0 && ((a.count() < 0) != (b.count() < 0))) {
+        --q;
+    }
+    return q;
+}
+
+double toMs(PollScheduler::Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+}
+
+PollScheduler::PollScheduler(Clock::duration period) : period_(period) {
+    anchor_ = Clock::now();
+}
+
+void PollScheduler::setPhaseAlignment(bool enable) {
+    phaseAlignment_ = enable;
+}
+
+PollScheduler::Clock::time_point PollScheduler::nextDeadline(Clock::time_point now, Clock::time_point lastFrame) {
+    if (phaseAlignment_ && lastFrame != Clock::time_point()) {
+        alignPhase(lastFrame);
+    }
+
+    Clock::time_point deadline = anchor_ + (floorDiv(now - anchor_, period_) + 1) * period_;
+
+    if (hasDeadline_) {
+        // Never poll twice within one period, even if the phase was shifted backwards
+        Clock::time_point earliest = deadline_ + period_ / 2;
+        while (deadline < earliest) {
+            deadline += period_;
+        }
+        int64_t skipped = (deadline - deadline_ + period_ / 2) / period_ - 1;
+        if (skipped > 0) {
+            stats_.missedDeadlines += skipped;
+        }
+    }
+    deadline_ = deadline;
+    hasDeadline_ = true;
+    return deadline;
+}
+
+void PollScheduler::onFired(Clock::time_point now) {
+    if (!hasDeadline_) {
+        return;
+    }
+    double jitterMs = std::abs(toMs(now - deadline_));
+    stats_.polls++;
+    jitterSumMs_ += jitterMs;
+    stats_.meanJitterMs = jitterSumMs_ / stats_.polls;
+    stats_.maxJitterMs = std::max(stats_.maxJitterMs, jitterMs);
+}
+
+void PollScheduler::onCompleted(Clock::time_point started, Clock::time_point finished) {
+    double ms = toMs(finished - started);
+    if (!hasLatency_) {
+        latencyMs_ = ms;
+        hasLatency_ = true;
+    } else {
+        latencyMs_ += kLatencySmoothing * (ms - latencyMs_);
+    }
+}
+
+PollScheduler::Stats PollScheduler::stats() const {
+    return stats_;
+}
+
+void PollScheduler::resetStats() {
+    stats_ = Stats();
+    jitterSumMs_ = 0;
+}
+
+PollScheduler::Clock::duration PollScheduler::period() const {
+    return period_;
+}
+
+void PollScheduler::alignPhase(Clock::time_point lastFrame) {
+    // The response should arrive kFrameGuard before the frame, but we never lead by more than half a period
+    auto latency = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(latencyMs_));
+    Clock::duration lead = std::min<Clock::duration>(latency + kFrameGuard, period_ / 2);
+    Clock::time_point desiredAnchor = lastFrame - lead;
+
+    // Wrap the phase error into [-period/2, period/2)
+    Clock::duration error = desiredAnchor - anchor_;
+    error -= floorDiv(error + period_ / 2, period_) * period_;
+
+    anchor_ += Clock::duration(static_cast<Clock::rep>(error.count() * kPhaseGain));
+}
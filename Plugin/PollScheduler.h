@@ -0,0 +1,72 @@
+#ifndef KEENETIC_PLUGIN_POLLSCHEDULER_H
+#define KEENETIC_PLUGIN_POLLSCHEDULER_H
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Computes poll deadlines on a fixed grid of absolute ticks (anchor + k * period),
+ * so the polling period does not drift by the request latency.
+ *
+ * Optionally the grid is phase-locked to the moments when Rainmeter calls Update(),
+ * so that a fresh sample arrives shortly before every frame.
+ *
+ * Not thread-safe, owned by the worker and used on the reactor thread only.
+ */
+class PollScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        double meanJitterMs = 0;
+        double maxJitterMs = 0;
+        uint64_t missedDeadlines = 0;
+        uint64_t polls = 0;
+    };
+
+    explicit PollScheduler(Clock::duration period);
+
+    void setPhaseAlignment(bool enable);
+
+    /**
+     * Returns the next deadline which is strictly in the future.
+     * Ticks which were skipped since the previous deadline are counted as missed.
+     * @param lastFrame - time of the latest Update() call, or default time_point if unknown.
+     */
+    Clock::time_point nextDeadline(Clock::time_point now, Clock::time_point lastFrame);
+
+    /**
+     * Must be called when the poll scheduled for the last returned deadline actually fires.
+     */
+    void onFired(Clock::time_point now);
+
+    /**
+     * Must be called when a response for a poll is received.
+     */
+    void onCompleted(Clock::time_point started, Clock::time_point finished);
+
+    Stats stats() const;
+    void resetStats();
+
+    Clock::duration period() const;
+
+private:
+    void alignPhase(Clock::time_point lastFrame);
+
+    Clock::duration period_;
+    Clock::time_point anchor_;
+    Clock::time_point deadline_;
+    bool phaseAlignment_ = false;
+    bool hasDeadline_ = false;
+
+    // Smoothed request latency
+    double latencyMs_ = 0;
+    bool hasLatency_ = false;
+
+    double jitterSumMs_ = 0;
+    Stats stats_;
+};
+
+#endif
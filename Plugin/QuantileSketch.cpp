@@ -0,0 +1,228 @@
+#include "QuantileSketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const double kGamma = (1.0 + QuantileSketch::kRelativeAccuracy) / (1.0 - QuantileSketch::kRelativeAccuracy);
+const double kInvLogGamma = 1.0 / std::log(kGamma);
+
+// Smaller values are counted as zeros, far below any meaningful speed
+constexpr double kMinValue = 1e-9;
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t res = a / b;
+    return res * b > a ? res - 1 : res;
+}
+
+}
+
+QuantileSketch::QuantileSketch() {
+    clear();
+}
+
+void QuantileSketch::clear() {
+    std::memset(bins_, 0, sizeof(bins_));
+    offset_ = minIndex_ = maxIndex_ = 0;
+    binned_ = false;
+    zeros_ = count_ = 0;
+}
+
+void QuantileSketch::add(double value) {
+    ++count_;
+    if (!(value > kMinValue)) {
+        ++zeros_;
+        return;
+    }
+    addToBin(static_cast<int>(std::ceil(std::log(value) * kInvLogGamma)), 1);
+}
+
+void QuantileSketch::addToBin(int index, uint64_t count) {
+    if (!binned_) {
+        offset_ = index - kBins / 2;
+        minIndex_ = maxIndex_ = index;
+        binned_ = true;
+    } else if (index < offset_ || index >= offset_ + kBins) {
+        int low = std::min(minIndex_, index);
+        int high = std::max(maxIndex_, index);
+        // If the values do not fit, the highest bins are kept
+        int offset = high - low + 1 > kBins || index >= offset_ + kBins ? high - kBins + 1 : low;
+        if (offset != offset_) {
+            rebase(offset);
+        }
+        index = std::max(index, offset_);
+    }
+    uint64_t n = bins_[index - offset_] + count;
+    bins_[index - offset_] = static_cast<uint16_t>(std::min<uint64_t>(n, std::numeric_limits<uint16_t>::max()));
+    minIndex_ = std::min(minIndex_, index);
+    maxIndex_ = std::max(maxIndex_, index);
+}
+
+void QuantileSketch::rebase(int offset) {
+    uint16_t bins[kBins] = {};
+    for (int i = minIndex_; i <= maxIndex_; i++) {
+        // Bins below the new range are merged into the lowest one
+        int j = std::max(i, offset) - offset;
+        uint64_t n = static_cast<uint64_t>(bins[j]) + bins_[i - offset_];
+        bins[j] = static_cast<uint16_t>(std::min<uint64_t>(n, std::numeric_limits<uint16_t>::max()));
+    }
+    std::memcpy(bins_, bins, sizeof(bins_));
+    offset_ = offset;
+    minIndex_ = std::max(minIndex_, offset);
+}
+
+uint64_t QuantileSketch::count() const {
+    return count_;
+}
+
+uint64_t QuantileSketch::zeros() const {
+    return zeros_;
+}
+
+bool QuantileSketch::binRange(int& low, int& high) const {
+    low = minIndex_;
+    high = maxIndex_;
+    return binned_;
+}
+
+double QuantileSketch::binValue(int index) {
+    // Middle of the bin in terms of the relative error
+    return 2.0 * std::pow(kGamma, index) / (kGamma + 1.0);
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (!count_) {
+        return 0.0;
+    }
+    double rank = std::min(std::max(q, 0.0), 1.0) * static_cast<double>(count_ - 1);
+    uint64_t seen = zeros_;
+    if (rank < seen || !binned_) {
+        return 0.0;
+    }
+    int index = maxIndex_;
+    for (int i = minIndex_; i <= maxIndex_; i++) {
+        seen += bins_[i - offset_];
+        if (seen > rank) {
+            index = i;
+            break;
+        }
+    }
+    return binValue(index);
+}
+
+void MergedQuantiles::merge(const QuantileSketch& sketch) {
+    int low;
+    int high;
+    if (sketch.binRange(low, high)) {
+        if (bins_.empty()) {
+            low_ = low;
+            bins_.resize(static_cast<size_t>(high - low + 1));
+        } else if (low < low_ || high >= low_ + static_cast<int>(bins_.size())) {
+            int newLow = std::min(low, low_);
+            int newHigh = std::max(high, low_ + static_cast<int>(bins_.size()) - 1);
+            std::vector<uint64_t> bins(static_cast<size_t>(newHigh - newLow + 1));
+            std::copy(bins_.begin(), bins_.end(), bins.begin() + (low_ - newLow));
+            bins_ = std::move(bins);
+            low_ = newLow;
+        }
+        sketch.forEachBin([this](int index, uint64_t n) {
+            bins_[index - low_] += n;
+        });
+    }
+    zeros_ += sketch.zeros();
+    count_ += sketch.count();
+}
+
+void MergedQuantiles::clear() {
+    bins_.clear();
+    low_ = 0;
+    zeros_ = count_ = 0;
+}
+
+uint64_t MergedQuantiles::count() const {
+    return count_;
+}
+
+double MergedQuantiles::quantile(double q) const {
+    if (!count_) {
+        return 0.0;
+    }
+    double rank = std::min(std::max(q, 0.0), 1.0) * static_cast<double>(count_ - 1);
+    uint64_t seen = zeros_;
+    if (rank < seen || bins_.empty()) {
+        return 0.0;
+    }
+    for (size_t i = 0; i < bins_.size(); i++) {
+        seen += bins_[i];
+        if (seen > rank) {
+            return QuantileSketch::binValue(low_ + static_cast<int>(i));
+        }
+    }
+    return QuantileSketch::binValue(low_ + static_cast<int>(bins_.size()) - 1);
+}
+
+SlidingQuantiles::SlidingQuantiles(const std::vector<Tier>& tiers) {
+    for (const Tier& tier : tiers) {
+        Ring ring;
+        ring.duration = std::max<int64_t>(1, tier.duration);
+        ring.panes.resize(std::max<size_t>(1, tier.panes));
+        rings_.push_back(std::move(ring));
+    }
+    clear();
+}
+
+void SlidingQuantiles::add(int64_t time, double value) {
+    for (Ring& ring : rings_) {
+        int64_t index = floorDiv(time, ring.duration);
+        Pane& pane = ring.panes[static_cast<size_t>(index - floorDiv(index, ring.panes.size()) * ring.panes.size())];
+        if (pane.index != index) {
+            pane.index = index;
+            pane.sketch.clear();
+        }
+        pane.sketch.add(value);
+    }
+}
+
+void SlidingQuantiles::clear() {
+    for (Ring& ring : rings_) {
+        for (Pane& pane : ring.panes) {
+            pane.index = std::numeric_limits<int64_t>::min();
+            pane.sketch.clear();
+        }
+    }
+}
+
+double SlidingQuantiles::quantile(int64_t now, int64_t window, double q) const {
+    if (rings_.empty()) {
+        return 0.0;
+    }
+    const Ring* ring = &rings_.back();
+    for (const Ring& r : rings_) {
+        if (r.duration * static_cast<int64_t>(r.panes.size()) >= window) {
+            ring = &r;
+            break;
+        }
+    }
+    // A pane is included if most of it lies within the window
+    int64_t first = floorDiv(now - window + ring->duration / 2, ring->duration);
+    int64_t last = floorDiv(now, ring->duration);
+
+    MergedQuantiles merged;
+    for (const Pane& pane : ring->panes) {
+        if (pane.index >= first && pane.index <= last) {
+            merged.merge(pane.sketch);
+        }
+    }
+    return merged.quantile(q);
+}
+
+size_t SlidingQuantiles::memoryUsage() const {
+    size_t res = 0;
+    for (const Ring& ring : rings_) {
+        res += ring.panes.capacity() * sizeof(Pane);
+    }
+    return res;
+}
@@ -0,0 +1,133 @@
+#ifndef KEENETIC_PLUGIN_QUANTILESKETCH_H
+#define KEENETIC_PLUGIN_QUANTILESKETCH_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * DDSketch (Masson, Rim, Lee, 2019) with a fixed number of bins: values are counted in bins of exponentially
+ * growing width, so any quantile is returned with a relative error of at most kRelativeAccuracy.
+ * The bins cover about 9 decades, e.g. 10 B/s to 10 GB/s. When the values span more, the lowest bins are merged,
+ * which keeps high quantiles (the interesting ones for traffic) accurate. Sketches are mergeable, see MergedQuantiles.
+ *
+ * Memory is fixed, a bin counts up to 65535 values. Negative values are counted as zeros. Not thread-safe.
+ */
+class QuantileSketch {
+public:
+    static constexpr double kRelativeAccuracy = 0.02;
+    static constexpr int kBins = 512;
+
+    QuantileSketch();
+
+    void add(double value);
+    void clear();
+
+    uint64_t count() const;
+    uint64_t zeros() const;
+
+    // Value at the quantile q (0..1), zero if the sketch is empty
+    double quantile(double q) const;
+
+    // Indices of the lowest and the highest non-empty bins, false if there are none
+    bool binRange(int& low, int& high) const;
+
+    // Calls func(index, count) for every non-empty bin, in ascending order
+    template<class Func> void forEachBin(Func&& func) const {
+        if (!binned_) {
+            return;
+        }
+        for (int i = minIndex_; i <= maxIndex_; i++) {
+            if (bins_[i - offset_]) {
+                func(i, bins_[i - offset_]);
+            }
+        }
+    }
+
+    // Value represented by the bin
+    static double binValue(int index);
+
+private:
+    void addToBin(int index, uint64_t count);
+    void rebase(int offset);
+
+    // Index of the first bin, bins cover [offset_, offset_ + kBins)
+    int offset_ = 0;
+    // Range of non-empty bins, valid if binned_
+    int minIndex_ = 0;
+    int maxIndex_ = 0;
+    bool binned_ = false;
+    uint64_t zeros_ = 0;
+    uint64_t count_ = 0;
+    uint16_t bins_[kBins];
+};
+
+/**
+ * Sketches merged bin by bin into 64-bit counters, which neither saturate nor collapse: the quantiles
+ * are those of a single sketch fed all of the values, as long as its bins would not have saturated.
+ * Not thread-safe.
+ */
+class MergedQuantiles {
+public:
+    void merge(const QuantileSketch& sketch);
+    void clear();
+
+    uint64_t count() const;
+
+    // Value at the quantile q (0..1), zero if nothing was merged
+    double quantile(double q) const;
+
+private:
+    // Counters of the bins from low_ on
+    std::vector<uint64_t> bins_;
+    int low_ = 0;
+    uint64_t zeros_ = 0;
+    uint64_t count_ = 0;
+};
+
+/**
+ * Quantiles of the samples of a sliding window. Samples are counted in sketches of fixed time panes,
+ * kept in rings of several pane durations (e.g. minutes for the last hour, 10 minutes for the day),
+ * a query merges the panes of the finest ring covering the window, so the window is rounded to panes.
+ *
+ * Memory is fixed, see memoryUsage(). Not thread-safe.
+ */
+class SlidingQuantiles {
+public:
+    struct Tier {
+        // Pane duration, in the units of the sample times
+        int64_t duration;
+        size_t panes;
+    };
+
+    // Tiers must be ordered from the finest one
+    explicit SlidingQuantiles(const std::vector<Tier>& tiers);
+
+    /**
+     * Sample times must not decrease.
+     */
+    void add(int64_t time, double value);
+    void clear();
+
+    // Value at the quantile q of the samples within window before now, zero if there are none
+    double quantile(int64_t now, int64_t window, double q) const;
+
+    size_t memoryUsage() const;
+
+private:
+    struct Pane {
+        int64_t index;
+        QuantileSketch sketch;
+    };
+
+    struct Ring {
+        int64_t duration;
+        std::vector<Pane> panes;
+    };
+
+    std::vector<Ring> rings_;
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "ResponseReader.h"
+
+#include <cstdlib>
+
+#include <json/json.h>
+
+#include "SimdJsonReader.h"
+
+namespace {
+
+/**
+ * Builds a Json::Value DOM of the whole response.
+ */
+class JsonCppReader : public ResponseReader {
+public:
+    bool readRrd(std::string_view body, std::vector<RrdSeries>& series, bool withSamples) override {
+        Json::Value val;
+        if (!parse(body, val)) {
+            return false;
+        }
+        series.resize(val.size());
+        for (Json::ArrayIndex k = 0; k < val.size(); ++k) {
+            const Json::Value& item = val[k];
+            RrdSeries& s = series[k];
+            s = RrdSeries();
+
+            const Json::Value& status = item["status"];
+            if (status.isArray() && status[0]["status"] == "error") {
+                s.failed = true;
+                s.message = status[0]["message"].asString();
+            }
+            const Json::Value& data = item["data"];
+            if (!data.empty()) {
+                s.hasValue = true;
+                s.value = (*data.begin())["v"].asDouble();
+                s.time = (*data.begin())["t"].asInt64();
+                if (withSamples) {
+                    for (const Json::Value& sample : data) {
+                        s.samples.push_back(RrdSample{ sample["t"].asInt64(), sample["v"].asDouble() });
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    bool readCounters(std::string_view body, std::vector<InterfaceCounters>& counters) override {
+        Json::Value val;
+        if (!parse(body, val)) {
+            return false;
+        }
+        counters.resize(val.size());
+        for (Json::ArrayIndex k = 0; k < val.size(); ++k) {
+            const Json::Value& item = val[k];
+            InterfaceCounters& c = counters[k];
+            c = InterfaceCounters();
+            if (!item.isObject()) {
+                continue;
+            }
+
+            const Json::Value& status = item["status"];
+            if (status.isArray() && status[0]["status"] == "error") {
+                c.failed = true;
+                c.message = status[0]["message"].asString();
+            }
+            c.hasValue = readCounter(item[kRxBytesField], c.rxBytes) && readCounter(item[kTxBytesField], c.txBytes);
+        }
+        return true;
+    }
+
+    bool readFields(std::string_view body, const std::vector<const JsonFieldPath*>& fields,
+        std::vector<double>& values) override {
+        Json::Value val;
+        if (!parse(body, val)) {
+            return false;
+        }
+        values.clear();
+        for (const Json::Value& item : val) {
+            for (const JsonFieldPath* field : fields) {
+                values.push_back(field->readNumber(item));
+            }
+        }
+        return true;
+    }
+
+private:
+    static bool readCounter(const Json::Value& value, uint64_t& res) {
+        if (value.isUInt64()) {
+            res = value.asUInt64();
+            return true;
+        }
+        if (value.isString()) {
+            const char* begin = nullptr;
+            const char* end = nullptr;
+            return value.getString(&begin, &end) && parseCounter(begin, end, res);
+        }
+        return false;
+    }
+
+    bool parse(std::string_view body, Json::Value& val) {
+        if (!reader_) {
+            Json::CharReaderBuilder builder;
+            builder["collectComments"] = false;
+            // Trailing data is an error for the other parsers as well
+            builder["failIfExtra"] = true;
+            reader_.reset(builder.newCharReader());
+        }
+        if (!reader_->parse(body.data(), body.data() + body.size(), &val, &error_)) {
+            return false;
+        }
+        if (!val.isArray()) {
+            error_ = "expected array";
+            return false;
+        }
+        return true;
+    }
+
+    std::unique_ptr<Json::CharReader> reader_;
+};
+
+/**
+ * Streaming parser for show/interface/rrd, jsoncpp for everything else.
+ */
+class DefaultReader : public JsonCppReader {
+public:
+    bool readRrd(std::string_view body, std::vector<RrdSeries>& series, bool withSamples) override {
+        if (!rrdParser_.parse(body.data(), body.size(), series, withSamples)) {
+            error_ = rrdParser_.error();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    RrdParser rrdParser_;
+};
+
+}
+
+const char ResponseReader::kRxBytesField[] = "rxbytes";
+const char ResponseReader::kTxBytesField[] = "txbytes";
+
+bool ResponseReader::parseCounter(const char* begin, const char* end, uint64_t& value) {
+    if (begin == end || *begin < '0' || *begin > '9') {
+        return false;
+    }
+    std::string str(begin, end);
+    char* last = nullptr;
+    value = std::strtoull(str.c_str(), &last, 10);
+    return !*last;
+}
+
+const std::string& ResponseReader::error() const {
+    return error_;
+}
+
+std::unique_ptr<ResponseReader> ResponseReader::create(ResponseParser parser) {
+    switch (parser) {
+    case ResponseParser::JsonCpp:
+        return std::make_unique<JsonCppReader>();
+#ifdef KEENETIC_WITH_SIMDJSON
+    case ResponseParser::SimdJson:
+        return std::make_unique<SimdJsonReader>();
+#endif
+    default:
+        return std::make_unique<DefaultReader>();
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef KEENETIC_PLUGIN_RESPONSEREADER_H
+#define KEENETIC_PLUGIN_RESPONSEREADER_H
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CounterRate.h"
+#include "JsonFieldPath.h"
+#include "RrdParser.h"
+#include "Settings.h"
+
+/**
+ * Extracts values from router responses. Implementations differ only in the JSON parser used,
+ * all of them must produce the same values for the same response.
+ *
+ * Not thread-safe, one instance per worker.
+ */
+class ResponseReader {
+public:
+    virtual ~ResponseReader() = default;
+
+    /**
+     * Reads the response of show/interface/rrd, one entry of series per element of the top-level array.
+     * @param withSamples - also collect all samples of every series, for the history backfill.
+     */
+    virtual bool readRrd(std::string_view body, std::vector<RrdSeries>& series, bool withSamples) = 0;
+
+    /**
+     * Reads the byte counters of show/interface/stat, one entry of counters per element of the top-level array.
+     * Counters are read exactly, as unsigned 64-bit integers or numeric strings.
+     */
+    virtual bool readCounters(std::string_view body, std::vector<InterfaceCounters>& counters) = 0;
+
+    /**
+     * Reads the fields from every element of the top-level array of a custom command response.
+     * values receives fields.size() numbers per element, missing and non-numeric fields read as zero.
+     */
+    virtual bool readFields(std::string_view body, const std::vector<const JsonFieldPath*>& fields,
+        std::vector<double>& values) = 0;
+
+    // Names of the byte counters in show/interface/stat
+    static const char kRxBytesField[];
+    static const char kTxBytesField[];
+
+    // Conversion of counters given as strings, shared by all parsers
+    static bool parseCounter(const char* begin, const char* end, uint64_t& value);
+
+    // Reason of the last failure
+    const std::string& error() const;
+
+    static std::unique_ptr<ResponseReader> create(ResponseParser parser);
+
+protected:
+    std::string error_;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "RollingSeries.h"
+
+#include <algorithm>
+#include <limits>
+
+RollingSeries::MonotonicQueue::MonotonicQueue(size_t capacity) : items_(capacity) {
+}
+
+bool RollingSeries::MonotonicQueue::empty() const {
+    return head_ == tail_;
+}
+
+uint64_t RollingSeries::MonotonicQueue::front() const {
+    return items_[head_ % items_.size()];
+}
+
+uint64_t RollingSeries::MonotonicQueue::back() const {
+    return items_[(tail_ - 1) % items_.size()];
+}
+
+void RollingSeries::MonotonicQueue::popFront() {
+    ++head_;
+}
+
+void RollingSeries::MonotonicQueue::popBack() {
+    --tail_;
+}
+
+void RollingSeries::MonotonicQueue::pushBack(uint64_t pos) {
+    // Never overflows: the queue holds positions of distinct samples of a window, which is not larger than the queue
+    items_[tail_++ % items_.size()] = pos;
+}
+
+void RollingSeries::MonotonicQueue::clear() {
+    head_ = tail_ = 0;
+}
+
+size_t RollingSeries::MonotonicQueue::memoryUsage() const {
+    return items_.capacity() * sizeof(uint64_t);
+}
+
+RollingSeries::Window::Window(int64_t duration, size_t capacity) :
+    duration(duration), capacity(capacity), maxQueue(capacity), minQueue(capacity) {
+}
+
+RollingSeries::RollingSeries(const std::vector<int64_t>& windows, const std::vector<size_t>& capacities) :
+    lastTime_(std::numeric_limits<int64_t>::min()) {
+    size_t ringSize = 1;
+    for (size_t i = 0; i < windows.size(); i++) {
+        size_t capacity = std::max<size_t>(1, i < capacities.size() ? capacities[i] : 1);
+        windows_.emplace_back(windows[i], capacity);
+        ringSize = std::max(ringSize, capacity);
+    }
+    ring_.resize(ringSize);
+}
+
+const RollingSeries::Sample& RollingSeries::at(uint64_t pos) const {
+    return ring_[pos % ring_.size()];
+}
+
+void RollingSeries::evictOldest(Window& window) {
+    uint64_t pos = window.begin++;
+    window.sum -= at(pos).value;
+    if (!window.maxQueue.empty() && window.maxQueue.front() == pos) {
+        window.maxQueue.popFront();
+    }
+    if (!window.minQueue.empty() && window.minQueue.front() == pos) {
+        window.minQueue.popFront();
+    }
+    if (window.begin == next_) {
+        // Reset the accumulated rounding error whenever the window becomes empty
+        window.sum = 0.0;
+    }
+}
+
+void RollingSeries::push(int64_t time, double value) {
+    for (Window& window : windows_) {
+        while (window.begin < next_ && (next_ - window.begin >= window.capacity || at(window.begin).time <= time - window.duration)) {
+            evictOldest(window);
+        }
+    }
+
+    ring_[next_ % ring_.size()] = Sample{ time, value };
+
+    for (Window& window : windows_) {
+        window.sum += value;
+        while (!window.maxQueue.empty() && at(window.maxQueue.back()).value <= value) {
+            window.maxQueue.popBack();
+        }
+        window.maxQueue.pushBack(next_);
+        while (!window.minQueue.empty() && at(window.minQueue.back()).value >= value) {
+            window.minQueue.popBack();
+        }
+        window.minQueue.pushBack(next_);
+    }
+    ++next_;
+    lastTime_ = time;
+}
+
+void RollingSeries::expire(int64_t now) {
+    for (Window& window : windows_) {
+        while (window.begin < next_ && at(window.begin).time <= now - window.duration) {
+            evictOldest(window);
+        }
+    }
+}
+
+void RollingSeries::clear() {
+    for (Window& window : windows_) {
+        window.begin = next_;
+        window.sum = 0.0;
+        window.maxQueue.clear();
+        window.minQueue.clear();
+    }
+    lastTime_ = std::numeric_limits<int64_t>::min();
+}
+
+int64_t RollingSeries::lastTime() const {
+    return lastTime_;
+}
+
+size_t RollingSeries::windowCount() const {
+    return windows_.size();
+}
+
+RollingSeries::Aggregates RollingSeries::aggregates(size_t window) const {
+    Aggregates res;
+    if (window >= windows_.size()) {
+        return res;
+    }
+    const Window& w = windows_[window];
+    res.count = static_cast<size_t>(next_ - w.begin);
+    if (res.count) {
+        res.average = w.sum / res.count;
+        res.peak = at(w.maxQueue.front()).value;
+        res.minimum = at(w.minQueue.front()).value;
+    }
+    return res;
+}
+
+size_t RollingSeries::memoryUsage() const {
+    size_t res = ring_.capacity() * sizeof(Sample);
+    for (const Window& window : windows_) {
+        res += window.maxQueue.memoryUsage() + window.minQueue.memoryUsage();
+    }
+    return res;
+}
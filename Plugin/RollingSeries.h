@@ -0,0 +1,105 @@
+#ifndef KEENETIC_PLUGIN_ROLLINGSERIES_H
+#define KEENETIC_PLUGIN_ROLLINGSERIES_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Samples of one value (e.g. download speed of an interface) kept in a fixed-capacity ring buffer,
+ * with average, peak and minimum maintained incrementally over several sliding time windows.
+ *
+ * Every window keeps a running sum and two monotonic queues of sample positions, so both adding
+ * a sample and evicting an expired one cost amortized O(1) regardless of the window length.
+ *
+ * Not thread-safe.
+ */
+class RollingSeries {
+public:
+    struct Aggregates {
+        double average = 0.0;
+        double peak = 0.0;
+        double minimum = 0.0;
+        size_t count = 0;
+    };
+
+    /**
+     * @param windows - durations of the windows, in the units of the sample times.
+     * @param capacities - maximum number of samples in each window, older samples are evicted
+     * when the window is full even if they have not expired yet.
+     */
+    RollingSeries(const std::vector<int64_t>& windows, const std::vector<size_t>& capacities);
+
+    /**
+     * Sample times must not decrease.
+     */
+    void push(int64_t time, double value);
+
+    /**
+     * Evicts the samples which are older than the windows at the given time,
+     * so that aggregates do not get stuck when no new samples arrive.
+     */
+    void expire(int64_t now);
+
+    void clear();
+
+    // Time of the newest sample, or INT64_MIN if none was pushed since the last clear()
+    int64_t lastTime() const;
+
+    size_t windowCount() const;
+    Aggregates aggregates(size_t window) const;
+
+    // Bytes allocated for the samples and the queues
+    size_t memoryUsage() const;
+
+private:
+    struct Sample {
+        int64_t time;
+        double value;
+    };
+
+    // Positions of samples with monotonic values, back is the newest one
+    class MonotonicQueue {
+    public:
+        explicit MonotonicQueue(size_t capacity);
+
+        bool empty() const;
+        uint64_t front() const;
+        uint64_t back() const;
+        void popFront();
+        void popBack();
+        void pushBack(uint64_t pos);
+        void clear();
+        size_t memoryUsage() const;
+
+    private:
+        std::vector<uint64_t> items_;
+        uint64_t head_ = 0;
+        uint64_t tail_ = 0;
+    };
+
+    struct Window {
+        Window(int64_t duration, size_t capacity);
+
+        int64_t duration;
+        size_t capacity;
+        // Position of the oldest sample inside the window
+        uint64_t begin = 0;
+        double sum = 0.0;
+        MonotonicQueue maxQueue;
+        MonotonicQueue minQueue;
+    };
+
+    const Sample& at(uint64_t pos) const;
+    void evictOldest(Window& window);
+
+    std::vector<Sample> ring_;
+    // Position of the next sample, positions grow monotonically and are mapped into the ring
+    uint64_t next_ = 0;
+    std::vector<Window> windows_;
+    int64_t lastTime_;
+};
+
+#endif
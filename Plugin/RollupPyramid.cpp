@@ -0,0 +1,112 @@
+#include "RollupPyramid.h"
+
+#include <algorithm>
+
+double RollupBucket::average() const {
+    return count ? sum / count : 0.0;
+}
+
+RollupPyramid::Ring::Ring(int64_t duration, size_t capacity) :
+    duration(std::max<int64_t>(1, duration)), items(std::max<size_t>(1, capacity)) {
+}
+
+const RollupBucket& RollupPyramid::Ring::at(size_t index) const {
+    return items[(head + index) % items.size()];
+}
+
+RollupBucket& RollupPyramid::Ring::newest() {
+    return items[(head + size - 1) % items.size()];
+}
+
+void RollupPyramid::Ring::push(const RollupBucket& bucket) {
+    if (size == items.size()) {
+        items[head] = bucket;
+        head = (head + 1) % items.size();
+    } else {
+        items[(head + size) % items.size()] = bucket;
+        ++size;
+    }
+}
+
+RollupPyramid::RollupPyramid(const std::vector<Level>& levels) {
+    levels_.reserve(levels.size());
+    for (const Level& level : levels) {
+        levels_.emplace_back(level.duration, level.buckets);
+    }
+}
+
+void RollupPyramid::add(int64_t time, double value) {
+    auto v = static_cast<float>(value);
+    for (Ring& ring : levels_) {
+        // Floor division, times may be negative
+        int64_t start = time / ring.duration * ring.duration;
+        if (start > time) {
+            start -= ring.duration;
+        }
+        if (ring.size && ring.newest().start == start) {
+            RollupBucket& bucket = ring.newest();
+            bucket.count++;
+            bucket.minimum = std::min(bucket.minimum, v);
+            bucket.maximum = std::max(bucket.maximum, v);
+            bucket.sum += value;
+        } else {
+            RollupBucket bucket;
+            bucket.start = start;
+            bucket.count = 1;
+            bucket.minimum = bucket.maximum = v;
+            bucket.sum = value;
+            ring.push(bucket);
+        }
+    }
+}
+
+void RollupPyramid::clear() {
+    for (Ring& ring : levels_) {
+        ring.head = ring.size = 0;
+    }
+}
+
+int64_t RollupPyramid::query(int64_t from, int64_t to, int64_t resolution, std::vector<RollupBucket>& buckets) const {
+    if (levels_.empty()) {
+        return 0;
+    }
+    size_t level = 0;
+    while (level + 1 < levels_.size() && levels_[level + 1].duration <= resolution) {
+        ++level;
+    }
+    // Only a full ring has evicted older buckets which a coarser level may still have
+    while (level + 1 < levels_.size() && levels_[level].size == levels_[level].items.size()
+        && levels_[level].at(0).start > from) {
+        ++level;
+    }
+
+    const Ring& ring = levels_[level];
+    // First bucket ending after from
+    size_t first = 0;
+    size_t count = ring.size;
+    while (count > 0) {
+        size_t step = count / 2;
+        if (ring.at(first + step).start + ring.duration <= from) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    for (size_t i = first; i < ring.size && ring.at(i).start < to; i++) {
+        buckets.push_back(ring.at(i));
+    }
+    return ring.duration;
+}
+
+int64_t RollupPyramid::retention() const {
+    return levels_.empty() ? 0 : levels_.back().duration * static_cast<int64_t>(levels_.back().items.size());
+}
+
+size_t RollupPyramid::memoryUsage() const {
+    size_t res = 0;
+    for (const Ring& ring : levels_) {
+        res += ring.items.capacity() * sizeof(RollupBucket);
+    }
+    return res;
+}
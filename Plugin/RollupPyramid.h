@@ -0,0 +1,78 @@
+#ifndef KEENETIC_PLUGIN_ROLLUPPYRAMID_H
+#define KEENETIC_PLUGIN_ROLLUPPYRAMID_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct RollupBucket {
+    // Start of the bucket, in the units of the sample times
+    int64_t start = 0;
+    uint32_t count = 0;
+    float minimum = 0.0f;
+    float maximum = 0.0f;
+    double sum = 0.0;
+
+    double average() const;
+};
+
+/**
+ * Samples of one value summarized into buckets of several durations (e.g. 1 s, 10 s, 1 min, 10 min),
+ * every level being a fixed-size ring of its newest buckets. All levels are updated on every sample,
+ * so reading a long range at a low resolution touches only a few coarse buckets instead of all the samples.
+ *
+ * Memory does not depend on the number of samples, see memoryUsage(). Not thread-safe.
+ */
+class RollupPyramid {
+public:
+    struct Level {
+        // Bucket duration, in the units of the sample times
+        int64_t duration;
+        // Number of the newest buckets kept
+        size_t buckets;
+    };
+
+    // Levels must be ordered from the finest one
+    explicit RollupPyramid(const std::vector<Level>& levels);
+
+    /**
+     * Sample times must not decrease.
+     */
+    void add(int64_t time, double value);
+    void clear();
+
+    /**
+     * Appends the non-empty buckets overlapping [from, to) of the coarsest level whose buckets are not longer
+     * than resolution (or the finest level). If that level does not reach back to from, a coarser one which
+     * does is used instead, so a long range is still covered.
+     * @return bucket duration of the level used.
+     */
+    int64_t query(int64_t from, int64_t to, int64_t resolution, std::vector<RollupBucket>& buckets) const;
+
+    // Time covered by the coarsest level
+    int64_t retention() const;
+
+    // Bytes allocated for the buckets
+    size_t memoryUsage() const;
+
+private:
+    struct Ring {
+        Ring(int64_t duration, size_t capacity);
+
+        const RollupBucket& at(size_t index) const;
+        RollupBucket& newest();
+        void push(const RollupBucket& bucket);
+
+        int64_t duration;
+        std::vector<RollupBucket> items;
+        // Position of the oldest bucket and number of buckets
+        size_t head = 0;
+        size_t size = 0;
+    };
+
+    std::vector<Ring> levels_;
+};
+
+#endif
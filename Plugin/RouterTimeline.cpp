@@ -0,0 +1,34 @@
+#include "RouterTimeline.h"
+
+#include <algorithm>
+
+RouterTimeline::RouterTimeline(size_t size) : times_(size) {
+}
+
+RouterTimeline::Result RouterTimeline::update(size_t slot, const RrdSeries* download, const RrdSeries* upload,
+    int64_t maxStep) {
+    bool hasDownload = download && download->hasValue;
+    bool hasUpload = upload && upload->hasValue;
+    if (!hasDownload && !hasUpload) {
+        return Result::Missing;
+    }
+    int64_t time = std::max(hasDownload ? download->time : 0, hasUpload ? upload->time : 0);
+    if (!time) {
+        // Without timestamps every sample is considered new
+        return Result::New;
+    }
+    int64_t last = times_[slot];
+    times_[slot] = time;
+    if (time == last) {
+        return Result::Repeated;
+    }
+    // A timestamp going backwards (e.g. after the router's clock is set) is not a gap
+    if (last && time - last > maxStep) {
+        return Result::Gap;
+    }
+    return Result::New;
+}
+
+void RouterTimeline::reset(size_t slot) {
+    times_[slot] = 0;
+}
@@ -0,0 +1,44 @@
+#ifndef KEENETIC_PLUGIN_ROUTERTIMELINE_H
+#define KEENETIC_PLUGIN_ROUTERTIMELINE_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "RrdParser.h"
+
+/**
+ * Router timestamp of the latest sample of every interface, tells new samples of show/interface/rrd
+ * from the ones already seen in a previous poll, and detects samples skipped in between.
+ */
+class RouterTimeline {
+public:
+    enum class Result {
+        // The response carries no value for the interface
+        Missing,
+        // The router has not produced a new sample since the previous poll
+        Repeated,
+        New,
+        // A new sample, older samples were missed since the previous one
+        Gap
+    };
+
+    explicit RouterTimeline(size_t size);
+
+    /**
+     * @param download, upload - series of the interface, null if missing from the response.
+     * @param maxStep - longest expected time between consecutive samples, in seconds.
+     */
+    Result update(size_t slot, const RrdSeries* download, const RrdSeries* upload, int64_t maxStep);
+
+    // Forgets the latest sample of the interface
+    void reset(size_t slot);
+
+private:
+    // Seconds, zero if unknown
+    std::vector<int64_t> times_;
+};
+
+#endif
@@ -0,0 +1,429 @@
+#include "RrdParser.h"
+
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// Nesting limit for skipped values, protects the stack from malicious responses
+constexpr int kMaxDepth = 64;
+
+bool keyEquals(const char* begin, const char* end, const char* key) {
+    size_t len = std::strlen(key);
+    return static_cast<size_t>(end - begin) == len && std::memcmp(begin, key, len) == 0;
+}
+
+void appendUtf8(std::string& out, unsigned int cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+bool parseHex4(const char* p, unsigned int& out) {
+    out = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        out <<= 4;
+        if (c >= '0' && c <= '9') {
+            out |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            out |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            out |= c - 'A' + 10;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+bool RrdParser::parse(const char* data, size_t size, std::vector<RrdSeries>& series, bool withSamples) {
+    withSamples_ = withSamples;
+    begin_ = cur_ = data;
+    end_ = data + size;
+    error_.clear();
+
+    size_t count = 0;
+    bool first = true;
+    bool done = false;
+
+    skipWhitespace();
+    if (!beginContainer('[')) {
+        return fail("expected array");
+    }
+    while (nextElement(']', first, done) && !done) {
+        if (count == series.size()) {
+            series.emplace_back();
+        }
+        RrdSeries& item = series[count++];
+        item.value = 0.0;
+        item.time = 0;
+        item.hasValue = false;
+        item.failed = false;
+        item.message.clear();
+        item.samples.clear();
+        if (!parseSeries(item)) {
+            return false;
+        }
+    }
+    if (!done) {
+        return false;
+    }
+    series.resize(count);
+
+    skipWhitespace();
+    if (cur_ != end_) {
+        return fail("unexpected data after the end of the array");
+    }
+    return true;
+}
+
+const std::string& RrdParser::error() const {
+    return error_;
+}
+
+bool RrdParser::parseSeries(RrdSeries& series) {
+    if (!beginContainer('{')) {
+        return fail("expected object");
+    }
+    bool first = true;
+    bool done = false;
+    while (nextElement('}', first, done) && !done) {
+        const char* keyBegin = nullptr;
+        const char* keyEnd = nullptr;
+        if (!readKey(keyBegin, keyEnd)) {
+            return false;
+        }
+        bool ok;
+        if (keyEquals(keyBegin, keyEnd, "data") && *cur_ == '[') {
+            ok = parseData(series);
+        } else if (keyEquals(keyBegin, keyEnd, "status") && *cur_ == '[') {
+            ok = parseStatus(series);
+        } else {
+            ok = skipValue();
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return done;
+}
+
+bool RrdParser::parseData(RrdSeries& series) {
+    beginContainer('[');
+    bool first = true;
+    bool done = false;
+    while (nextElement(']', first, done) && !done) {
+        bool ok;
+        // Samples are ordered from the newest one, the rest are needed only for the history
+        if ((!series.hasValue || withSamples_) && *cur_ == '{') {
+            RrdSample sample;
+            ok = parseSample(sample);
+            if (!series.hasValue) {
+                series.hasValue = true;
+                series.value = sample.value;
+                series.time = sample.time;
+            }
+            if (withSamples_) {
+                series.samples.push_back(sample);
+            }
+        } else {
+            ok = skipValue();
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return done;
+}
+
+bool RrdParser::parseSample(RrdSample& sample) {
+    beginContainer('{');
+    bool first = true;
+    bool done = false;
+    while (nextElement('}', first, done) && !done) {
+        const char* keyBegin = nullptr;
+        const char* keyEnd = nullptr;
+        if (!readKey(keyBegin, keyEnd)) {
+            return false;
+        }
+        bool ok;
+        bool isNumber = *cur_ == '-' || (*cur_ >= '0' && *cur_ <= '9');
+        if (keyEquals(keyBegin, keyEnd, "v") && isNumber) {
+            ok = readNumber(sample.value);
+        } else if (keyEquals(keyBegin, keyEnd, "t") && isNumber) {
+            double time = 0;
+            ok = readNumber(time);
+            sample.time = static_cast<int64_t>(time);
+        } else {
+            ok = skipValue();
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return done;
+}
+
+bool RrdParser::parseStatus(RrdSeries& series) {
+    beginContainer('[');
+    bool first = true;
+    bool done = false;
+    bool firstEntry = true;
+    while (nextElement(']', first, done) && !done) {
+        // Only the first entry is examined, like the error check of the jsoncpp path
+        if (!firstEntry || *cur_ != '{') {
+            if (!skipValue()) {
+                return false;
+            }
+            continue;
+        }
+        firstEntry = false;
+
+        beginContainer('{');
+        bool firstMember = true;
+        bool objectDone = false;
+        while (nextElement('}', firstMember, objectDone) && !objectDone) {
+            const char* keyBegin = nullptr;
+            const char* keyEnd = nullptr;
+            if (!readKey(keyBegin, keyEnd)) {
+                return false;
+            }
+            bool ok;
+            if (keyEquals(keyBegin, keyEnd, "status") && *cur_ == '"') {
+                const char* valueBegin = cur_ + 1;
+                ok = skipString();
+                series.failed = ok && keyEquals(valueBegin, cur_ - 1, "error");
+            } else if (keyEquals(keyBegin, keyEnd, "message") && *cur_ == '"') {
+                ok = readString(series.message);
+            } else {
+                ok = skipValue();
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        if (!objectDone) {
+            return false;
+        }
+        // The message of a successful status is informational
+        if (!series.failed) {
+            series.message.clear();
+        }
+    }
+    return done;
+}
+
+bool RrdParser::readKey(const char*& begin, const char*& end) {
+    if (cur_ == end_ || *cur_ != '"') {
+        return fail("expected object key");
+    }
+    begin = cur_ + 1;
+    // Keys of interest contain no escapes, so a key is compared by its raw bytes
+    if (!skipString()) {
+        return false;
+    }
+    end = cur_ - 1;
+    skipWhitespace();
+    if (cur_ == end_ || *cur_ != ':') {
+        return fail("expected ':'");
+    }
+    ++cur_;
+    skipWhitespace();
+    if (cur_ == end_) {
+        return fail("unexpected end of data");
+    }
+    return true;
+}
+
+bool RrdParser::readString(std::string& out) {
+    out.clear();
+    ++cur_;
+    while (cur_ != end_) {
+        char c = *cur_++;
+        if (c == '"') {
+            return true;
+        }
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (cur_ == end_) {
+            break;
+        }
+        char esc = *cur_++;
+        switch (esc) {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/': out += '/'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+            unsigned int cp;
+            if (end_ - cur_ < 4 || !parseHex4(cur_, cp)) {
+                return fail("invalid unicode escape");
+            }
+            cur_ += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                unsigned int low;
+                if (end_ - cur_ < 6 || cur_[0] != '\\' || cur_[1] != 'u' || !parseHex4(cur_ + 2, low)
+                    || low < 0xDC00 || low > 0xDFFF) {
+                    return fail("invalid surrogate pair");
+                }
+                cur_ += 6;
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            }
+            appendUtf8(out, cp);
+            break;
+        }
+        default:
+            return fail("invalid escape sequence");
+        }
+    }
+    return fail("unterminated string");
+}
+
+bool RrdParser::readNumber(double& out) {
+    // from_chars also accepts "inf" and "nan", which are not JSON. It does not accept the leading '+',
+    // which is not allowed by JSON either
+    const char* digits = cur_ != end_ && *cur_ == '-' ? cur_ + 1 : cur_;
+    if (digits == end_ || *digits < '0' || *digits > '9') {
+        return fail("expected number");
+    }
+    auto res = std::from_chars(cur_, end_, out);
+    if (res.ec == std::errc::result_out_of_range) {
+        // Like jsoncpp: infinity if the magnitude is too large, zero or a denormal if it is too small
+        out = std::strtod(std::string(cur_, res.ptr).c_str(), nullptr);
+    } else if (res.ec != std::errc()) {
+        return fail("expected number");
+    }
+    cur_ = res.ptr;
+    return true;
+}
+
+bool RrdParser::skipString() {
+    ++cur_;
+    while (cur_ != end_) {
+        const char* quote = static_cast<const char*>(std::memchr(cur_, '"', end_ - cur_));
+        if (!quote) {
+            break;
+        }
+        // The quote is escaped if it is preceded by an odd number of backslashes
+        const char* p = quote;
+        while (p != cur_ && p[-1] == '\\') {
+            --p;
+        }
+        cur_ = quote + 1;
+        if ((quote - p) % 2 == 0) {
+            return true;
+        }
+    }
+    cur_ = end_;
+    return fail("unterminated string");
+}
+
+bool RrdParser::skipValue(int depth) {
+    if (cur_ == end_) {
+        return fail("unexpected end of data");
+    }
+    char c = *cur_;
+    if (c == '"') {
+        return skipString();
+    }
+    if (c == '{' || c == '[') {
+        if (depth >= kMaxDepth) {
+            return fail("nesting is too deep");
+        }
+        char close = c == '{' ? '}' : ']';
+        beginContainer(c);
+        bool first = true;
+        bool done = false;
+        while (nextElement(close, first, done) && !done) {
+            if (c == '{') {
+                const char* keyBegin = nullptr;
+                const char* keyEnd = nullptr;
+                if (!readKey(keyBegin, keyEnd)) {
+                    return false;
+                }
+            }
+            if (!skipValue(depth + 1)) {
+                return false;
+            }
+        }
+        return done;
+    }
+    if (c == 't' || c == 'f' || c == 'n') {
+        const char* literal = c == 't' ? "true" : c == 'f' ? "false" : "null";
+        size_t len = std::strlen(literal);
+        if (static_cast<size_t>(end_ - cur_) < len || std::memcmp(cur_, literal, len) != 0) {
+            return fail("invalid literal");
+        }
+        cur_ += len;
+        return true;
+    }
+    double unused;
+    return readNumber(unused);
+}
+
+bool RrdParser::beginContainer(char open) {
+    if (cur_ == end_ || *cur_ != open) {
+        return false;
+    }
+    ++cur_;
+    return true;
+}
+
+bool RrdParser::nextElement(char close, bool& first, bool& done) {
+    skipWhitespace();
+    if (cur_ == end_) {
+        return fail("unexpected end of data");
+    }
+    if (*cur_ == close) {
+        ++cur_;
+        done = true;
+        return true;
+    }
+    if (!first) {
+        if (*cur_ != ',') {
+            return fail("expected ','");
+        }
+        ++cur_;
+        skipWhitespace();
+        if (cur_ == end_) {
+            return fail("unexpected end of data");
+        }
+    }
+    first = false;
+    return true;
+}
+
+void RrdParser::skipWhitespace() {
+    while (cur_ != end_ && (*cur_ == ' ' || *cur_ == '\n' || *cur_ == '\r' || *cur_ == '\t')) {
+        ++cur_;
+    }
+}
+
+bool RrdParser::fail(const char* reason) {
+    if (error_.empty()) {
+        error_ = std::string(reason) + " at offset " + std::to_string(cur_ - begin_);
+    }
+    return false;
+}
@@ -0,0 +1,81 @@
+#ifndef KEENETIC_PLUGIN_RRDPARSER_H
+#define KEENETIC_PLUGIN_RRDPARSER_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct RrdSample {
+    // Router timestamp, seconds
+    int64_t time = 0;
+    double value = 0.0;
+};
+
+/**
+ * Values extracted from one element of the show/interface/rrd response.
+ */
+struct RrdSeries {
+    // First value of the "data" array, zero if the sample has no "v"
+    double value = 0.0;
+    // Timestamp of the first sample, zero if the sample has no "t"
+    int64_t time = 0;
+    // False if the "data" array is missing or empty
+    bool hasValue = false;
+    // The first entry of the "status" array reports an error
+    bool failed = false;
+    std::string message;
+    // All samples of the "data" array, newest first. Filled only on request.
+    std::vector<RrdSample> samples;
+};
+
+/**
+ * Pull parser specialized for the response of show/interface/rrd:
+ *
+ *   [{"data": [{"t": ..., "v": ...}, ...], "status": [{"status": "error", "message": "..."}]}, ...]
+ *
+ * Reads the needed values straight from the response bytes without building a DOM.
+ * Unknown keys are skipped, so additional fields do not break the parser.
+ * Not thread-safe, one instance per worker.
+ */
+class RrdParser {
+public:
+    /**
+     * Fills one entry of series per element of the top-level array. The vector is reused between
+     * calls, so after the first poll parsing allocates nothing unless the router reports an error.
+     * @param withSamples - collect all samples, not only the first one.
+     * @return false if the response is not valid JSON of the expected shape, see error().
+     */
+    bool parse(const char* data, size_t size, std::vector<RrdSeries>& series, bool withSamples = false);
+
+    const std::string& error() const;
+
+private:
+    bool parseSeries(RrdSeries& series);
+    bool parseData(RrdSeries& series);
+    bool parseSample(RrdSample& sample);
+    bool parseStatus(RrdSeries& series);
+
+    bool readKey(const char*& begin, const char*& end);
+    bool readString(std::string& out);
+    bool readNumber(double& out);
+    bool skipString();
+    bool skipValue(int depth = 0);
+
+    // Iterates over the elements of an array or the members of an object, cur_ must point to the opening bracket
+    bool beginContainer(char open);
+    bool nextElement(char close, bool& first, bool& done);
+
+    void skipWhitespace();
+    bool fail(const char* reason);
+
+    bool withSamples_ = false;
+    const char* begin_ = nullptr;
+    const char* cur_ = nullptr;
+    const char* end_ = nullptr;
+    std::string error_;
+};
+
+#endif
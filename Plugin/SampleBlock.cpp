@@ -0,0 +1,314 @@
+#include "SampleBlock.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+static_assert(sizeof(HistoryRecord) == 16, "HistoryRecord is a part of the file format");
+static_assert(sizeof(SampleBlockHeader) == 56, "SampleBlockHeader is a part of the file format");
+
+// Zigzag-encoded delta-of-delta below these limits takes the short forms
+constexpr unsigned kDeltaBits[] = { 7, 9, 12 };
+
+uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bitsFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+unsigned leadingZeros(uint32_t value) {
+    unsigned n = 0;
+    for (unsigned shift = 16; shift > 0; shift /= 2) {
+        if (!(value >> (32 - shift))) {
+            n += shift;
+            value <<= shift;
+        }
+    }
+    return n;
+}
+
+unsigned trailingZeros(uint32_t value) {
+    unsigned n = 0;
+    for (unsigned shift = 16; shift > 0; shift /= 2) {
+        if (!(value & ((1u << shift) - 1))) {
+            n += shift;
+            value >>= shift;
+        }
+    }
+    return n;
+}
+
+// MSB-first bit stream, bits past the end of the stream may hold garbage and are overwritten
+class BitWriter {
+public:
+    BitWriter(uint8_t* data, uint32_t pos) : data_(data), pos_(pos) {
+    }
+
+    bool write(uint64_t value, unsigned count) {
+        if (SampleBlock::kCapacityBits - pos_ < count) {
+            overflow_ = true;
+            return false;
+        }
+        while (count > 0) {
+            unsigned room = 8 - pos_ % 8;
+            unsigned take = std::min(room, count);
+            unsigned shift = room - take;
+            auto mask = static_cast<uint8_t>(((1u << take) - 1) << shift);
+            auto chunk = static_cast<uint8_t>(((value >> (count - take)) & ((1u << take) - 1)) << shift);
+            uint8_t& byte = data_[pos_ / 8];
+            byte = static_cast<uint8_t>((byte & ~mask) | chunk);
+            pos_ += take;
+            count -= take;
+        }
+        return true;
+    }
+
+    uint32_t pos() const {
+        return pos_;
+    }
+
+    bool overflow() const {
+        return overflow_;
+    }
+
+private:
+    uint8_t* data_;
+    uint32_t pos_;
+    bool overflow_ = false;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, uint32_t pos, uint32_t end) : data_(data), pos_(pos), end_(end) {
+    }
+
+    uint64_t read(unsigned count) {
+        if (end_ - pos_ < count) {
+            overflow_ = true;
+            pos_ = end_;
+            return 0;
+        }
+        uint64_t value = 0;
+        while (count > 0) {
+            unsigned room = 8 - pos_ % 8;
+            unsigned take = std::min(room, count);
+            unsigned shift = room - take;
+            value = (value << take) | ((data_[pos_ / 8] >> shift) & ((1u << take) - 1));
+            pos_ += take;
+            count -= take;
+        }
+        return value;
+    }
+
+    uint32_t pos() const {
+        return pos_;
+    }
+
+    bool overflow() const {
+        return overflow_;
+    }
+
+private:
+    const uint8_t* data_;
+    uint32_t pos_;
+    uint32_t end_;
+    bool overflow_ = false;
+};
+
+void writeValue(BitWriter& out, SampleBlock::State& state, size_t index, uint32_t value) {
+    uint32_t x = value ^ state.values[index];
+    state.values[index] = value;
+    if (!x) {
+        out.write(0, 1);
+        return;
+    }
+    unsigned leading = leadingZeros(x);
+    unsigned trailing = trailingZeros(x);
+    if (state.leading[index] != 0xff && leading >= state.leading[index] && trailing >= state.trailing[index]) {
+        // Meaningful bits fit into the window of the previous value
+        out.write(2, 2);
+        out.write(x >> state.trailing[index], 32 - state.leading[index] - state.trailing[index]);
+        return;
+    }
+    unsigned length = 32 - leading - trailing;
+    out.write(3, 2);
+    out.write(leading, 5);
+    out.write(length - 1, 5);
+    out.write(x >> trailing, length);
+    state.leading[index] = static_cast<uint8_t>(leading);
+    state.trailing[index] = static_cast<uint8_t>(trailing);
+}
+
+bool readValue(BitReader& in, SampleBlock::State& state, size_t index) {
+    if (!in.read(1)) {
+        return !in.overflow();
+    }
+    if (in.read(1)) {
+        state.leading[index] = static_cast<uint8_t>(in.read(5));
+        unsigned length = static_cast<unsigned>(in.read(5)) + 1;
+        if (state.leading[index] + length > 32) {
+            return false;
+        }
+        state.trailing[index] = static_cast<uint8_t>(32 - state.leading[index] - length);
+    } else if (state.leading[index] == 0xff) {
+        return false;
+    }
+    unsigned shift = state.trailing[index];
+    auto x = static_cast<uint32_t>(in.read(32 - state.leading[index] - shift) << shift);
+    state.values[index] ^= x;
+    return !in.overflow();
+}
+
+void addToSummary(SampleSummary& summary, float value, bool first) {
+    if (first) {
+        summary.minimum = summary.maximum = value;
+        summary.sum = 0.0;
+    } else {
+        summary.minimum = std::min(summary.minimum, value);
+        summary.maximum = std::max(summary.maximum, value);
+    }
+    summary.sum += value;
+}
+
+}
+
+void SampleBlock::Writer::start(void* block) {
+    header_ = static_cast<SampleBlockHeader*>(block);
+    data_ = static_cast<uint8_t*>(block) + sizeof(SampleBlockHeader);
+    *header_ = SampleBlockHeader();
+    state_ = State();
+}
+
+bool SampleBlock::Writer::resume(void* block, uint32_t count, uint32_t bits) {
+    header_ = static_cast<SampleBlockHeader*>(block);
+    data_ = static_cast<uint8_t*>(block) + sizeof(SampleBlockHeader);
+    SampleBlockHeader saved = *header_;
+    header_->count = count;
+    header_->bits = bits;
+
+    // The header may be ahead of the committed samples after a crash
+    SampleBlockHeader rebuilt = SampleBlockHeader();
+    rebuilt.firstTime = saved.firstTime;
+    Reader reader(block);
+    HistoryRecord record;
+    while (reader.next(record)) {
+        bool first = rebuilt.count == 0;
+        addToSummary(rebuilt.download, record.download, first);
+        addToSummary(rebuilt.upload, record.upload, first);
+        rebuilt.lastTime = record.time;
+        rebuilt.count++;
+    }
+    if (rebuilt.count != count || reader.state().bits != bits) {
+        return false;
+    }
+    rebuilt.bits = bits;
+    *header_ = rebuilt;
+    state_ = reader.state();
+    return true;
+}
+
+bool SampleBlock::Writer::append(const HistoryRecord& record) {
+    State state = state_;
+    BitWriter out(data_, state.bits);
+    if (state.count) {
+        int64_t delta = record.time - state.time;
+        int64_t dod = delta - state.delta;
+        uint64_t zigzag = (static_cast<uint64_t>(dod) << 1) ^ static_cast<uint64_t>(dod >> 63);
+        if (!zigzag) {
+            out.write(0, 1);
+        } else if (zigzag < (1u << kDeltaBits[0])) {
+            out.write(2, 2);
+            out.write(zigzag, kDeltaBits[0]);
+        } else if (zigzag < (1u << kDeltaBits[1])) {
+            out.write(6, 3);
+            out.write(zigzag, kDeltaBits[1]);
+        } else if (zigzag < (1u << kDeltaBits[2])) {
+            out.write(14, 4);
+            out.write(zigzag, kDeltaBits[2]);
+        } else {
+            out.write(15, 4);
+            out.write(zigzag, 64);
+        }
+        state.delta = delta;
+    }
+    state.time = record.time;
+    writeValue(out, state, 0, floatBits(record.download));
+    writeValue(out, state, 1, floatBits(record.upload));
+    if (out.overflow()) {
+        return false;
+    }
+
+    bool first = state.count == 0;
+    if (first) {
+        header_->firstTime = record.time;
+    }
+    header_->lastTime = record.time;
+    addToSummary(header_->download, record.download, first);
+    addToSummary(header_->upload, record.upload, first);
+    state.count++;
+    state.bits = out.pos();
+    header_->count = state.count;
+    header_->bits = state.bits;
+    state_ = state;
+    return true;
+}
+
+const SampleBlockHeader& SampleBlock::Writer::header() const {
+    return *header_;
+}
+
+SampleBlock::Reader::Reader(const void* block) :
+    header_(static_cast<const SampleBlockHeader*>(block)),
+    data_(static_cast<const uint8_t*>(block) + sizeof(SampleBlockHeader)) {
+}
+
+bool SampleBlock::Reader::next(HistoryRecord& record) {
+    if (state_.count >= header_->count || header_->bits > kCapacityBits) {
+        return false;
+    }
+    State state = state_;
+    BitReader in(data_, state.bits, header_->bits);
+    if (!state.count) {
+        state.time = header_->firstTime;
+    } else {
+        int64_t zigzag;
+        if (!in.read(1)) {
+            zigzag = 0;
+        } else if (!in.read(1)) {
+            zigzag = static_cast<int64_t>(in.read(kDeltaBits[0]));
+        } else if (!in.read(1)) {
+            zigzag = static_cast<int64_t>(in.read(kDeltaBits[1]));
+        } else if (!in.read(1)) {
+            zigzag = static_cast<int64_t>(in.read(kDeltaBits[2]));
+        } else {
+            zigzag = static_cast<int64_t>(in.read(64));
+        }
+        auto value = static_cast<uint64_t>(zigzag);
+        int64_t dod = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        state.delta += dod;
+        state.time += state.delta;
+    }
+    if (!readValue(in, state, 0) || !readValue(in, state, 1) || in.overflow()) {
+        return false;
+    }
+    state.count++;
+    state.bits = in.pos();
+    state_ = state;
+
+    record.time = state.time;
+    record.download = bitsFloat(state.values[0]);
+    record.upload = bitsFloat(state.values[1]);
+    return true;
+}
+
+const SampleBlock::State& SampleBlock::Reader::state() const {
+    return state_;
+}
@@ -0,0 +1,96 @@
+#ifndef KEENETIC_PLUGIN_SAMPLEBLOCK_H
+#define KEENETIC_PLUGIN_SAMPLEBLOCK_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct HistoryRecord {
+    // Unix time, milliseconds
+    int64_t time;
+    float download;
+    float upload;
+};
+
+struct SampleSummary {
+    float minimum = 0.0f;
+    float maximum = 0.0f;
+    double sum = 0.0;
+};
+
+/**
+ * Fixed-size block of speed samples compressed in the manner of Facebook's Gorilla:
+ * timestamps are stored as the difference between consecutive deltas, which is zero for evenly
+ * spaced samples, and values as the XOR with the previous value, which has few meaningful bits
+ * when the speed changes slowly and none when it does not change.
+ *
+ * The header keeps the time range and the minimum, maximum and sum of the values,
+ * so aggregates over whole blocks do not need decoding.
+ */
+struct SampleBlockHeader {
+    int64_t firstTime;
+    int64_t lastTime;
+    uint32_t count;
+    // Length of the encoded samples, in bits
+    uint32_t bits;
+    SampleSummary download;
+    SampleSummary upload;
+};
+
+class SampleBlock {
+public:
+    static constexpr size_t kSize = 4096;
+    static constexpr uint32_t kCapacityBits = static_cast<uint32_t>((kSize - sizeof(SampleBlockHeader)) * 8);
+
+    // State shared by the encoder and the decoder, so that an encoder may continue a decoded block
+    struct State {
+        int64_t time = 0;
+        int64_t delta = 0;
+        uint32_t values[2] = {};
+        // Meaningful bits of the previous XOR of each value, 0xff when there was none
+        uint8_t leading[2] = { 0xff, 0xff };
+        uint8_t trailing[2] = {};
+        uint32_t count = 0;
+        uint32_t bits = 0;
+    };
+
+    class Writer {
+    public:
+        // Starts a new empty block in the memory of kSize bytes
+        void start(void* block);
+
+        /**
+         * Continues the block, trusting only the first count samples encoded in bits.
+         * The header is rebuilt from the samples. Returns false if they cannot be decoded.
+         */
+        bool resume(void* block, uint32_t count, uint32_t bits);
+
+        // Returns false if the block is full, the record is then not added
+        bool append(const HistoryRecord& record);
+
+        const SampleBlockHeader& header() const;
+
+    private:
+        SampleBlockHeader* header_ = nullptr;
+        uint8_t* data_ = nullptr;
+        State state_;
+    };
+
+    class Reader {
+    public:
+        Reader(const void* block);
+
+        // Returns false after the last sample or if the block is damaged
+        bool next(HistoryRecord& record);
+
+        const State& state() const;
+
+    private:
+        const SampleBlockHeader* header_;
+        const uint8_t* data_;
+        State state_;
+    };
+};
+
+#endif
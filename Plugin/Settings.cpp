@@ -0,0 +1,121 @@
+#include "Settings.h"
+
+#include <Windows.h>
+
+#include <algorithm>
+
+#include "API/RainmeterAPI.h"
+#include "Core/Utils/CoreUtils.h"
+#include "Core/Utils/StringUtils.h"
+
+namespace {
+
+double GetPrivateProfileDouble(LPCTSTR section, LPCTSTR key, double def, LPCTSTR path)
+{
+    TCHAR buf[100] {'\0'};
+    ::GetPrivateProfileString(section, key, L"NOTFOUND", buf, std::size(buf), path);
+
+    if (::wcscmp(buf, L"NOTFOUND") == 0 || ::wcscmp(buf, L"") == 0) {
+        return def;
+    }
+    return ::_wtof(buf);
+}
+
+bool compileFieldPath(void* rm, LPCWSTR routerID, LPCWSTR option, LPCWSTR value, JsonFieldPath& path) {
+    std::string error;
+    if (!path.compile(IuCoreUtils::WstringToUtf8(value), error)) {
+        RmLog(rm, LOG_ERROR, (std::wstring(L"Invalid ") + option + L" '" + value + L"' for " + routerID + L": " + IuCoreUtils::Utf8ToWstring(error)).c_str());
+        return false;
+    }
+    return true;
+}
+
+}
+
+std::unique_ptr<Settings> SettingsLoader::loadSettings(void* rm, const wchar_t* routerID, const wchar_t* configFile) {
+    WCHAR loginW[256]{};
+    WCHAR passwordW[256]{};
+    WCHAR urlW[256]{};
+    WCHAR proxyW[256]{};
+    WCHAR interfaceW[1024]{};
+    WCHAR commandW[256] {};
+    WCHAR requestTypeW[50] {};
+    WCHAR downloadFieldW[256] {};
+    WCHAR uploadFieldW[256] {};
+    WCHAR parserW[50] {};
+    WCHAR sourceW[50] {};
+    WCHAR historyPathW[MAX_PATH] {};
+
+
+    GetPrivateProfileString(routerID, L"URL", L"http://192.168.1.1", urlW, std::size(urlW), configFile);
+    GetPrivateProfileString(routerID, L"Login", L"admin", loginW, std::size(loginW), configFile);
+    GetPrivateProfileString(routerID, L"Password", L"", passwordW, std::size(passwordW), configFile);
+    GetPrivateProfileString(routerID, L"Proxy", L"", proxyW, std::size(proxyW), configFile);
+    GetPrivateProfileString(routerID, L"Interface", L"ISP", interfaceW, std::size(interfaceW), configFile);
+    GetPrivateProfileString(routerID, L"Command", L"", commandW, std::size(commandW), configFile);
+    GetPrivateProfileString(routerID, L"RequestType", L"", requestTypeW, std::size(requestTypeW), configFile);
+    GetPrivateProfileString(routerID, L"DownloadField", L"", downloadFieldW, std::size(downloadFieldW), configFile);
+    GetPrivateProfileString(routerID, L"UploadField", L"", uploadFieldW, std::size(uploadFieldW), configFile);
+    GetPrivateProfileString(routerID, L"Parser", L"", parserW, std::size(parserW), configFile);
+    GetPrivateProfileString(routerID, L"Source", L"", sourceW, std::size(sourceW), configFile);
+    GetPrivateProfileString(routerID, L"HistoryPath", L"", historyPathW, std::size(historyPathW), configFile);
+    
+
+    if (!lstrlen(passwordW)) {
+        RmLog(rm, LOG_ERROR, (std::wstring(L"No password set for ") + routerID + std::wstring(L" in config file ") + configFile).c_str());
+        return {};
+    }
+
+    std::unique_ptr<Settings> res = std::make_unique<Settings>();
+    res->downloadDivider = GetPrivateProfileDouble(routerID, L"DownloadDivider", 1000000.0, configFile);
+    res->uploadDivider = GetPrivateProfileDouble(routerID, L"UploadDivider", 1000000.0, configFile);
+
+    res->proxyPort = GetPrivateProfileInt(routerID, L"ProxyPort", 8080, configFile);
+    res->pollInterval = std::max(100, static_cast<int>(GetPrivateProfileInt(routerID, L"PollInterval", 1000, configFile)));
+    res->requestTimeout = std::max(100, static_cast<int>(GetPrivateProfileInt(routerID, L"RequestTimeout", 5000, configFile)));
+    res->backfill = GetPrivateProfileInt(routerID, L"Backfill", 1, configFile) != 0;
+    res->backfillDetail = std::max(0, static_cast<int>(GetPrivateProfileInt(routerID, L"BackfillDetail", 1, configFile)));
+    res->phaseAlign = GetPrivateProfileInt(routerID, L"PhaseAlign", 1, configFile) != 0;
+    res->historyDays = std::max(0, static_cast<int>(GetPrivateProfileInt(routerID, L"HistoryDays", 7, configFile)));
+
+    // History files are kept next to Rainmeter.data by default
+    res->historyPath = historyPathW;
+    if (res->historyPath.empty()) {
+        std::wstring config = configFile;
+        size_t pos = config.find_last_of(L"\\/");
+        res->historyPath = (pos != std::wstring::npos ? config.substr(0, pos + 1) : std::wstring()) + L"KeeneticPlugin";
+    }
+
+    if (!lstrcmpi(parserW, L"jsoncpp")) {
+        res->parser = ResponseParser::JsonCpp;
+    } else if (!lstrcmpi(parserW, L"simdjson")) {
+#ifdef KEENETIC_WITH_SIMDJSON
+        res->parser = ResponseParser::SimdJson;
+#else
+        RmLog(rm, LOG_WARNING, L"The plugin is built without simdjson, using the default parser");
+#endif
+    } else if (lstrlen(parserW)) {
+        RmLog(rm, LOG_WARNING, (std::wstring(L"Unknown parser '") + parserW + L"' for " + routerID + L", using the default one").c_str());
+    }
+
+    if (!lstrcmpi(sourceW, L"counters")) {
+        res->source = SpeedSource::Counters;
+    } else if (lstrlen(sourceW) && lstrcmpi(sourceW, L"rrd")) {
+        RmLog(rm, LOG_WARNING, (std::wstring(L"Unknown source '") + sourceW + L"' for " + routerID + L", using rrd").c_str());
+    }
+
+    res->routerID = routerID;
+    res->routerUrl = IuCoreUtils::WstringToUtf8(urlW);
+    res->login = IuCoreUtils::WstringToUtf8(loginW);
+    res->password = IuCoreUtils::WstringToUtf8(passwordW);
+    res->proxy = IuCoreUtils::WstringToUtf8(proxyW);
+    res->command = IuCoreUtils::WstringToUtf8(commandW);
+    res->requestType = IuCoreUtils::WstringToUtf8(requestTypeW);
+    if (!compileFieldPath(rm, routerID, L"DownloadField", downloadFieldW, res->downloadField)
+        || !compileFieldPath(rm, routerID, L"UploadField", uploadFieldW, res->uploadField)) {
+        return {};
+    }
+    std::string interfaces = IuCoreUtils::WstringToUtf8(interfaceW);
+    IuStringUtils::Split(interfaces, ",", res->interfaces);
+    return res;
+}
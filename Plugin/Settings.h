@@ -0,0 +1,64 @@
+#ifndef KEENETIC_PLUGIN_SETTINGS_H
+#define KEENETIC_PLUGIN_SETTINGS_H
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "JsonFieldPath.h"
+
+enum class ResponseParser {
+    // Streaming parser for the default command, jsoncpp for custom commands
+    Default,
+    JsonCpp,
+    // Available if built with KEENETIC_WITH_SIMDJSON
+    SimdJson
+};
+
+enum class SpeedSource {
+    // Speeds averaged by the router, show/interface/rrd
+    Rrd,
+    // Rates computed locally from the byte counters of show/interface/stat
+    Counters
+};
+
+struct Settings{
+    std::wstring routerID;
+    std::string routerUrl;
+    std::string login;
+    std::string password;
+    std::string proxy;
+    std::string command;
+    std::string requestType;
+    // Fields of a custom command response, compiled once on load
+    JsonFieldPath downloadField;
+    JsonFieldPath uploadField;
+    double downloadDivider{};
+    double uploadDivider{};
+
+    std::vector<std::string> interfaces;
+    int proxyPort = 0;
+    int pollInterval = 1000;
+    // Limit for a whole request, in milliseconds
+    int requestTimeout = 5000;
+    bool phaseAlign = true;
+    ResponseParser parser = ResponseParser::Default;
+    // Used with the default command only
+    SpeedSource source = SpeedSource::Rrd;
+    // Load the router's own history at this detail level on startup and after gaps
+    bool backfill = true;
+    int backfillDetail = 1;
+    // Directory of the history files and the number of days they keep, zero disables them
+    std::wstring historyPath;
+    int historyDays = 7;
+};
+
+class SettingsLoader
+{
+public:
+    static std::unique_ptr<Settings> loadSettings(void* rm, const wchar_t* routerID, const wchar_t* configFile);
+};
+
+#endif
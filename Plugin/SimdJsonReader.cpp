@@ -0,0 +1,255 @@
+#include "SimdJsonReader.h"
+
+#ifdef KEENETIC_WITH_SIMDJSON
+
+#include <cstring>
+
+using namespace simdjson;
+
+namespace {
+
+double readNumber(simdjson_result<ondemand::value> value) {
+    ondemand::json_type type;
+    if (value.type().get(type) != SUCCESS) {
+        return 0.0;
+    }
+    if (type == ondemand::json_type::number) {
+        double number;
+        return value.get_double().get(number) == SUCCESS ? number : 0.0;
+    }
+    if (type == ondemand::json_type::string) {
+        std::string_view str;
+        if (value.get_string().get(str) == SUCCESS) {
+            return JsonFieldPath::parseNumber(str.data(), str.data() + str.size());
+        }
+    }
+    return 0.0;
+}
+
+bool readCounter(simdjson_result<ondemand::value> value, uint64_t& res) {
+    ondemand::json_type type;
+    if (value.type().get(type) != SUCCESS) {
+        return false;
+    }
+    if (type == ondemand::json_type::number) {
+        return value.get_uint64().get(res) == SUCCESS;
+    }
+    if (type == ondemand::json_type::string) {
+        std::string_view str;
+        return value.get_string().get(str) == SUCCESS && ResponseReader::parseCounter(str.data(), str.data() + str.size(), res);
+    }
+    return false;
+}
+
+double readPath(simdjson_result<ondemand::value> value, const std::vector<JsonFieldPath::Component>& components, size_t from) {
+    for (size_t k = from; k < components.size(); ++k) {
+        const JsonFieldPath::Component& component = components[k];
+        if (component.isIndex) {
+            value = value.get_array().at(component.index);
+        } else {
+            value = value.find_field_unordered(component.key);
+        }
+    }
+    return readNumber(value);
+}
+
+}
+
+bool SimdJsonReader::readRrd(std::string_view body, std::vector<RrdSeries>& series, bool withSamples) {
+    ondemand::array array;
+    if (!iterate(body, array)) {
+        return false;
+    }
+    size_t count = 0;
+    for (auto element : array) {
+        ondemand::object item;
+        if (auto error = element.get_object().get(item)) {
+            return fail(error);
+        }
+        if (count == series.size()) {
+            series.emplace_back();
+        }
+        RrdSeries& s = series[count++];
+        s.value = 0.0;
+        s.time = 0;
+        s.hasValue = false;
+        s.failed = false;
+        s.message.clear();
+        s.samples.clear();
+
+        ondemand::array status;
+        if (item.find_field_unordered("status").get_array().get(status) == SUCCESS) {
+            // Only the first entry is examined, like the other parsers do
+            for (auto entry : status) {
+                if (auto error = entry.error()) {
+                    return fail(error);
+                }
+                std::string_view str;
+                if (entry.find_field_unordered("status").get_string().get(str) == SUCCESS && str == "error") {
+                    s.failed = true;
+                    std::string_view message;
+                    if (entry.find_field_unordered("message").get_string().get(message) == SUCCESS) {
+                        s.message.assign(message.data(), message.size());
+                    }
+                }
+                break;
+            }
+        }
+
+        ondemand::array data;
+        if (item.find_field_unordered("data").get_array().get(data) == SUCCESS) {
+            for (auto element : data) {
+                ondemand::object sample;
+                if (auto error = element.get_object().get(sample)) {
+                    return fail(error);
+                }
+                RrdSample parsed;
+                double number;
+                if (sample.find_field_unordered("v").get_double().get(number) == SUCCESS) {
+                    parsed.value = number;
+                }
+                if (sample.find_field_unordered("t").get_double().get(number) == SUCCESS) {
+                    parsed.time = static_cast<int64_t>(number);
+                }
+                if (!s.hasValue) {
+                    s.hasValue = true;
+                    s.value = parsed.value;
+                    s.time = parsed.time;
+                }
+                if (!withSamples) {
+                    // Samples are ordered from the newest one, the rest are needed only for the history
+                    break;
+                }
+                s.samples.push_back(parsed);
+            }
+        }
+    }
+    series.resize(count);
+    return finish();
+}
+
+bool SimdJsonReader::readCounters(std::string_view body, std::vector<InterfaceCounters>& counters) {
+    ondemand::array array;
+    if (!iterate(body, array)) {
+        return false;
+    }
+    size_t count = 0;
+    for (auto element : array) {
+        if (count == counters.size()) {
+            counters.emplace_back();
+        }
+        InterfaceCounters& c = counters[count++];
+        c = InterfaceCounters();
+
+        ondemand::object item;
+        if (auto error = element.get_object().get(item)) {
+            return fail(error);
+        }
+        ondemand::array status;
+        if (item.find_field_unordered("status").get_array().get(status) == SUCCESS) {
+            for (auto entry : status) {
+                if (auto error = entry.error()) {
+                    return fail(error);
+                }
+                std::string_view str;
+                if (entry.find_field_unordered("status").get_string().get(str) == SUCCESS && str == "error") {
+                    c.failed = true;
+                    std::string_view message;
+                    if (entry.find_field_unordered("message").get_string().get(message) == SUCCESS) {
+                        c.message.assign(message.data(), message.size());
+                    }
+                }
+                break;
+            }
+        }
+        c.hasValue = readCounter(item.find_field_unordered(kRxBytesField), c.rxBytes)
+            && readCounter(item.find_field_unordered(kTxBytesField), c.txBytes);
+    }
+    counters.resize(count);
+    return finish();
+}
+
+bool SimdJsonReader::readFields(std::string_view body, const std::vector<const JsonFieldPath*>& fields,
+    std::vector<double>& values) {
+    ondemand::array array;
+    if (!iterate(body, array)) {
+        return false;
+    }
+    values.clear();
+    for (auto element : array) {
+        ondemand::json_type type;
+        if (auto error = element.type().get(type)) {
+            return fail(error);
+        }
+
+        if (type == ondemand::json_type::object || type == ondemand::json_type::array) {
+            ondemand::object object;
+            ondemand::array items;
+            bool isObject = type == ondemand::json_type::object;
+            if (auto error = isObject ? element.get_object().get(object) : element.get_array().get(items)) {
+                return fail(error);
+            }
+            for (const JsonFieldPath* field : fields) {
+                const auto& components = field->components();
+                double value = 0.0;
+                // Every field is looked up from the beginning of the element
+                if (components.empty()) {
+                    value = 0.0;
+                } else if (isObject) {
+                    object.reset();
+                    if (!components[0].isIndex) {
+                        value = readPath(object.find_field_unordered(components[0].key), components, 1);
+                    }
+                } else {
+                    items.reset();
+                    if (components[0].isIndex) {
+                        value = readPath(items.at(components[0].index), components, 1);
+                    }
+                }
+                values.push_back(value);
+            }
+        } else {
+            // A scalar can be read only once
+            double value = readNumber(element);
+            for (const JsonFieldPath* field : fields) {
+                values.push_back(field->empty() ? value : 0.0);
+            }
+        }
+    }
+    return finish();
+}
+
+bool SimdJsonReader::iterate(std::string_view body, ondemand::array& array) {
+    size_t size = body.size();
+    if (buffer_.size() < size + SIMDJSON_PADDING) {
+        buffer_.resize(size + SIMDJSON_PADDING);
+    }
+    std::memcpy(buffer_.data(), body.data(), size);
+
+    if (auto error = parser_.iterate(buffer_.data(), size, buffer_.size()).get(document_)) {
+        return fail(error);
+    }
+    if (auto error = document_.get_array().get(array)) {
+        return fail(error);
+    }
+    return true;
+}
+
+bool SimdJsonReader::finish() {
+    // The iterator is released on a structural error, which is not reported by the loops above
+    if (!document_.is_alive()) {
+        return fail(TAPE_ERROR);
+    }
+    // On-Demand validates only the parts being accessed, make sure nothing follows the array
+    if (!document_.at_end()) {
+        return fail(TRAILING_CONTENT);
+    }
+    return true;
+}
+
+bool SimdJsonReader::fail(error_code error) {
+    error_ = error_message(error);
+    return false;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef KEENETIC_PLUGIN_SIMDJSONREADER_H
+#define KEENETIC_PLUGIN_SIMDJSONREADER_H
+
+#pragma once
+
+#ifdef KEENETIC_WITH_SIMDJSON
+
+#include <vector>
+
+#include <simdjson.h>
+
+#include "ResponseReader.h"
+
+/**
+ * Reads responses with the simdjson On-Demand API, which parses only the values being accessed.
+ * Pays off on large responses of custom commands (show/interface, show/ip/hotspot).
+ */
+class SimdJsonReader : public ResponseReader {
+public:
+    bool readRrd(std::string_view body, std::vector<RrdSeries>& series, bool withSamples) override;
+    bool readCounters(std::string_view body, std::vector<InterfaceCounters>& counters) override;
+    bool readFields(std::string_view body, const std::vector<const JsonFieldPath*>& fields,
+        std::vector<double>& values) override;
+
+private:
+    bool iterate(std::string_view body, simdjson::ondemand::array& array);
+    bool finish();
+    bool fail(simdjson::error_code error);
+
+    simdjson::ondemand::parser parser_;
+    simdjson::ondemand::document document_;
+    // simdjson reads past the end of the input, so the response is copied to a padded buffer
+    std::vector<char> buffer_;
+};
+
+#endif
+
+#endif
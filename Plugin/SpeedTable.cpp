@@ -0,0 +1,75 @@
+#include "SpeedTable.h"
+
+#include <algorithm>
+#include <thread>
+
+SpeedTable::SpeedTable(size_t size) :
+    size_(size),
+    download_(std::make_unique<std::atomic<double>[]>(size)),
+    upload_(std::make_unique<std::atomic<double>[]>(size)) {
+    for (size_t i = 0; i < size_; i++) {
+        download_[i].store(0.0, std::memory_order_relaxed);
+        upload_[i].store(0.0, std::memory_order_relaxed);
+    }
+}
+
+size_t SpeedTable::size() const {
+    return size_;
+}
+
+template<class Func>
+void SpeedTable::writeSequenced(Func&& func) {
+    uint64_t seq = seq_.load(std::memory_order_relaxed);
+    // Odd sequence number means that a write is in progress
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    func();
+    seq_.store(seq + 2, std::memory_order_release);
+}
+
+template<class Func>
+void SpeedTable::readSequenced(Func&& func) const {
+    for (;;) {
+        uint64_t before = seq_.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        func();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) == before) {
+            return;
+        }
+    }
+}
+
+void SpeedTable::publish(const std::vector<InterfaceSpeed>& speeds) {
+    size_t count = std::min(size_, speeds.size());
+    writeSequenced([&] {
+        for (size_t i = 0; i < count; i++) {
+            download_[i].store(speeds[i].download, std::memory_order_relaxed);
+            upload_[i].store(speeds[i].upload, std::memory_order_relaxed);
+        }
+    });
+}
+
+void SpeedTable::clear() {
+    writeSequenced([&] {
+        for (size_t i = 0; i < size_; i++) {
+            download_[i].store(0.0, std::memory_order_relaxed);
+            upload_[i].store(0.0, std::memory_order_relaxed);
+        }
+    });
+}
+
+InterfaceSpeed SpeedTable::read(size_t index) const {
+    InterfaceSpeed res;
+    if (index >= size_) {
+        return res;
+    }
+    readSequenced([&] {
+        res.download = download_[index].load(std::memory_order_relaxed);
+        res.upload = upload_[index].load(std::memory_order_relaxed);
+    });
+    return res;
+}
@@ -0,0 +1,50 @@
+#ifndef KEENETIC_PLUGIN_SPEEDTABLE_H
+#define KEENETIC_PLUGIN_SPEEDTABLE_H
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Core/Utils/CoreTypes.h"
+
+struct InterfaceSpeed {
+    double download = 0.0;
+    double upload = 0.0;
+};
+
+/**
+ * Latest speeds of all interfaces of a router.
+ *
+ * The worker builds a complete snapshot off-lock and publishes it with publish(),
+ * measures read it without taking any lock (seqlock). A reader retries only if it
+ * overlaps with a publish(), which copies just a few numbers.
+ *
+ * Single writer, any number of readers.
+ */
+class SpeedTable {
+public:
+    explicit SpeedTable(size_t size);
+
+    size_t size() const;
+
+    void publish(const std::vector<InterfaceSpeed>& speeds);
+    void clear();
+
+    InterfaceSpeed read(size_t index) const;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(SpeedTable);
+
+    template<class Func> void writeSequenced(Func&& func);
+    template<class Func> void readSequenced(Func&& func) const;
+
+    size_t size_;
+    std::atomic<uint64_t> seq_{ 0 };
+    std::unique_ptr<std::atomic<double>[]> download_;
+    std::unique_ptr<std::atomic<double>[]> upload_;
+};
+
+#endif
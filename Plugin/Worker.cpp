@@ -0,0 +1,864 @@
+#include "Worker.h"
+
+#include <algorithm>
+#include <cwctype>
+#include <sstream>
+
+#include <json/json.h>
+#include <json/value.h>
+
+#include "API/RainmeterAPI.h"
+#include "Core/Network/NetworkClient.h"
+#include "Core/Utils/CoreUtils.h"
+#include "Core/Utils/CryptoUtils.h"
+
+namespace {
+
+// Number of polls over which the scheduler statistics are collected before being reported
+constexpr uint64_t kSchedulerStatsWindow = 60;
+
+// Number of missed poll intervals after which the history is backfilled from the router
+constexpr int64_t kGapPolls = 3;
+
+// The history files are loaded on startup in chunks of this length, other routers are polled in between
+constexpr int64_t kHistoryLoadChunk = 60 * 60 * 1000;
+
+// Rollup buckets per point of a graph, LTTB needs a choice of points to pick the peaks from
+constexpr int64_t kPlotOversampling = 4;
+
+// Statistics over arbitrary ranges are computed from about this many rollup buckets
+constexpr int64_t kStatisticBuckets = 600;
+
+// Statistics over longer ranges, in seconds, are computed from the history file if there is one:
+// exactly at the range boundaries, where rollups are coarse, while blocks inside the range are not decoded
+constexpr int64_t kFileStatisticRange = 60 * 60;
+
+// Compressed size of a sample of noisy traffic, the history files are sized by it
+constexpr int64_t kHistoryBytesPerSample = 8;
+
+int64_t steadyTimeMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(PollScheduler::Clock::now().time_since_epoch()).count();
+}
+
+// History files outlive the process, so they are indexed by the system clock
+int64_t wallTimeMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+double statisticValue(AggregateType type, double minimum, double maximum, double sum, uint64_t count) {
+    switch (type) {
+    case AggregateType::Peak:
+        return maximum;
+    case AggregateType::Minimum:
+        return minimum;
+    default:
+        return count ? sum / count : 0.0;
+    }
+}
+
+std::wstring historyFileName(const Settings& settings, const std::string& interf) {
+    std::wstring name = settings.routerID + L"-" + IuCoreUtils::Utf8ToWstring(interf);
+    std::replace_if(name.begin(), name.end(), [](wchar_t c) {
+        return !std::iswalnum(c) && c != L'-' && c != L'_' && c != L'.';
+    }, L'_');
+    return settings.historyPath + L"\\" + name + L".hist";
+}
+
+}
+
+Worker::Worker(void *rm, std::shared_ptr<Settings> settings, CurlMultiReactor* reactor):
+    scheduler_(std::chrono::milliseconds(settings->pollInterval)),
+    subscribers_(settings->interfaces.size()),
+    routerTimeline_(settings->interfaces.size()),
+    freshSlots_(settings->interfaces.size()),
+    sampleTimes_(std::make_unique<std::atomic<int64_t>[]>(settings->interfaces.size())),
+    pendingSpeeds_(settings->interfaces.size()),
+    speeds_(settings->interfaces.size()),
+    history_(settings->interfaces.size(), std::chrono::milliseconds(settings->pollInterval)),
+    counterRates_(settings->interfaces.size(), ByteCounterRate(kGapPolls * settings->pollInterval * 1000)) {
+    scheduler_.setPhaseAlignment(settings->phaseAlign);
+    reader_ = ResponseReader::create(settings->parser);
+    customFields_ = { &settings->downloadField, &settings->uploadField };
+
+    for (size_t i = 0; i < settings->interfaces.size(); i++) {
+        interfaceIndex_.emplace(settings->interfaces[i], i);
+        sampleTimes_[i].store(0, std::memory_order_relaxed);
+    }
+    // Measures without Interface option use the first interface in alphabetical order
+    if (!interfaceIndex_.empty()) {
+        defaultInterfaceIndex_ = interfaceIndex_.begin()->second;
+    }
+    rm_ = rm;
+    settings_ = std::move(settings);
+    reactor_ = reactor;
+}
+
+Worker::~Worker() {
+    try {
+        abort();
+    } catch(...) {
+
+    }
+}
+
+void Worker::start() {
+    if (started_) {
+        return;
+    }
+    started_ = true;
+    reactor_->post([this] {
+        init();
+        // Polling starts once the history is loaded, live samples must follow the loaded ones
+        loadHistory();
+    });
+}
+
+void Worker::abort() {
+    if (!started_ || stopped_) {
+        return;
+    }
+    stopped_ = true;
+
+    // After this call the reactor holds no references to this object
+    reactor_->invoke([this] {
+        if (pollTimer_) {
+            reactor_->cancelTimer(pollTimer_);
+            pollTimer_ = 0;
+        }
+        if (historyLoadTimer_) {
+            reactor_->cancelTimer(historyLoadTimer_);
+            historyLoadTimer_ = 0;
+        }
+        if (nc_) {
+            cancelRequest();
+            if (authenticated) {
+                logout();
+            }
+            nc_ = nullptr;
+        }
+        clearData();
+        std::lock_guard<std::mutex> lk(historyFilesMutex_);
+        historyFiles_.clear();
+    });
+}
+
+void Worker::setProxyPort(int port) {
+    proxyPort_ = port;
+}
+
+size_t Worker::resolveInterface(const std::string& interf) const {
+    if (interf.empty()) {
+        return defaultInterfaceIndex_;
+    }
+    auto it = interfaceIndex_.find(interf);
+    return it != interfaceIndex_.end() ? it->second : speeds_.size();
+}
+
+bool Worker::isValidSlot(size_t slot) const {
+    return slot < speeds_.size();
+}
+
+double Worker::getUploadSpeed(size_t slot) const {
+    return speeds_.read(slot).upload;
+}
+
+double Worker::getDownloadSpeed(size_t slot) const {
+    return speeds_.read(slot).download;
+}
+
+void Worker::subscribe(size_t slot) {
+    if (!isValidSlot(slot)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lk(subscriptionMutex_);
+    if (subscribers_[slot]++ == 0) {
+        subscriptionVersion_++;
+    }
+}
+
+void Worker::unsubscribe(size_t slot) {
+    if (!isValidSlot(slot)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lk(subscriptionMutex_);
+    if (subscribers_[slot] > 0 && --subscribers_[slot] == 0) {
+        subscriptionVersion_++;
+    }
+}
+
+void Worker::notifyUpdate() {
+    lastFrameTime_ = PollScheduler::Clock::now().time_since_epoch().count();
+}
+
+double Worker::getPollJitter() const {
+    return pollJitter_;
+}
+
+double Worker::getAggregate(size_t slot, Direction direction, AggregateType type, AggregateWindow window) const {
+    return history_.read(slot, direction, type, window);
+}
+
+double Worker::getSampleAge(size_t slot) const {
+    if (!isValidSlot(slot)) {
+        return -1.0;
+    }
+    int64_t time = sampleTimes_[slot].load(std::memory_order_relaxed);
+    if (!time) {
+        return -1.0;
+    }
+    return static_cast<double>(steadyTimeMs() - time) / 1000.0;
+}
+
+int64_t Worker::queryHistory(size_t slot, Direction direction, int64_t seconds, int64_t resolution,
+    std::vector<RollupBucket>& buckets) const {
+    int64_t now = steadyTimeMs();
+    return history_.query(slot, direction, now - seconds * 1000, now + 1, resolution, buckets);
+}
+
+void Worker::getHistoryPlot(size_t slot, Direction direction, int64_t seconds, size_t points, std::vector<PlotPoint>& plot) const {
+    int64_t now = steadyTimeMs();
+    int64_t from = now - seconds * 1000;
+    int64_t resolution = seconds * 1000 / std::max<int64_t>(1, static_cast<int64_t>(points) * kPlotOversampling);
+    std::vector<RollupBucket> buckets;
+    int64_t duration = history_.query(slot, direction, from, now + 1, resolution, buckets);
+
+    std::vector<double> x;
+    std::vector<double> y;
+    x.reserve(buckets.size());
+    y.reserve(buckets.size());
+    for (const RollupBucket& bucket : buckets) {
+        // Buckets are plotted at their middle, clamped to the range
+        double time = static_cast<double>(bucket.start + duration / 2 - from) / 1000.0;
+        x.push_back(std::min(std::max(time, 0.0), static_cast<double>(seconds)));
+        y.push_back(bucket.average());
+    }
+    Downsampler::lttb(x.data(), y.data(), x.size(), points, plot);
+}
+
+double Worker::getStatistic(size_t slot, Direction direction, AggregateType type, int64_t seconds) const {
+    if (seconds > kFileStatisticRange) {
+        std::lock_guard<std::mutex> lk(historyFilesMutex_);
+        if (slot < historyFiles_.size() && historyFiles_[slot]) {
+            int64_t now = wallTimeMs();
+            HistorySummary summary = historyFiles_[slot]->summarize(now - seconds * 1000, now + 1);
+            if (summary.count) {
+                const SampleSummary& s = direction == Direction::Upload ? summary.upload : summary.download;
+                return statisticValue(type, s.minimum, s.maximum, s.sum, summary.count);
+            }
+        }
+    }
+
+    std::vector<RollupBucket> buckets;
+    queryHistory(slot, direction, seconds, seconds * 1000 / kStatisticBuckets, buckets);
+    if (buckets.empty()) {
+        return 0.0;
+    }
+    uint64_t count = 0;
+    double sum = 0.0;
+    float minimum = buckets.front().minimum;
+    float maximum = buckets.front().maximum;
+    for (const RollupBucket& bucket : buckets) {
+        count += bucket.count;
+        sum += bucket.sum;
+        minimum = std::min(minimum, bucket.minimum);
+        maximum = std::max(maximum, bucket.maximum);
+    }
+    return statisticValue(type, minimum, maximum, sum, count);
+}
+
+double Worker::getPercentile(size_t slot, Direction direction, double percentile, int64_t seconds) const {
+    return history_.quantile(slot, direction, steadyTimeMs(), seconds * 1000, percentile / 100.0);
+}
+
+double Worker::getMissedPolls() const {
+    return static_cast<double>(missedPolls_.load());
+}
+
+void Worker::init() {
+    nc_ = std::make_unique<NetworkClient>();
+    nc_->setReactor(reactor_);
+    if (!settings_->proxy.empty() && settings_->proxyPort > 0) {
+        nc_->setProxy(settings_->proxy, settings_->proxyPort, CURLPROXY_HTTP);
+    }
+
+    nc_->setCurlOptionInt(CURLOPT_CONNECTTIMEOUT, 5);
+    // A stalled response would otherwise keep the request in progress forever and block polling
+    nc_->setCurlOptionInt(CURLOPT_TIMEOUT_MS, settings_->requestTimeout);
+    openHistoryFiles();
+
+    RmLog(rm_, LOG_DEBUG, (L"Speed history of " + settings_->routerID + L" takes "
+        + std::to_wstring(history_.memoryUsage() / 1024) + L" KB per interface").c_str());
+}
+
+void Worker::openHistoryFiles() {
+    {
+        std::lock_guard<std::mutex> lk(historyFilesMutex_);
+        historyFiles_.resize(settings_->interfaces.size());
+    }
+    // Aggregates and rollups continue where the previous session stopped
+    historyLoadSlot_ = 0;
+    historyLoadTo_ = wallTimeMs();
+    historyLoadFrom_ = historyLoadTo_ - history_.retention();
+    historyLoadOffset_ = steadyTimeMs() - historyLoadTo_;
+    if (!settings_->historyDays) {
+        return;
+    }
+    if (!IuCoreUtils::createDirectory(IuCoreUtils::WstringToUtf8(settings_->historyPath))) {
+        RmLog(rm_, LOG_WARNING, (L"Unable to create history directory " + settings_->historyPath).c_str());
+        return;
+    }
+    // Two extra blocks: the one being filled and the free one
+    int64_t samples = int64_t(settings_->historyDays) * 24 * 60 * 60 * 1000 / settings_->pollInterval;
+    size_t blocks = static_cast<size_t>(samples * kHistoryBytesPerSample / SampleBlock::kSize + 2);
+
+    for (size_t slot = 0; slot < settings_->interfaces.size(); slot++) {
+        std::wstring fileName = historyFileName(*settings_, settings_->interfaces[slot]);
+        auto file = std::make_unique<HistoryFile>();
+        if (!file->open(fileName, blocks)) {
+            RmLog(rm_, LOG_WARNING, (L"Unable to open history file " + fileName + L": " + IuCoreUtils::Utf8ToWstring(file->error())).c_str());
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lk(historyFilesMutex_);
+            historyFiles_[slot] = std::move(file);
+        }
+    }
+}
+
+void Worker::loadHistory() {
+    historyLoadTimer_ = 0;
+    while (historyLoadSlot_ < historyFiles_.size()
+        && (!historyFiles_[historyLoadSlot_] || historyLoadFrom_ >= historyLoadTo_)) {
+        historyLoadSlot_++;
+        historyLoadFrom_ = historyLoadTo_ - history_.retention();
+    }
+    if (historyLoadSlot_ >= historyFiles_.size()) {
+        historyRecords_ = std::vector<HistoryRecord>();
+        backfillSamples_.clear();
+        poll();
+        return;
+    }
+
+    size_t slot = historyLoadSlot_;
+    int64_t to = std::min(historyLoadFrom_ + kHistoryLoadChunk, historyLoadTo_);
+    historyRecords_.clear();
+    {
+        std::lock_guard<std::mutex> lk(historyFilesMutex_);
+        historyFiles_[slot]->read(historyLoadFrom_, to, historyRecords_);
+    }
+    historyLoadFrom_ = to;
+
+    for (Direction direction : { Direction::Download, Direction::Upload }) {
+        backfillSamples_.clear();
+        for (const HistoryRecord& record : historyRecords_) {
+            backfillSamples_.push_back(SpeedSample{ record.time + historyLoadOffset_,
+                direction == Direction::Download ? record.download : record.upload });
+        }
+        history_.merge(slot, direction, backfillSamples_);
+    }
+
+    // The next chunk is queued behind the tasks and transfers of other routers
+    historyLoadTimer_ = reactor_->scheduleAt(CurlMultiReactor::Clock::now(), [this] { loadHistory(); });
+}
+
+void Worker::poll() {
+    pollTimer_ = 0;
+
+    if (!authenticated) {
+        if (lastAuthErrorTime_ && (GetTickCount64() - lastAuthErrorTime_ < 10000)) {
+            schedulePoll();
+            return;
+        }
+        authenticate();
+        return;
+    }
+    loadData();
+}
+
+void Worker::schedulePoll() {
+    using Clock = PollScheduler::Clock;
+    Clock::time_point lastFrame{ Clock::duration(lastFrameTime_.load()) };
+    Clock::time_point deadline = scheduler_.nextDeadline(Clock::now(), lastFrame);
+
+    pollTimer_ = reactor_->scheduleAt(deadline, [this] {
+        scheduler_.onFired(PollScheduler::Clock::now());
+        updateSchedulerStats();
+        poll();
+    });
+}
+
+void Worker::updateSchedulerStats() {
+    PollScheduler::Stats stats = scheduler_.stats();
+    if (stats.polls < kSchedulerStatsWindow) {
+        return;
+    }
+    pollJitter_ = stats.meanJitterMs;
+    missedPolls_ += stats.missedDeadlines;
+    scheduler_.resetStats();
+
+    std::wstring msg = L"Poll scheduler: mean jitter " + std::to_wstring(stats.meanJitterMs)
+        + L" ms, max jitter " + std::to_wstring(stats.maxJitterMs)
+        + L" ms, missed deadlines " + std::to_wstring(stats.missedDeadlines);
+    RmLog(rm_, LOG_DEBUG, msg.c_str());
+}
+
+void Worker::sendRequest(RequestHandler handler) {
+    nc_->performAsync([this, handler](bool) {
+        (this->*handler)();
+    });
+}
+
+void Worker::cancelRequest() {
+    // The handler is not invoked
+    nc_->cancelAsync();
+}
+
+void Worker::authenticate() {
+    nc_->prepareGet(settings_->routerUrl + "/auth");
+    sendRequest(&Worker::onAuthChallenge);
+}
+
+void Worker::onAuthChallenge() {
+    std::string challenge = nc_->responseHeaderByName("X-NDM-Challenge");
+    std::string realm = nc_->responseHeaderByName("X-NDM-Realm");
+
+    if (challenge.empty() || realm.empty()) {
+        std::wstring msg = std::wstring(L"Failed to obtain realm token. Response code : ")
+            + std::to_wstring(nc_->responseCode()) + L", CURL error: " + IuCoreUtils::Utf8ToWstring(nc_->errorString());
+        RmLog(rm_, LOG_ERROR, msg.c_str());
+        schedulePoll();
+        return;
+    }
+    nc_->setUrl(settings_->routerUrl + "/auth");
+
+    std::string hash = IuCoreUtils::CryptoUtils::CalcSHA256HashFromString(challenge +
+        IuCoreUtils::CryptoUtils::CalcMD5HashFromString(settings_->login + ":" + realm + ":" + settings_->password)
+    );
+
+    Json::Value val;
+    val["login"] = settings_->login;
+    val["password"] = hash;
+
+    std::ostringstream stream;
+    stream << val;
+
+    nc_->addQueryHeader("Content-Type", "application/json");
+    nc_->preparePost(stream.str());
+    sendRequest(&Worker::onAuthResponse);
+}
+
+void Worker::onAuthResponse() {
+    if (nc_->responseCode() != 200) {
+        std::wstring msg = std::wstring(L"Authentication failed on router. Response code : ")
+            + std::to_wstring(nc_->responseCode()) + L", CURL error: " + IuCoreUtils::Utf8ToWstring(nc_->errorString());
+        RmLog(rm_, LOG_ERROR, msg.c_str());
+        lastAuthErrorTime_ = GetTickCount64();
+        schedulePoll();
+        return;
+    }
+
+    authenticated = true;
+    loadData();
+}
+
+void Worker::logout() {
+    // The request outlives the worker, the completion callback owns the client
+    std::shared_ptr<NetworkClient> nc(std::move(nc_));
+    nc->setUrl(settings_->routerUrl + "/auth");
+    nc->setMethod("DELETE");
+    nc->preparePost({});
+
+    reactor_->addTransfer(nc->getCurlHandle(), [nc](CURLcode result) {
+        try {
+            nc->completeRequest(result);
+        } catch (const NetworkClient::AbortedException&) {
+        }
+    });
+}
+
+void Worker::updateActiveSlots() {
+    uint64_t version = subscriptionVersion_;
+    if (version == activeSlotsVersion_) {
+        return;
+    }
+    std::vector<size_t> slots;
+    {
+        std::lock_guard<std::mutex> lk(subscriptionMutex_);
+        for (size_t i = 0; i < subscribers_.size(); i++) {
+            if (subscribers_[i] > 0) {
+                slots.push_back(i);
+            }
+        }
+        activeSlotsVersion_ = subscriptionVersion_;
+    }
+
+    // Interfaces nobody is interested in anymore should not show stale values
+    for (size_t slot : slots) {
+        if (!std::binary_search(activeSlots_.begin(), activeSlots_.end(), slot)) {
+            needsBackfill_ = true;
+        }
+    }
+
+    bool removed = false;
+    for (size_t slot : activeSlots_) {
+        if (!std::binary_search(slots.begin(), slots.end(), slot)) {
+            pendingSpeeds_[slot] = InterfaceSpeed();
+            history_.clear(slot);
+            routerTimeline_.reset(slot);
+            counterRates_[slot].reset();
+            sampleTimes_[slot].store(0, std::memory_order_relaxed);
+            removed = true;
+        }
+    }
+    if (removed) {
+        speeds_.publish(pendingSpeeds_);
+    }
+    activeSlots_ = std::move(slots);
+    buildDataRequest();
+}
+
+void Worker::buildDataRequest() {
+    bool isCustomRequest = !settings_->command.empty();
+    bool isCounterRequest = !isCustomRequest && settings_->source == SpeedSource::Counters;
+    std::string command = isCustomRequest ? settings_->command : isCounterRequest ? "show/interface/stat" : "show/interface/rrd";
+    std::string url = settings_->routerUrl + "/rci/" + command;
+
+    Json::StreamWriterBuilder builder;
+    builder["commentStyle"] = "None";
+    builder["indentation"] = "";
+
+    // Counters of all interfaces are requested at once, the router keeps no history of them
+    if (isCustomRequest || isCounterRequest) {
+        Json::Value root(Json::arrayValue);
+        for (size_t slot : activeSlots_) {
+            const std::string& el = settings_->interfaces[slot];
+            Json::Value item;
+            item["name"] = el;
+            root.append(item);
+        }
+        dataRequest_ = prepareDataRequest(url, Json::writeString(builder, root));
+        backfillDataRequest_.reset();
+        return;
+    }
+
+    auto buildRrdRequest = [&](int detail) {
+        Json::Value root(Json::arrayValue);
+        for (size_t slot : activeSlots_) {
+            const std::string& el = settings_->interfaces[slot];
+            Json::Value rrd1;
+            rrd1["name"] = el;
+            rrd1["attribute"] = "rxspeed";
+            rrd1["detail"] = detail;
+
+            Json::Value rrd2;
+            rrd2["name"] = el;
+            rrd2["attribute"] = "txspeed";
+            rrd2["detail"] = detail;
+
+            root.append(rrd1);
+            root.append(rrd2);
+        }
+        return prepareDataRequest(url, Json::writeString(builder, root));
+    };
+
+    dataRequest_ = buildRrdRequest(0);
+    backfillDataRequest_ = buildRrdRequest(settings_->backfillDetail);
+}
+
+std::shared_ptr<const NetworkClient::PreparedRequest> Worker::prepareDataRequest(const std::string& url, std::string body) const {
+    // Only the default POST request carries a body
+    if (!settings_->requestType.empty()) {
+        return std::make_shared<const NetworkClient::PreparedRequest>(url, settings_->requestType,
+            std::vector<std::pair<std::string, std::string>>(), std::string());
+    }
+    return std::make_shared<const NetworkClient::PreparedRequest>(url, "POST",
+        std::vector<std::pair<std::string, std::string>>{ { "Content-Type", "application/json" } }, std::move(body));
+}
+
+void Worker::loadData() {
+    updateActiveSlots();
+    if (activeSlots_.empty()) {
+        schedulePoll();
+        return;
+    }
+
+    // The router's history is requested instead of a single sample if ours has a hole
+    int64_t now = steadyTimeMs();
+    if (lastSampleTime_ && now - lastSampleTime_ > kGapPolls * settings_->pollInterval) {
+        needsBackfill_ = true;
+    }
+    backfillRequest_ = needsBackfill_ && backfillDataRequest_ && settings_->requestType.empty() && settings_->backfill;
+
+    // Between authentications the same request is repeated, it stays pinned to the curl handle
+    nc_->prepareRequest(backfillRequest_ ? backfillDataRequest_ : dataRequest_);
+    requestStartTime_ = PollScheduler::Clock::now();
+    sendRequest(&Worker::onDataLoaded);
+}
+
+void Worker::onDataLoaded() {
+    scheduler_.onCompleted(requestStartTime_, PollScheduler::Clock::now());
+    bool success = false;
+
+    if (nc_->responseCode() == 200) {
+        try {
+            if (!settings_->command.empty()) {
+                success = readCustomResponse();
+            } else if (settings_->source == SpeedSource::Counters) {
+                success = readCounterResponse();
+            } else {
+                success = readRrdResponse();
+            }
+            // A repeated sample changes nothing, measures keep reading the values already published
+            bool fresh = std::any_of(activeSlots_.begin(), activeSlots_.end(), [this](size_t slot) {
+                return freshSlots_[slot] != 0;
+            });
+            if (success && (fresh || speedsCleared_)) {
+                speeds_.publish(pendingSpeeds_);
+                speedsCleared_ = false;
+            }
+        } catch (const std::exception& ex) {
+            RmLog(rm_, LOG_ERROR, IuCoreUtils::Utf8ToWstring(ex.what()).c_str());
+        }
+    }
+    else {
+        if (nc_->responseCode() == 401) {
+            authenticated = false;
+        }
+        std::wstring msg = std::wstring(L"Failed to get data from router. Response code: ")
+            + std::to_wstring(nc_->responseCode()) + L", CURL error: " + IuCoreUtils::Utf8ToWstring(nc_->errorString());
+
+        RmLog(rm_, LOG_ERROR, msg.c_str());
+    }
+
+    if (!success) {
+        clearData();
+    }
+    updateHistory(success);
+    schedulePoll();
+}
+
+void Worker::updateHistory(bool success) {
+    int64_t now = steadyTimeMs();
+    if (success) {
+        lastSampleTime_ = now;
+    }
+    for (size_t slot : activeSlots_) {
+        if (success) {
+            if (!freshSlots_[slot]) {
+                // Counting a repeated sample twice would skew the averages
+                continue;
+            }
+            sampleTimes_[slot].store(now, std::memory_order_relaxed);
+            // The backfill has already added the latest sample
+            if (!backfillRequest_) {
+                history_.add(slot, now, pendingSpeeds_[slot]);
+                std::lock_guard<std::mutex> lk(historyFilesMutex_);
+                if (historyFiles_[slot]) {
+                    const InterfaceSpeed& speed = pendingSpeeds_[slot];
+                    historyFiles_[slot]->append(HistoryRecord{ wallTimeMs(),
+                        static_cast<float>(speed.download), static_cast<float>(speed.upload) });
+                }
+            }
+        } else {
+            // A failed poll is a gap in the history rather than a zero sample
+            history_.expire(slot, now);
+        }
+    }
+}
+
+bool Worker::readCustomResponse() {
+    if (!reader_->readFields(nc_->responseBodyView(), customFields_, customValues_)) {
+        RmLog(rm_, LOG_ERROR, (L"Failed to parse router response: " + IuCoreUtils::Utf8ToWstring(reader_->error())).c_str());
+        return false;
+    }
+    size_t count = customValues_.size() / customFields_.size();
+
+    for (size_t j = 0; j < activeSlots_.size(); ++j) {
+        size_t slot = activeSlots_[j];
+        // Only the default POST request carries the list of interfaces,
+        // otherwise the response is indexed by the position in the Interface option
+        size_t i = settings_->requestType.empty() ? j : slot;
+
+        InterfaceSpeed& speed = pendingSpeeds_[slot];
+        // Custom responses carry no timestamps, every poll is a new sample
+        freshSlots_[slot] = true;
+        const double* values = i < count ? &customValues_[i * customFields_.size()] : nullptr;
+
+        if (!settings_->downloadField.empty()) {
+            speed.download = (values ? values[0] : 0.0) / settings_->downloadDivider;
+        }
+        if (!settings_->uploadField.empty()) {
+            speed.upload = (values ? values[1] : 0.0) / settings_->uploadDivider;
+        }
+    }
+    return true;
+}
+
+bool Worker::readRrdResponse() {
+    if (!reader_->readRrd(nc_->responseBodyView(), rrdSeries_, backfillRequest_)) {
+        RmLog(rm_, LOG_ERROR, (L"Failed to parse router response: " + IuCoreUtils::Utf8ToWstring(reader_->error())).c_str());
+        return false;
+    }
+
+    for (size_t j = 0; j < activeSlots_.size(); ++j) {
+        size_t slot = activeSlots_[j];
+        InterfaceSpeed& speed = pendingSpeeds_[slot];
+        // Download and upload series of every requested interface follow each other
+        size_t offset = (settings_->requestType.empty() ? j : slot) * 2;
+
+        const RrdSeries* download = offset < rrdSeries_.size() ? &rrdSeries_[offset] : nullptr;
+        const RrdSeries* upload = offset + 1 < rrdSeries_.size() ? &rrdSeries_[offset + 1] : nullptr;
+        if (download) {
+            reportRrdError(*download);
+            if (download->hasValue) {
+                speed.download = download->value / settings_->downloadDivider;
+            }
+        }
+        if (upload) {
+            reportRrdError(*upload);
+            if (upload->hasValue) {
+                speed.upload = upload->value / settings_->uploadDivider;
+            }
+        }
+        freshSlots_[slot] = updateRouterTime(slot, download, upload);
+    }
+    if (backfillRequest_) {
+        mergeBackfill();
+    }
+    return true;
+}
+
+bool Worker::readCounterResponse() {
+    if (!reader_->readCounters(nc_->responseBodyView(), counters_)) {
+        RmLog(rm_, LOG_ERROR, (L"Failed to parse router response: " + IuCoreUtils::Utf8ToWstring(reader_->error())).c_str());
+        return false;
+    }
+
+    int64_t time = counterReadTime();
+    for (size_t j = 0; j < activeSlots_.size(); ++j) {
+        size_t slot = activeSlots_[j];
+        // Only the default POST request carries the list of interfaces
+        size_t i = settings_->requestType.empty() ? j : slot;
+        freshSlots_[slot] = false;
+        if (i >= counters_.size()) {
+            continue;
+        }
+        const InterfaceCounters& counters = counters_[i];
+        if (counters.failed) {
+            RmLog(rm_, LOG_ERROR, (L"Server answered with error: " + IuCoreUtils::Utf8ToWstring(counters.message)).c_str());
+        }
+        if (!counters.hasValue) {
+            continue;
+        }
+
+        double rxRate = 0.0;
+        double txRate = 0.0;
+        ByteCounterRate::Result result = counterRates_[slot].update(time, counters.rxBytes, counters.txBytes, rxRate, txRate);
+        if (result == ByteCounterRate::Result::Reset) {
+            RmLog(rm_, LOG_DEBUG, (L"Byte counters of " + IuCoreUtils::Utf8ToWstring(settings_->interfaces[slot])
+                + L" were reset").c_str());
+        }
+        if (result != ByteCounterRate::Result::Rate) {
+            // The speeds are known from the next reading on
+            continue;
+        }
+        // Dividers apply to bits per second, like the speeds of show/interface/rrd
+        InterfaceSpeed& speed = pendingSpeeds_[slot];
+        speed.download = rxRate * 8.0 / settings_->downloadDivider;
+        speed.upload = txRate * 8.0 / settings_->uploadDivider;
+        freshSlots_[slot] = true;
+    }
+    return true;
+}
+
+int64_t Worker::counterReadTime() const {
+    // The router reads the counters while the request is being processed: between sending the request
+    // and receiving the first byte of the response, which excludes connection setup and body transfer
+    double sent = nc_->getCurlInfoDouble(CURLINFO_PRETRANSFER_TIME);
+    double received = nc_->getCurlInfoDouble(CURLINFO_STARTTRANSFER_TIME);
+    auto start = std::chrono::duration_cast<std::chrono::microseconds>(requestStartTime_.time_since_epoch()).count();
+    if (received > 0.0 && received >= sent) {
+        return start + static_cast<int64_t>((sent + received) / 2 * 1e6);
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(PollScheduler::Clock::now().time_since_epoch()).count();
+}
+
+void Worker::mergeBackfill() {
+    // Router timestamps are mapped to local time assuming that the newest sample was taken just now
+    int64_t newest = 0;
+    for (const RrdSeries& series : rrdSeries_) {
+        for (const RrdSample& sample : series.samples) {
+            newest = std::max(newest, sample.time);
+        }
+    }
+    int64_t offset = steadyTimeMs() - newest * 1000;
+
+    auto merge = [&](size_t slot, Direction direction, size_t index, double divider) {
+        if (index >= rrdSeries_.size()) {
+            return;
+        }
+        backfillSamples_.clear();
+        for (const RrdSample& sample : rrdSeries_[index].samples) {
+            backfillSamples_.push_back(SpeedSample{ sample.time * 1000 + offset, sample.value / divider });
+        }
+        std::sort(backfillSamples_.begin(), backfillSamples_.end(), [](const SpeedSample& a, const SpeedSample& b) {
+            return a.time < b.time;
+        });
+        history_.merge(slot, direction, backfillSamples_);
+    };
+
+    // Both series of an interface come from the same RRD and share timestamps
+    int64_t wallOffset = wallTimeMs() - newest * 1000;
+    auto write = [&](size_t slot, size_t index) {
+        std::lock_guard<std::mutex> lk(historyFilesMutex_);
+        if (!historyFiles_[slot] || index + 1 >= rrdSeries_.size()) {
+            return;
+        }
+        const std::vector<RrdSample>& download = rrdSeries_[index].samples;
+        const std::vector<RrdSample>& upload = rrdSeries_[index + 1].samples;
+        // Samples are ordered from the newest one
+        for (size_t i = std::min(download.size(), upload.size()); i-- > 0;) {
+            if (download[i].time == upload[i].time) {
+                historyFiles_[slot]->append(HistoryRecord{ download[i].time * 1000 + wallOffset,
+                    static_cast<float>(download[i].value / settings_->downloadDivider),
+                    static_cast<float>(upload[i].value / settings_->uploadDivider) });
+            }
+        }
+    };
+
+    for (size_t j = 0; j < activeSlots_.size(); ++j) {
+        merge(activeSlots_[j], Direction::Download, j * 2, settings_->downloadDivider);
+        merge(activeSlots_[j], Direction::Upload, j * 2 + 1, settings_->uploadDivider);
+        write(activeSlots_[j], j * 2);
+    }
+    needsBackfill_ = false;
+}
+
+bool Worker::updateRouterTime(size_t slot, const RrdSeries* download, const RrdSeries* upload) {
+    int64_t step = std::max<int64_t>(1, settings_->pollInterval / 1000);
+    RouterTimeline::Result result = routerTimeline_.update(slot, download, upload, kGapPolls * step);
+
+    // Samples of the router's own history we have not seen, although our polls came in time
+    if (result == RouterTimeline::Result::Gap && !backfillRequest_) {
+        needsBackfill_ = true;
+    }
+    // A missing or repeated sample would push stale speeds into the history
+    return result == RouterTimeline::Result::New || result == RouterTimeline::Result::Gap;
+}
+
+void Worker::reportRrdError(const RrdSeries& series) {
+    if (series.failed) {
+        std::wstring msg = std::wstring(L"Server answered with error: ") + IuCoreUtils::Utf8ToWstring(series.message);
+        RmLog(rm_, LOG_ERROR, msg.c_str());
+    }
+}
+
+void Worker::clearData() {
+    // The router may have rebooted while it did not answer, its counters are compared only to new readings
+    for (ByteCounterRate& rate : counterRates_) {
+        rate.reset();
+    }
+    std::fill(pendingSpeeds_.begin(), pendingSpeeds_.end(), InterfaceSpeed());
+    speeds_.clear();
+    speedsCleared_ = true;
+}
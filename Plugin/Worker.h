@@ -0,0 +1,214 @@
+#ifndef KEENETIC_PLUGIN_WORKER_H
+#define KEENETIC_PLUGIN_WORKER_H
+
+#pragma once
+
+#include <Windows.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Core/Network/CurlMultiReactor.h"
+#include "Core/Network/NetworkClient.h"
+#include "CounterRate.h"
+#include "Downsampler.h"
+#include "HistoryFile.h"
+#include "InterfaceHistory.h"
+#include "PollScheduler.h"
+#include "ResponseReader.h"
+#include "RouterTimeline.h"
+#include "Settings.h"
+#include "SpeedTable.h"
+
+/**
+ * Per-router state. Requests are performed asynchronously by the shared CurlMultiReactor,
+ * all private methods are executed on the reactor thread.
+ */
+class Worker
+{
+public:
+    Worker(void *rm, std::shared_ptr<Settings> settings, CurlMultiReactor* reactor);
+    ~Worker();
+
+    void start();
+    void abort();
+
+    void setProxyPort(int port);
+
+    /**
+     * Returns the slot of the interface in the speed table, to be resolved once per Reload().
+     * Empty name means the default interface. Unknown interfaces get a slot which always reads zero.
+     */
+    size_t resolveInterface(const std::string& interf) const;
+    bool isValidSlot(size_t slot) const;
+
+    double getUploadSpeed(size_t slot) const;
+    double getDownloadSpeed(size_t slot) const;
+
+    // Rolling average, peak or minimum speed of the interface
+    double getAggregate(size_t slot, Direction direction, AggregateType type, AggregateWindow window) const;
+
+    /**
+     * Rollups of the interface speed over the last seconds, at the coarsest stored resolution
+     * not exceeding resolution milliseconds. May be called from any thread.
+     * @return bucket duration in milliseconds.
+     */
+    int64_t queryHistory(size_t slot, Direction direction, int64_t seconds, int64_t resolution,
+        std::vector<RollupBucket>& buckets) const;
+
+    /**
+     * Speed of the interface over the last seconds reduced to at most points points for a graph,
+     * x being the time in seconds since the start of the range. May be called from any thread.
+     */
+    void getHistoryPlot(size_t slot, Direction direction, int64_t seconds, size_t points, std::vector<PlotPoint>& plot) const;
+
+    /**
+     * Average, peak or minimum speed of the interface over the last seconds. Ranges longer than an hour
+     * are computed from the block summaries of the history file, if enabled, otherwise from the rollups,
+     * so the range is rounded to the buckets used. May be called from any thread.
+     */
+    double getStatistic(size_t slot, Direction direction, AggregateType type, int64_t seconds) const;
+
+    /**
+     * Speed of the interface at the percentile (0..100) of the samples over the last seconds,
+     * within about 2%. May be called from any thread.
+     */
+    double getPercentile(size_t slot, Direction direction, double percentile, int64_t seconds) const;
+
+    // Seconds since the router last reported a new sample of the interface, -1 if there was none yet
+    double getSampleAge(size_t slot) const;
+
+    /**
+     * Only interfaces having at least one subscriber are requested from the router.
+     * Called by measures on Reload() and Finalize().
+     */
+    void subscribe(size_t slot);
+    void unsubscribe(size_t slot);
+
+    /**
+     * Called on every Update() of a measure, lets the scheduler lock onto Rainmeter's frames.
+     */
+    void notifyUpdate();
+
+    // Mean deviation of poll times from their deadlines, in milliseconds
+    double getPollJitter() const;
+    // Total number of poll deadlines skipped because the previous request was still running
+    double getMissedPolls() const;
+
+private:
+    using RequestHandler = void (Worker::*)();
+
+    std::shared_ptr<Settings> settings_;
+    // Owned by the plugin, outlives every worker
+    CurlMultiReactor* reactor_;
+    void* rm_;
+    bool started_ = false;
+    bool stopped_ = false;
+    std::unique_ptr<NetworkClient> nc_;
+    ULONGLONG lastAuthErrorTime_ = 0;
+    CurlMultiReactor::TimerId pollTimer_ = 0;
+    CurlMultiReactor::TimerId historyLoadTimer_ = 0;
+    PollScheduler scheduler_;
+    PollScheduler::Clock::time_point requestStartTime_;
+    std::atomic<PollScheduler::Clock::rep> lastFrameTime_{ 0 };
+    std::atomic<double> pollJitter_{ 0 };
+    std::atomic<uint64_t> missedPolls_{ 0 };
+
+    int proxyPort_ = 0;
+
+    // Immutable after construction, may be used from any thread
+    std::map<std::string, size_t> interfaceIndex_;
+    size_t defaultInterfaceIndex_ = 0;
+
+    // Number of measures bound to each interface
+    std::mutex subscriptionMutex_;
+    std::vector<int> subscribers_;
+    std::atomic<uint64_t> subscriptionVersion_{ 0 };
+
+    // Interfaces included into the data request, reactor thread only
+    std::vector<size_t> activeSlots_;
+    uint64_t activeSlotsVersion_ = 0;
+
+    // Data request, prepared once per change of active interfaces
+    std::shared_ptr<const NetworkClient::PreparedRequest> dataRequest_;
+    // Same request at a higher detail level, returning the router's history
+    std::shared_ptr<const NetworkClient::PreparedRequest> backfillDataRequest_;
+    bool needsBackfill_ = true;
+    bool backfillRequest_ = false;
+    // Steady time of the latest successful poll, in milliseconds
+    int64_t lastSampleTime_ = 0;
+    std::vector<SpeedSample> backfillSamples_;
+
+    RouterTimeline routerTimeline_;
+    // Interfaces for which the latest response carried a new sample rather than a repeated one
+    std::vector<char> freshSlots_;
+    // Steady time of the latest new sample of every interface in milliseconds, zero if none, read by measures
+    std::unique_ptr<std::atomic<int64_t>[]> sampleTimes_;
+
+    // Speeds being assembled by the reactor thread, published to speeds_ when complete
+    std::vector<InterfaceSpeed> pendingSpeeds_;
+    // The published speeds were zeroed after a failure and must be published again even if unchanged
+    bool speedsCleared_ = false;
+    SpeedTable speeds_;
+    InterfaceHistory history_;
+    // Long-term history of every interface on disk, null if disabled or failed to open.
+    // Written by the reactor thread, long-range statistics are read from any thread.
+    mutable std::mutex historyFilesMutex_;
+    std::vector<std::unique_ptr<HistoryFile>> historyFiles_;
+    std::vector<HistoryRecord> historyRecords_;
+    // Position of the history load: interface slot and the wall time range left to read
+    size_t historyLoadSlot_ = 0;
+    int64_t historyLoadFrom_ = 0;
+    int64_t historyLoadTo_ = 0;
+    // Steady minus wall time when the load started
+    int64_t historyLoadOffset_ = 0;
+
+    // Parsed responses, reused between polls
+    std::unique_ptr<ResponseReader> reader_;
+    std::vector<RrdSeries> rrdSeries_;
+    std::vector<const JsonFieldPath*> customFields_;
+    std::vector<double> customValues_;
+    std::vector<InterfaceCounters> counters_;
+    // Rates of the byte counters of every interface, reset when the interface is unsubscribed
+    std::vector<ByteCounterRate> counterRates_;
+
+    bool authenticated = false;
+
+    void init();
+    void poll();
+    void schedulePoll();
+    void updateSchedulerStats();
+    void sendRequest(RequestHandler handler);
+    void cancelRequest();
+
+    void authenticate();
+    void onAuthChallenge();
+    void onAuthResponse();
+    void logout();
+
+    void loadData();
+    void onDataLoaded();
+    bool readCustomResponse();
+    bool readRrdResponse();
+    bool readCounterResponse();
+    int64_t counterReadTime() const;
+    void reportRrdError(const RrdSeries& series);
+    // True if the response carried a new sample of the interface
+    bool updateRouterTime(size_t slot, const RrdSeries* download, const RrdSeries* upload);
+    void mergeBackfill();
+    void openHistoryFiles();
+    // Loads one chunk of the history files and schedules the next one, starts polling when done
+    void loadHistory();
+    void clearData();
+    void updateHistory(bool success);
+    void updateActiveSlots();
+    void buildDataRequest();
+    std::shared_ptr<const NetworkClient::PreparedRequest> prepareDataRequest(const std::string& url, std::string body) const;
+};
+
+#endif
@@ -0,0 +1,202 @@
+// Latency to the first value of a large custom command response: the body buffered by the client and then
+// searched, as before, against a streaming BodySink which finds the value while the body arrives, and one
+// which also stops the transfer once the value is found. The mock router sends the response in chunks,
+// at about 500 Mbit/s.
+//
+// Usage: BodySinkBench [interfaces]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "Core/Network/BodySink.h"
+#include "Core/Network/NetworkClient.h"
+#include "MockRouter.h"
+#include "RouterResponses.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kChunkSize = 64 * 1024;
+constexpr int kRuns = 5;
+
+double msSince(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/**
+ * Finds the value of the first "rxbytes" field, fed byte by byte, so a field split between
+ * chunks is found without keeping any of the body.
+ */
+class FieldMatcher {
+public:
+    // Returns true when the value is complete
+    bool feed(char c) {
+        switch (state_) {
+            case State::Key:
+                if (c == kKey[matched_]) {
+                    if (++matched_ == kKey.size()) {
+                        state_ = State::Separator;
+                    }
+                } else {
+                    // Only the quote repeats in the key
+                    matched_ = c == kKey[0] ? 1 : 0;
+                }
+                return false;
+            case State::Separator:
+                if (c == '"') {
+                    state_ = State::Value;
+                }
+                return false;
+            case State::Value:
+                if (c == '"') {
+                    state_ = State::Done;
+                    return true;
+                }
+                value_ += c;
+                return false;
+            case State::Done:
+                return false;
+        }
+        return false;
+    }
+
+    bool done() const {
+        return state_ == State::Done;
+    }
+
+    const std::string& value() const {
+        return value_;
+    }
+
+private:
+    enum class State { Key, Separator, Value, Done };
+    static constexpr std::string_view kKey = "\"rxbytes\"";
+
+    State state_ = State::Key;
+    size_t matched_ = 0;
+    std::string value_;
+};
+
+class FirstValueSink : public BodySink {
+public:
+    explicit FirstValueSink(bool stopAtValue) : stopAtValue_(stopAtValue) {
+    }
+
+    bool begin(int64_t) override {
+        return true;
+    }
+
+    bool write(const char* data, size_t size) override {
+        for (size_t i = 0; i < size && !matcher_.done(); i++) {
+            if (matcher_.feed(data[i])) {
+                foundAt_ = Clock::now();
+            }
+        }
+        return !(stopAtValue_ && matcher_.done());
+    }
+
+    void end() override {
+    }
+
+    const FieldMatcher& matcher() const {
+        return matcher_;
+    }
+
+    Clock::time_point foundAt() const {
+        return foundAt_;
+    }
+
+private:
+    bool stopAtValue_;
+    FieldMatcher matcher_;
+    Clock::time_point foundAt_;
+};
+
+struct Result {
+    double valueMs = 0.0;
+    double totalMs = 0.0;
+    size_t bodyBytes = 0;
+    bool valid = true;
+};
+
+Result buffered(NetworkClient& client, const std::string& url) {
+    Result result;
+    auto start = Clock::now();
+    result.valid = client.doGet(url);
+    FieldMatcher matcher;
+    for (char c : client.responseBodyView()) {
+        if (matcher.feed(c)) {
+            break;
+        }
+    }
+    auto end = Clock::now();
+    result.valueMs = result.totalMs = msSince(start, end);
+    result.bodyBytes = client.responseBodyView().size();
+    result.valid = result.valid && matcher.value() == "5000000000";
+    return result;
+}
+
+Result streamed(NetworkClient& client, const std::string& url, bool stopAtValue) {
+    Result result;
+    auto sink = std::make_shared<FirstValueSink>(stopAtValue);
+    client.setBodySink(sink);
+    auto start = Clock::now();
+    // The transfer fails when the sink stops it
+    bool success = client.doGet(url);
+    auto end = Clock::now();
+    result.valueMs = msSince(start, sink->foundAt());
+    result.totalMs = msSince(start, end);
+    result.bodyBytes = client.responseBodyView().size();
+    result.valid = success != stopAtValue && sink->matcher().value() == "5000000000";
+    return result;
+}
+
+template<class Func>
+Result average(Func&& func) {
+    Result sum;
+    for (int i = 0; i < kRuns; i++) {
+        Result result = func();
+        sum.valueMs += result.valueMs / kRuns;
+        sum.totalMs += result.totalMs / kRuns;
+        sum.bodyBytes = result.bodyBytes;
+        sum.valid = sum.valid && result.valid;
+    }
+    return sum;
+}
+
+void print(const char* name, const Result& result) {
+    printf("%-24s %14.2f %14.2f %14zu%s\n", name, result.valueMs, result.totalMs, result.bodyBytes / 1024,
+        result.valid ? "" : "   wrong result");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t interfaces = argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 13000;
+    const std::string body = interfaceResponse(interfaces);
+    MockRouter router([&body](const MockRequest&) {
+        MockResponse response;
+        response.headers = { { "Content-Type", "application/json" } };
+        response.body = body;
+        // 64 KB every millisecond, about 500 Mbit/s
+        response.chunkSize = kChunkSize;
+        response.chunkDelay = std::chrono::milliseconds(1);
+        return response;
+    });
+    const std::string url = router.url() + "/rci/show/interface";
+
+    printf("%zu KB response in %zu KB chunks, first \"rxbytes\" value, average of %d requests\n\n",
+        body.size() / 1024, kChunkSize / 1024, kRuns);
+    printf("%-24s %14s %14s %14s\n", "", "to value ms", "total ms", "buffered KB");
+    NetworkClient client;
+    print("buffered, then searched", average([&] { return buffered(client, url); }));
+    print("streaming sink", average([&] { return streamed(client, url, false); }));
+    print("streaming sink, stopped", average([&] { return streamed(client, url, true); }));
+    router.stop();
+    return 0;
+}
@@ -0,0 +1,68 @@
+// Cost of drawing a history graph: a day of one-second samples reduced to the points of a skin graph
+// by Downsampler::lttb, against LTTB as written in the paper and plain bucket averages, which lose peaks.
+//
+// Usage: DownsamplerBench
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "Plugin/Downsampler.h"
+#include "ReferenceLttb.h"
+
+namespace {
+
+void average(const std::vector<PlotPoint>& data, size_t threshold, std::vector<PlotPoint>& out) {
+    out.clear();
+    size_t bucket = (data.size() + threshold - 1) / threshold;
+    for (size_t begin = 0; begin < data.size(); begin += bucket) {
+        size_t end = std::min(begin + bucket, data.size());
+        double sumX = 0.0;
+        double sumY = 0.0;
+        for (size_t i = begin; i < end; i++) {
+            sumX += data[i].x;
+            sumY += data[i].y;
+        }
+        out.push_back(PlotPoint{ sumX / (end - begin), sumY / (end - begin) });
+    }
+}
+
+double peak(const std::vector<PlotPoint>& points) {
+    double res = 0.0;
+    for (const PlotPoint& point : points) {
+        res = std::max(res, point.y);
+    }
+    return res;
+}
+
+}
+
+int main() {
+    // Background traffic with short downloads
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<PlotPoint> data;
+    unsigned state = 1;
+    for (size_t i = 0; i < 24 * 60 * 60; i++) {
+        state = state * 1664525u + 1013904223u;
+        double value = (state >> 8) % 2000 + ((state >> 8) % 5000 == 0 ? 9e7 : 0.0);
+        x.push_back(static_cast<double>(i));
+        y.push_back(value);
+        data.push_back(PlotPoint{ x.back(), value });
+    }
+    double inputPeak = peak(data);
+
+    printf("A day of samples every second, %zu points, reduced for a graph.\n\n", data.size());
+    printf("%-10s %8s %12s %14s\n", "method", "points", "us", "peak kept %");
+    std::vector<PlotPoint> out;
+    for (size_t points : { 220, 1000 }) {
+        double lttbNs = BenchUtils::nsPerCall([&] { Downsampler::lttb(x.data(), y.data(), x.size(), points, out); });
+        printf("%-10s %8zu %12.1f %14.1f\n", "lttb", points, lttbNs / 1e3, peak(out) * 100 / inputPeak);
+        double referenceNs = BenchUtils::nsPerCall([&] { referenceLttb(data, points, out); });
+        printf("%-10s %8zu %12.1f %14.1f\n", "reference", points, referenceNs / 1e3, peak(out) * 100 / inputPeak);
+        double averageNs = BenchUtils::nsPerCall([&] { average(data, points, out); });
+        printf("%-10s %8zu %12.1f %14.1f\n", "average", points, averageNs / 1e3, peak(out) * 100 / inputPeak);
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Cost of the on-disk history: appending a year of samples taken every second, scanning it back
+// in the hour-long chunks the worker loads at start, and summarizing ranges for long-range graphs.
+//
+// Usage: HistoryFileBench [days]
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "Plugin/HistoryFile.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int64_t kStep = 1000;
+constexpr int64_t kHour = 60 * 60 * 1000;
+constexpr int64_t kDay = 24 * kHour;
+// Same sizing as the worker
+constexpr int64_t kBytesPerSample = 8;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Mostly idle link with bursts of downloads, as a home router sees it
+class TrafficModel {
+public:
+    HistoryRecord next(int64_t time) {
+        if (burst_ == 0 && random() % 600 == 0) {
+            burst_ = 30 + random() % 600;
+            level_ = static_cast<float>(1e6 + random() % 100000000);
+        }
+        HistoryRecord record{ time, static_cast<float>(random() % 2000), static_cast<float>(random() % 1000) };
+        if (burst_) {
+            burst_--;
+            record.download += level_ * (0.9f + (random() % 200) / 1000.0f);
+            record.upload += level_ / 40;
+        }
+        return record;
+    }
+
+private:
+    uint32_t random() {
+        state_ = state_ * 1664525u + 1013904223u;
+        return state_ >> 8;
+    }
+
+    uint32_t state_ = 12345;
+    uint32_t burst_ = 0;
+    float level_ = 0.0f;
+};
+
+}
+
+int main(int argc, char* argv[]) {
+    int64_t days = argc > 1 ? atoll(argv[1]) : 365;
+    int64_t samples = days * kDay / kStep;
+    size_t blocks = static_cast<size_t>(samples * kBytesPerSample / SampleBlock::kSize + 2);
+    const std::wstring fileName = L"HistoryFileBench.hist";
+    DeleteFileW(fileName.c_str());
+
+    printf("%lld days of samples every second, %zu blocks of %zu bytes (%.1f MB)\n\n",
+        static_cast<long long>(days), blocks, SampleBlock::kSize, blocks * SampleBlock::kSize / 1e6);
+
+    const int64_t start = 1700000000000;
+    const int64_t end = start + samples * kStep;
+    {
+        HistoryFile file;
+        if (!file.open(fileName, blocks)) {
+            fprintf(stderr, "%s\n", file.error().c_str());
+            return 1;
+        }
+        TrafficModel traffic;
+        double cpuBefore = BenchUtils::threadCpuSeconds();
+        auto began = Clock::now();
+        for (int64_t time = start; time < end; time += kStep) {
+            file.append(traffic.next(time));
+        }
+        double seconds = secondsSince(began);
+        double cpu = BenchUtils::threadCpuSeconds() - cpuBefore;
+        printf("append      %10lld records %10.2f s %10.1f ns/record, CPU %.1f ns/record\n",
+            static_cast<long long>(samples), seconds, seconds * 1e9 / samples, cpu * 1e9 / samples);
+        // Fewer if the samples do not fit into the file sized for kBytesPerSample
+        printf("            %10zu records kept\n", file.size());
+    }
+
+    HistoryFile file;
+    auto began = Clock::now();
+    if (!file.open(fileName, blocks)) {
+        fprintf(stderr, "%s\n", file.error().c_str());
+        return 1;
+    }
+    printf("reopen      %10.3f ms\n", secondsSince(began) * 1e3);
+
+    // The worker loads the retained range an hour at a time, polling other routers in between
+    std::vector<HistoryRecord> records;
+    size_t total = 0;
+    double longest = 0.0;
+    began = Clock::now();
+    for (int64_t from = start; from < end; from += kHour) {
+        auto chunkStart = Clock::now();
+        records.clear();
+        file.read(from, from + kHour, records);
+        total += records.size();
+        longest = std::max(longest, secondsSince(chunkStart));
+    }
+    double seconds = secondsSince(began);
+    printf("scan        %10zu records %10.2f s %10.1f ns/record, %.1f M records/s, longest hour %.3f ms\n",
+        total, seconds, seconds * 1e9 / total, total / seconds / 1e6, longest * 1e3);
+
+    for (int64_t range : { kHour, kDay, 30 * kDay, days * kDay }) {
+        int64_t from = end - range;
+        double readNs = BenchUtils::nsPerCall([&] {
+            records.clear();
+            file.read(from, end, records);
+        });
+        size_t count = records.size();
+        double summaryNs = BenchUtils::nsPerCall([&] {
+            BenchUtils::consume(file.summarize(from, end).download.maximum);
+        });
+        printf("range %5lld h: read %10zu records %12.1f us, summarize %10.1f us\n",
+            static_cast<long long>(range / kHour), count, readNs / 1e3, summaryNs / 1e3);
+    }
+
+    file.close();
+    DeleteFileW(fileName.c_str());
+    return 0;
+}
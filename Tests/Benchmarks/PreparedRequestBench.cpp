@@ -0,0 +1,158 @@
+// Client-side cost of a poll: the request set up with setUrl/addQueryHeader/doPost on every poll, as before,
+// against a prepared request pinned to the easy handle. First without a network, the transfer is prepared
+// and completed, then with the show/interface/rrd request sent to a mock router over keep-alive connections.
+// CPU time and allocations are those of the polling thread only, curl's allocations are counted separately.
+//
+// Usage: PreparedRequestBench [requests]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "AllocCounter.h"
+#include "BenchUtils.h"
+#include "Core/Network/NetworkClient.h"
+#include "MockRouter.h"
+
+namespace {
+
+thread_local uint64_t curlAllocations = 0;
+
+void* curlMalloc(size_t size) {
+    curlAllocations++;
+    return malloc(size);
+}
+
+void curlFree(void* p) {
+    free(p);
+}
+
+void* curlRealloc(void* p, size_t size) {
+    curlAllocations++;
+    return realloc(p, size);
+}
+
+char* curlStrdup(const char* str) {
+    curlAllocations++;
+    size_t size = strlen(str) + 1;
+    char* res = static_cast<char*>(malloc(size));
+    if (res) {
+        memcpy(res, str, size);
+    }
+    return res;
+}
+
+void* curlCalloc(size_t count, size_t size) {
+    curlAllocations++;
+    return calloc(count, size);
+}
+
+std::string rrdBody(size_t interfaces) {
+    std::string body = "[";
+    for (size_t i = 0; i < interfaces; i++) {
+        std::string name = i ? "GigabitEthernet0/Vlan" + std::to_string(i) : "ISP";
+        for (const char* attribute : { "rxspeed", "txspeed" }) {
+            if (body.size() > 1) {
+                body += ',';
+            }
+            body += "{\"name\":\"" + name + "\",\"attribute\":\"" + attribute + "\",\"detail\":0}";
+        }
+    }
+    return body + "]";
+}
+
+struct Cost {
+    double wallUs = 0.0;
+    double cpuUs = 0.0;
+    double allocations = 0.0;
+    double curlAllocations = 0.0;
+    size_t failures = 0;
+};
+
+// func returns false if the request failed
+template<class Func>
+Cost measure(size_t requests, Func&& func) {
+    // The connection is opened and the handle set up by the first requests
+    for (int i = 0; i < 10; i++) {
+        func();
+    }
+    Cost cost;
+    uint64_t allocationsBefore = AllocCounter::threadAllocations();
+    uint64_t curlBefore = curlAllocations;
+    double cpuBefore = BenchUtils::threadCpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < requests; i++) {
+        if (!func()) {
+            cost.failures++;
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double n = static_cast<double>(requests);
+    cost.wallUs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / 1e3 / n;
+    cost.cpuUs = (BenchUtils::threadCpuSeconds() - cpuBefore) * 1e6 / n;
+    cost.allocations = static_cast<double>(AllocCounter::threadAllocations() - allocationsBefore) / n;
+    cost.curlAllocations = static_cast<double>(curlAllocations - curlBefore) / n;
+    return cost;
+}
+
+void printCost(const char* name, const Cost& cost) {
+    printf("%-12s %10.2f %10.2f %14.1f %14.1f", name, cost.wallUs, cost.cpuUs, cost.allocations, cost.curlAllocations);
+    if (cost.failures) {
+        printf("   %zu failed", cost.failures);
+    }
+    printf("\n");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t requests = argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 20000;
+    // Before any client, so every allocation of curl goes through the counting functions
+    curl_global_init_mem(CURL_GLOBAL_ALL, curlMalloc, curlFree, curlRealloc, curlStrdup, curlCalloc);
+
+    MockRouter router(keeneticHandler());
+    const std::string url = router.url() + "/rci/show/interface/rrd";
+
+    printf("%-12s %10s %10s %14s %14s\n", "per request", "wall us", "cpu us", "C++ allocs", "curl allocs");
+    for (size_t interfaces : { 1, 16 }) {
+        const std::string body = rrdBody(interfaces);
+        auto prepared = std::make_shared<const NetworkClient::PreparedRequest>(url, "POST",
+            std::vector<std::pair<std::string, std::string>>{ { "Content-Type", "application/json" } }, body);
+        NetworkClient client;
+
+        // Nothing is received, the missing response code would be logged as an error
+        printf("\n%zu interfaces, %zu bytes of body, transfer prepared and completed without a network\n",
+            interfaces, body.size());
+        printCost("per poll", measure(requests * 10, [&] {
+            client.setUrl(url);
+            client.addQueryHeader("Content-Type", "application/json");
+            client.preparePost(body);
+            client.enableResponseCodeChecking(false);
+            return client.completeRequest(CURLE_OK);
+        }));
+        printCost("prepared", measure(requests * 10, [&] {
+            client.prepareRequest(prepared);
+            client.enableResponseCodeChecking(false);
+            return client.completeRequest(CURLE_OK);
+        }));
+
+        printf("%zu interfaces, sent to the mock router\n", interfaces);
+        printCost("per poll", measure(requests, [&] {
+            client.setUrl(url);
+            client.addQueryHeader("Content-Type", "application/json");
+            return client.doPost(body);
+        }));
+        printCost("prepared", measure(requests, [&] {
+            return client.doRequest(prepared);
+        }));
+    }
+    router.stop();
+    curl_global_cleanup();
+    return 0;
+}
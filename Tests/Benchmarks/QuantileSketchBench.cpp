@@ -0,0 +1,82 @@
+// Cost of the speed percentiles: adding a sample to the sketches of the history and querying a window,
+// against the exact percentile of the window samples kept in memory, found with nth_element.
+//
+// Usage: QuantileSketchBench
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "Plugin/QuantileSketch.h"
+
+namespace {
+
+constexpr int64_t kMinute = 60 * 1000;
+
+// Same tiers as InterfaceHistory: an hour in minute panes and a day in 10 minute panes
+const std::vector<SlidingQuantiles::Tier> kTiers = { { kMinute, 60 }, { 10 * kMinute, 144 } };
+
+std::vector<double> traffic(size_t count) {
+    std::mt19937_64 random(7);
+    std::lognormal_distribution<double> speed(9.0, 2.5);
+    std::vector<double> values;
+    for (size_t i = 0; i < count; i++) {
+        values.push_back(random() % 10 < 3 ? 0.0 : speed(random));
+    }
+    return values;
+}
+
+}
+
+int main() {
+    const size_t kDay = 24 * 60 * 60;
+    std::vector<double> values = traffic(kDay);
+
+    size_t next = 0;
+    QuantileSketch sketch;
+    double sketchNs = BenchUtils::nsPerCall([&] {
+        sketch.add(values[next++ % values.size()]);
+    });
+
+    // A day of samples every second, then the cost of adding the next ones
+    SlidingQuantiles quantiles(kTiers);
+    int64_t time = 0;
+    for (double value : values) {
+        quantiles.add(time, value);
+        time += 1000;
+    }
+    double slidingNs = BenchUtils::nsPerCall([&] {
+        quantiles.add(time, values[next++ % values.size()]);
+        time += 1000;
+    });
+
+    printf("Update, one sample every second\n");
+    printf("%-34s %10.1f ns\n", "QuantileSketch::add", sketchNs);
+    printf("%-34s %10.1f ns\n", "SlidingQuantiles::add (2 tiers)", slidingNs);
+    printf("%-34s %10zu KB per interface and direction\n\n", "sketch memory", quantiles.memoryUsage() / 1024);
+
+    printf("Query of the 95th percentile\n");
+    printf("%-10s %16s %16s %14s\n", "window", "sketch us", "exact us", "exact KB");
+    std::vector<double> window;
+    for (int64_t minutes : { 10, 60, 24 * 60 }) {
+        int64_t duration = minutes * kMinute;
+        double sketchQueryNs = BenchUtils::nsPerCall([&] {
+            BenchUtils::consume(quantiles.quantile(time, duration, 0.95));
+        });
+        size_t samples = static_cast<size_t>(duration / 1000);
+        std::deque<double> kept(values.end() - samples, values.end());
+        double exactNs = BenchUtils::nsPerCall([&] {
+            window.assign(kept.begin(), kept.end());
+            auto nth = window.begin() + static_cast<ptrdiff_t>(0.95 * (window.size() - 1));
+            std::nth_element(window.begin(), nth, window.end());
+            BenchUtils::consume(*nth);
+        });
+        printf("%-10s %16.2f %16.2f %14zu\n", (std::to_string(minutes) + " min").c_str(), sketchQueryNs / 1e3,
+            exactNs / 1e3, samples * sizeof(double) / 1024);
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Per-poll cost of the show/interface/rrd request body: built with jsoncpp and serialized on every poll,
+// then copied into the client's post buffer, as before, against the body serialized once into a prepared
+// request which every poll shares. The setup of the transfer itself is measured by PreparedRequestBench.
+//
+// Usage: RequestBodyBench
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+#include "AllocCounter.h"
+#include "BenchUtils.h"
+#include "Core/Network/NetworkClient.h"
+
+namespace {
+
+std::vector<std::string> interfaceNames(size_t count) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; i++) {
+        names.push_back(i ? "GigabitEthernet0/Vlan" + std::to_string(i) : "ISP");
+    }
+    return names;
+}
+
+std::string serializeRrdRequest(const std::vector<std::string>& interfaces, const std::string& indentation) {
+    Json::Value root(Json::arrayValue);
+    for (const std::string& name : interfaces) {
+        for (const char* attribute : { "rxspeed", "txspeed" }) {
+            Json::Value item;
+            item["name"] = name;
+            item["attribute"] = attribute;
+            item["detail"] = 0;
+            root.append(item);
+        }
+    }
+    Json::StreamWriterBuilder builder;
+    builder["commentStyle"] = "None";
+    builder["indentation"] = indentation;
+    return Json::writeString(builder, root);
+}
+
+struct Cost {
+    double ns;
+    double allocations;
+};
+
+template<class Func>
+Cost measure(Func&& func) {
+    constexpr int kCalls = 1000;
+    uint64_t before = AllocCounter::allocations();
+    for (int i = 0; i < kCalls; i++) {
+        func();
+    }
+    double allocations = static_cast<double>(AllocCounter::allocations() - before) / kCalls;
+    return { BenchUtils::nsPerCall(func), allocations };
+}
+
+}
+
+int main() {
+    const std::string url = "http://127.0.0.1/rci/show/interface/rrd";
+    std::string postData;
+
+    printf("Request body of a poll, nothing is sent.\n\n");
+    printf("%10s %10s %16s %16s %16s %16s\n", "interfaces", "bytes", "per poll ns", "per poll allocs",
+        "cached ns", "cached allocs");
+    for (size_t count : { 1, 4, 16, 64 }) {
+        std::vector<std::string> interfaces = interfaceNames(count);
+
+        Cost perPoll = measure([&] {
+            std::string body = serializeRrdRequest(interfaces, "   ");
+            postData = body;
+        });
+
+        auto request = std::make_shared<const NetworkClient::PreparedRequest>(url, "POST",
+            std::vector<std::pair<std::string, std::string>>{ { "Content-Type", "application/json" } },
+            serializeRrdRequest(interfaces, ""));
+        Cost cached = measure([&] {
+            std::shared_ptr<const NetworkClient::PreparedRequest> pinned = request;
+            BenchUtils::consume(static_cast<double>(pinned->body().size()));
+        });
+
+        printf("%10zu %10zu %16.0f %16.1f %16.0f %16.1f\n", count, request->body().size(),
+            perPoll.ns, perPoll.allocations, cached.ns, cached.allocations);
+    }
+    return 0;
+}
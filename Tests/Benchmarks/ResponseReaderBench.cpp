@@ -0,0 +1,87 @@
+// Throughput of the response readers on large responses of custom commands and show/interface/stat:
+// jsoncpp (also used by the default reader outside of show/interface/rrd) against simdjson On-Demand.
+//
+// Usage: ResponseReaderBench
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "BenchUtils.h"
+#include "Plugin/ResponseReader.h"
+#include "RouterResponses.h"
+
+namespace {
+
+struct Cost {
+    double us;
+    double megabytesPerSecond;
+    double allocations;
+};
+
+Cost measure(size_t bytes, const std::function<bool()>& read, ResponseReader& reader) {
+    auto call = [&] {
+        if (!read()) {
+            fprintf(stderr, "%s\n", reader.error().c_str());
+            std::exit(1);
+        }
+    };
+    // Buffers are warmed up by the first poll, as in the worker
+    call();
+    constexpr int kCalls = 20;
+    uint64_t before = AllocCounter::allocations();
+    for (int i = 0; i < kCalls; i++) {
+        call();
+    }
+    double allocations = static_cast<double>(AllocCounter::allocations() - before) / kCalls;
+    double ns = BenchUtils::nsPerCall(call);
+    return { ns / 1e3, bytes * 1e3 / ns, allocations };
+}
+
+void printRow(const char* command, const char* parser, size_t interfaces, size_t bytes, const Cost& cost) {
+    printf("%-9s %-9s %10zu %10zu %12.1f %10.0f %12.1f\n", command, parser, interfaces, bytes, cost.us,
+        cost.megabytesPerSecond, cost.allocations);
+}
+
+}
+
+int main() {
+    std::vector<std::pair<const char*, ResponseParser>> parsers = { { "jsoncpp", ResponseParser::JsonCpp } };
+#ifdef KEENETIC_WITH_SIMDJSON
+    parsers.emplace_back("simdjson", ResponseParser::SimdJson);
+#else
+    printf("Built without simdjson, only jsoncpp is measured.\n");
+#endif
+
+    std::vector<JsonFieldPath> compiled(3);
+    std::vector<const JsonFieldPath*> fields;
+    const char* paths[] = { ".stat.rxspeed", ".ports[1].speed", ".rxbytes" };
+    for (size_t i = 0; i < compiled.size(); i++) {
+        std::string error;
+        compiled[i].compile(paths[i], error);
+        fields.push_back(&compiled[i]);
+    }
+
+    printf("Reading a response, output vectors are reused between calls.\n"
+        "fields reads %zu fields of every element of show/interface, counters reads show/interface/stat.\n\n",
+        fields.size());
+    printf("%-9s %-9s %10s %10s %12s %10s %12s\n", "command", "parser", "interfaces", "bytes", "us", "MB/s", "allocs");
+    for (size_t interfaces : { 8, 64, 512, 2048 }) {
+        std::string body = interfaceResponse(interfaces);
+        for (const auto& parser : parsers) {
+            std::unique_ptr<ResponseReader> reader = ResponseReader::create(parser.second);
+            std::vector<double> values;
+            printRow("fields", parser.first, interfaces, body.size(),
+                measure(body.size(), [&] { return reader->readFields(body, fields, values); }, *reader));
+            std::vector<InterfaceCounters> counters;
+            printRow("counters", parser.first, interfaces, body.size(),
+                measure(body.size(), [&] { return reader->readCounters(body, counters); }, *reader));
+        }
+    }
+    return 0;
+}
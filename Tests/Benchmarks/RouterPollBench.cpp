@@ -0,0 +1,182 @@
+// CPU time and memory of polling many routers: one CurlMultiReactor for all of them,
+// as the plugin does, against the former thread per router blocking in curl_easy_perform.
+//
+// Usage: RouterPollBench                                    - all configurations, each in a new process
+//        RouterPollBench reactor|threads <routers> [seconds] [interval ms]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "Core/Network/CurlMultiReactor.h"
+#include "Core/Network/NetworkClient.h"
+#include "MockRouter.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    uint64_t polls = 0;
+    // Client side only, the mock router runs in the same process
+    double cpuSeconds = 0.0;
+    size_t threads = 0;
+};
+
+std::shared_ptr<const NetworkClient::PreparedRequest> rrdRequest(const std::string& url) {
+    std::string body = "[{\"name\":\"ISP\",\"attribute\":\"rxspeed\",\"detail\":0},"
+        "{\"name\":\"ISP\",\"attribute\":\"txspeed\",\"detail\":0}]";
+    return std::make_shared<const NetworkClient::PreparedRequest>(url + "/rci/show/interface/rrd", "POST",
+        std::vector<std::pair<std::string, std::string>>{ { "Content-Type", "application/json" } }, body);
+}
+
+struct ReactorRouter {
+    std::unique_ptr<NetworkClient> client;
+    Clock::time_point deadline;
+};
+
+class ReactorPoller {
+public:
+    ReactorPoller(std::shared_ptr<const NetworkClient::PreparedRequest> request, Clock::duration interval,
+        Clock::time_point stopAt, size_t routers) :
+        request_(std::move(request)), interval_(interval), stopAt_(stopAt), remaining_(routers) {
+    }
+
+    void poll(ReactorRouter& router) {
+        router.client->prepareRequest(request_);
+        reactor_.addTransfer(router.client->getCurlHandle(), [this, &router](CURLcode result) {
+            router.client->completeRequest(result);
+            polls_++;
+            router.deadline += interval_;
+            if (router.deadline < stopAt_) {
+                reactor_.scheduleAt(router.deadline, [this, &router] { poll(router); });
+            } else if (--remaining_ == 0) {
+                done_.set_value();
+            }
+        });
+    }
+
+    Result run(size_t count, Clock::time_point start) {
+        std::vector<ReactorRouter> routers(count);
+        for (ReactorRouter& router : routers) {
+            router.client = std::make_unique<NetworkClient>();
+            router.deadline = start;
+        }
+        reactor_.start();
+        double cpuBefore = 0.0;
+        reactor_.invoke([&] { cpuBefore = BenchUtils::threadCpuSeconds(); });
+        for (ReactorRouter& router : routers) {
+            reactor_.scheduleAt(start, [this, &router] { poll(router); });
+        }
+        done_.get_future().wait();
+
+        Result result;
+        reactor_.invoke([&] { result.cpuSeconds = BenchUtils::threadCpuSeconds() - cpuBefore; });
+        reactor_.stop();
+        result.polls = polls_;
+        result.threads = 1;
+        return result;
+    }
+
+private:
+    CurlMultiReactor reactor_;
+    std::shared_ptr<const NetworkClient::PreparedRequest> request_;
+    Clock::duration interval_;
+    Clock::time_point stopAt_;
+    std::atomic<size_t> remaining_;
+    uint64_t polls_ = 0;
+    std::promise<void> done_;
+};
+
+Result runThreads(size_t count, std::shared_ptr<const NetworkClient::PreparedRequest> request,
+    Clock::duration interval, Clock::time_point start, Clock::time_point stopAt) {
+    std::atomic<uint64_t> polls{ 0 };
+    std::vector<double> cpu(count);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < count; i++) {
+        threads.emplace_back([&, i] {
+            NetworkClient client;
+            std::this_thread::sleep_until(start);
+            for (Clock::time_point deadline = start; deadline < stopAt; deadline += interval) {
+                client.doRequest(request);
+                polls++;
+                std::this_thread::sleep_until(deadline + interval);
+            }
+            cpu[i] = BenchUtils::threadCpuSeconds();
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    Result result;
+    result.polls = polls;
+    result.threads = count;
+    for (double seconds : cpu) {
+        result.cpuSeconds += seconds;
+    }
+    return result;
+}
+
+int runOne(const std::string& mode, size_t routers, double seconds, int intervalMs) {
+    MockRouter router(keeneticHandler());
+    auto request = rrdRequest(router.url());
+    auto interval = std::chrono::milliseconds(intervalMs);
+    auto duration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    size_t rssBefore = BenchUtils::residentBytes();
+    Clock::time_point start = Clock::now() + std::chrono::milliseconds(100);
+    Clock::time_point stopAt = start + duration;
+
+    // Memory is sampled in the middle of the run, when all clients are connected
+    size_t rssRunning = 0;
+    std::thread sampler([&] {
+        std::this_thread::sleep_until(start + duration / 2);
+        rssRunning = BenchUtils::residentBytes();
+    });
+    Result result;
+    if (mode == "reactor") {
+        result = ReactorPoller(request, interval, stopAt, routers).run(routers, start);
+    } else {
+        result = runThreads(routers, request, interval, start, stopAt);
+    }
+    sampler.join();
+
+    printf("%-8s %8zu %8zu %10llu %14.3f %14.1f\n", mode.c_str(), routers, result.threads,
+        static_cast<unsigned long long>(result.polls), result.cpuSeconds * 1e3 / seconds,
+        (static_cast<double>(rssRunning) - static_cast<double>(rssBefore)) / 1024.0);
+    return 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    NetworkClient::curl_init();
+    if (argc >= 3) {
+        return runOne(argv[1], strtoul(argv[2], nullptr, 10), argc > 3 ? atof(argv[3]) : 3.0,
+            argc > 4 ? atoi(argv[4]) : 200);
+    }
+
+    printf("Polling the mock router every 200 ms for 3 s. CPU and threads are of the client side,\n"
+        "memory is the growth of the resident set of the process while polling.\n\n");
+    printf("%-8s %8s %8s %10s %14s %14s\n", "mode", "routers", "threads", "polls", "CPU ms/s", "RSS delta KB");
+    fflush(stdout);
+    for (const char* count : { "1", "10", "100" }) {
+        for (const char* mode : { "reactor", "threads" }) {
+            // A new process for every configuration, so the heap of one does not serve the next
+            std::string command = "\"" + std::string(argv[0]) + "\" " + mode + " " + count;
+            if (std::system(command.c_str()) != 0) {
+                return 1;
+            }
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
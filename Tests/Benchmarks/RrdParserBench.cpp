@@ -0,0 +1,67 @@
+// Cost of reading the show/interface/rrd response of a poll: the streaming RrdParser, which reuses
+// the series between polls, against the jsoncpp DOM it replaced.
+//
+// Usage: RrdParserBench
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "BenchUtils.h"
+#include "Plugin/ResponseReader.h"
+#include "RouterResponses.h"
+
+namespace {
+
+struct Cost {
+    double us;
+    double megabytesPerSecond;
+    double allocations;
+};
+
+Cost measure(ResponseReader& reader, const std::string& body, bool withSamples) {
+    std::vector<RrdSeries> series;
+    auto read = [&] {
+        if (!reader.readRrd(body, series, withSamples)) {
+            fprintf(stderr, "%s\n", reader.error().c_str());
+            std::exit(1);
+        }
+        BenchUtils::consume(series.empty() ? 0.0 : series.back().value);
+    };
+
+    // The series are warmed up by the first poll, as in the worker
+    read();
+    constexpr int kCalls = 200;
+    uint64_t before = AllocCounter::allocations();
+    for (int i = 0; i < kCalls; i++) {
+        read();
+    }
+    double allocations = static_cast<double>(AllocCounter::allocations() - before) / kCalls;
+    double ns = BenchUtils::nsPerCall(read);
+    return { ns / 1e3, body.size() * 1e3 / ns, allocations };
+}
+
+}
+
+int main() {
+    std::unique_ptr<ResponseReader> streaming = ResponseReader::create(ResponseParser::Default);
+    std::unique_ptr<ResponseReader> jsoncpp = ResponseReader::create(ResponseParser::JsonCpp);
+
+    printf("Reading a response, series are reused between calls. Samples of 60 is the history backfill.\n\n");
+    printf("%8s %8s %10s | %10s %10s %10s | %10s %10s %10s\n", "series", "samples", "bytes",
+        "rrd us", "rrd MB/s", "rrd allocs", "json us", "json MB/s", "json allocs");
+    for (size_t samples : { 1, 60 }) {
+        for (size_t series : { 2, 8, 32, 128, 512 }) {
+            std::string body = rrdResponse(series, 1700000000, samples);
+            bool withSamples = samples > 1;
+            Cost rrd = measure(*streaming, body, withSamples);
+            Cost json = measure(*jsoncpp, body, withSamples);
+            printf("%8zu %8zu %10zu | %10.2f %10.0f %10.1f | %10.2f %10.0f %10.1f\n", series, samples, body.size(),
+                rrd.us, rrd.megabytesPerSecond, rrd.allocations, json.us, json.megabytesPerSecond, json.allocations);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Size and speed of the compressed history blocks against the 16 bytes of a raw HistoryRecord,
+// for a day of samples taken every second under several kinds of traffic.
+//
+// Usage: SampleBlockBench
+
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "Plugin/SampleBlock.h"
+
+namespace {
+
+constexpr size_t kSamples = 24 * 60 * 60;
+
+struct Block {
+    alignas(8) uint8_t data[SampleBlock::kSize];
+};
+
+class Random {
+public:
+    uint32_t next() {
+        state_ = state_ * 1664525u + 1013904223u;
+        return state_ >> 8;
+    }
+
+private:
+    uint32_t state_ = 12345;
+};
+
+using Generator = std::function<HistoryRecord(int64_t time, Random& random)>;
+
+std::vector<HistoryRecord> generate(const Generator& generator, int64_t jitter) {
+    std::vector<HistoryRecord> records;
+    Random random;
+    int64_t time = 1700000000000;
+    for (size_t i = 0; i < kSamples; i++) {
+        // Polls are not exactly a second apart when the router is slow to answer
+        time += 1000 + (jitter ? static_cast<int64_t>(random.next() % (2 * jitter + 1)) - jitter : 0);
+        records.push_back(generator(time, random));
+    }
+    return records;
+}
+
+std::vector<Block> encode(const std::vector<HistoryRecord>& records) {
+    std::vector<Block> blocks(1);
+    SampleBlock::Writer writer;
+    writer.start(blocks.back().data);
+    for (const HistoryRecord& record : records) {
+        if (!writer.append(record)) {
+            blocks.emplace_back();
+            writer.start(blocks.back().data);
+            writer.append(record);
+        }
+    }
+    return blocks;
+}
+
+size_t decode(const std::vector<Block>& blocks) {
+    size_t count = 0;
+    HistoryRecord record;
+    for (const Block& block : blocks) {
+        SampleBlock::Reader reader(block.data);
+        while (reader.next(record)) {
+            count++;
+        }
+    }
+    BenchUtils::consume(record.download);
+    return count;
+}
+
+}
+
+int main() {
+    struct Traffic {
+        const char* name;
+        Generator generator;
+        int64_t jitter;
+    };
+    const Traffic traffic[] = {
+        { "idle", [](int64_t, Random& random) {
+            return HistoryRecord{ 0, random.next() % 60 ? 0.0f : 1500.0f, 0.0f };
+        }, 0 },
+        { "home", [](int64_t, Random& random) {
+            // Mostly background chatter with downloads now and then
+            bool burst = random.next() % 100 < 15;
+            float download = burst ? 5e6f + random.next() % 50000000 : static_cast<float>(random.next() % 4000);
+            return HistoryRecord{ 0, download, download / 40 };
+        }, 0 },
+        { "home, jittered polls", [](int64_t, Random& random) {
+            bool burst = random.next() % 100 < 15;
+            float download = burst ? 5e6f + random.next() % 50000000 : static_cast<float>(random.next() % 4000);
+            return HistoryRecord{ 0, download, download / 40 };
+        }, 30 },
+        { "saturated, noisy", [](int64_t, Random& random) {
+            return HistoryRecord{ 0, 1e8f + random.next() % 10000000, 2e7f + random.next() % 1000000 };
+        }, 0 },
+    };
+
+    printf("A day of samples every second, %zu samples. Raw records take %zu bytes.\n\n", kSamples,
+        sizeof(HistoryRecord));
+    printf("%-22s %8s %14s %10s %14s %14s\n", "traffic", "blocks", "bytes/sample", "ratio", "encode ns", "decode ns");
+    for (const Traffic& item : traffic) {
+        std::vector<HistoryRecord> records = generate([&](int64_t time, Random& random) {
+            HistoryRecord record = item.generator(time, random);
+            record.time = time;
+            return record;
+        }, item.jitter);
+
+        std::vector<Block> blocks = encode(records);
+        double bytesPerSample = static_cast<double>(blocks.size() * SampleBlock::kSize) / records.size();
+        double encodeNs = BenchUtils::nsPerCall([&] { BenchUtils::consume(static_cast<double>(encode(records).size())); });
+        double decodeNs = BenchUtils::nsPerCall([&] {
+            if (decode(blocks) != records.size()) {
+                printf("decoded records do not match\n");
+            }
+        });
+        printf("%-22s %8zu %14.2f %10.1f %14.1f %14.1f\n", item.name, blocks.size(), bytesPerSample,
+            sizeof(HistoryRecord) / bytesPerSample, encodeNs / records.size(), decodeNs / records.size());
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Cost of a frame of Rainmeter measures reading interface speeds while the worker publishes new ones:
+// the seqlock of SpeedTable against the former mutex held by the worker for the whole response parse.
+//
+// Usage: SpeedTableBench [measures] [seconds]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "Plugin/SpeedTable.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kInterfaces = 8;
+
+// Time the worker spends parsing a response and logging, before or while publishing
+void parseResponse(std::vector<InterfaceSpeed>& speeds, double n) {
+    auto until = Clock::now() + std::chrono::microseconds(200);
+    while (Clock::now() < until) {
+    }
+    for (InterfaceSpeed& speed : speeds) {
+        speed = { n, n };
+    }
+}
+
+class MutexTable {
+public:
+    template<class Func> void update(Func&& func) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        func(speeds_);
+    }
+
+    InterfaceSpeed read(size_t index) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        return speeds_[index];
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<InterfaceSpeed> speeds_ = std::vector<InterfaceSpeed>(kInterfaces);
+};
+
+struct FrameStats {
+    uint64_t frames = 0;
+    double meanUs = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+};
+
+template<class ReadFunc>
+FrameStats readFrames(size_t measures, Clock::time_point stopAt, ReadFunc&& read) {
+    std::vector<double> frameUs;
+    double sum = 0.0;
+    while (Clock::now() < stopAt) {
+        auto start = Clock::now();
+        for (size_t m = 0; m < measures; m++) {
+            InterfaceSpeed speed = read(m % kInterfaces);
+            sum += speed.download;
+        }
+        frameUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        // Rainmeter redraws a skin at most every 16 ms, frames are packed here to get more of them
+        std::this_thread::yield();
+    }
+    BenchUtils::consume(sum);
+
+    FrameStats stats;
+    stats.frames = frameUs.size();
+    if (frameUs.empty()) {
+        return stats;
+    }
+    std::sort(frameUs.begin(), frameUs.end());
+    for (double us : frameUs) {
+        stats.meanUs += us / frameUs.size();
+    }
+    stats.p99Us = frameUs[frameUs.size() * 99 / 100];
+    stats.maxUs = frameUs.back();
+    return stats;
+}
+
+void print(const char* name, size_t measures, bool publishing, const FrameStats& stats) {
+    printf("%-8s %9zu %11s %10llu %12.2f %12.2f %12.2f\n", name, measures, publishing ? "yes" : "no",
+        static_cast<unsigned long long>(stats.frames), stats.meanUs, stats.p99Us, stats.maxUs);
+}
+
+template<class PublishFunc, class ReadFunc>
+FrameStats run(size_t measures, double seconds, bool publishing, PublishFunc&& publish, ReadFunc&& read) {
+    Clock::time_point stopAt = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    std::thread writer;
+    if (publishing) {
+        writer = std::thread([&] {
+            double n = 0.0;
+            while (Clock::now() < stopAt) {
+                publish(++n);
+            }
+        });
+    }
+    FrameStats stats = readFrames(measures, stopAt, read);
+    if (writer.joinable()) {
+        writer.join();
+    }
+    return stats;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t measures = argc > 1 ? strtoul(argv[1], nullptr, 10) : 300;
+    double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+
+    printf("Frames of %zu measure reads, the worker publishing continuously (200 us parse per response).\n\n", measures);
+    printf("%-8s %9s %11s %10s %12s %12s %12s\n", "table", "measures", "publishing", "frames", "mean us", "p99 us", "max us");
+
+    for (bool publishing : { false, true }) {
+        SpeedTable table(kInterfaces);
+        std::vector<InterfaceSpeed> speeds(kInterfaces);
+        FrameStats stats = run(measures, seconds, publishing, [&](double n) {
+            // The snapshot is built off-lock, only the copy is sequenced
+            parseResponse(speeds, n);
+            table.publish(speeds);
+        }, [&](size_t index) { return table.read(index); });
+        print("seqlock", measures, publishing, stats);
+    }
+
+    for (bool publishing : { false, true }) {
+        MutexTable table;
+        FrameStats stats = run(measures, seconds, publishing, [&](double n) {
+            table.update([&](std::vector<InterfaceSpeed>& speeds) { parseResponse(speeds, n); });
+        }, [&](size_t index) { return table.read(index); });
+        print("mutex", measures, publishing, stats);
+    }
+    return 0;
+}
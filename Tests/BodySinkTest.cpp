@@ -0,0 +1,113 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include "Core/Network/BodySink.h"
+#include "Core/Network/NetworkClient.h"
+#include "MockRouter.h"
+#include "RouterResponses.h"
+#include "TestUtils.h"
+
+namespace {
+
+class RecordingSink : public BodySink {
+public:
+    // Stops the transfer once this many bytes were received, zero to receive all of them
+    explicit RecordingSink(size_t stopAfter = 0) : stopAfter_(stopAfter) {
+    }
+
+    bool begin(int64_t contentLength) override {
+        begins++;
+        this->contentLength = contentLength;
+        return true;
+    }
+
+    bool write(const char* data, size_t size) override {
+        writes++;
+        body.append(data, size);
+        return !stopAfter_ || body.size() < stopAfter_;
+    }
+
+    void end() override {
+        ends++;
+    }
+
+    int begins = 0;
+    int writes = 0;
+    int ends = 0;
+    int64_t contentLength = 0;
+    std::string body;
+
+private:
+    size_t stopAfter_;
+};
+
+MockRouter::Handler chunkedHandler(const std::string& body) {
+    return [body](const MockRequest&) {
+        MockResponse response;
+        response.body = body;
+        response.chunkSize = 16 * 1024;
+        return response;
+    };
+}
+
+}
+
+TEST(SinkReceivesWholeBody) {
+    const std::string body = interfaceResponse(500);
+    MockRouter router(chunkedHandler(body));
+    NetworkClient client;
+    auto sink = std::make_shared<RecordingSink>();
+    client.setBodySink(sink);
+    CHECK(client.doGet(router.url() + "/rci/show/interface"));
+    CHECK(sink->begins == 1);
+    CHECK(sink->ends == 1);
+    CHECK(sink->writes > 1);
+    CHECK(sink->contentLength == static_cast<int64_t>(body.size()));
+    CHECK(sink->body == body);
+    // Nothing was buffered by the client
+    CHECK(client.responseBodyView().empty());
+
+    // The sink is used for one request only
+    CHECK(client.doGet(router.url() + "/rci/show/interface"));
+    CHECK(sink->begins == 1);
+    CHECK(client.responseBodyView() == body);
+}
+
+TEST(SinkCanStopTransfer) {
+    const std::string body = interfaceResponse(500);
+    MockRouter router(chunkedHandler(body));
+    NetworkClient client;
+    auto sink = std::make_shared<RecordingSink>(1000);
+    client.setBodySink(sink);
+    CHECK(!client.doGet(router.url() + "/rci/show/interface"));
+    CHECK(client.getCurlResult() == CURLE_WRITE_ERROR);
+    CHECK(sink->ends == 1);
+    CHECK(sink->body.size() >= 1000);
+    CHECK(sink->body.size() < body.size());
+    CHECK(body.compare(0, sink->body.size(), sink->body) == 0);
+
+    // The client is usable after the aborted transfer
+    CHECK(client.doGet(router.url() + "/rci/show/interface"));
+    CHECK(client.responseBodyView() == body);
+}
+
+TEST(FileSinkWritesBody) {
+    const std::string body = interfaceResponse(100);
+    MockRouter router(chunkedHandler(body));
+    const std::string fileName = "BodySinkTest.json";
+    std::remove(fileName.c_str());
+    {
+        NetworkClient client;
+        client.setBodySink(std::make_shared<FileBodySink>(fileName));
+        CHECK(client.doGet(router.url() + "/rci/show/interface"));
+    }
+    std::ifstream file(fileName, std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    CHECK(written == body);
+    std::remove(fileName.c_str());
+}
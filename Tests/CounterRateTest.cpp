@@ -0,0 +1,131 @@
+#include <cstdint>
+
+#include "Plugin/CounterRate.h"
+#include "TestUtils.h"
+
+namespace {
+
+using Result = ByteCounterRate::Result;
+
+constexpr int64_t kSecond = 1000000;
+constexpr uint64_t kCounter32 = uint64_t(1) << 32;
+constexpr uint64_t kMax64 = ~uint64_t(0);
+
+struct Reading {
+    Result result;
+    double rx;
+    double tx;
+};
+
+Reading read(ByteCounterRate& rate, int64_t time, uint64_t rxBytes, uint64_t txBytes) {
+    Reading reading{ Result::Baseline, -1.0, -1.0 };
+    reading.result = rate.update(time, rxBytes, txBytes, reading.rx, reading.tx);
+    return reading;
+}
+
+}
+
+TEST(RatesFromConsecutiveReadings) {
+    ByteCounterRate rate;
+    CHECK(read(rate, 10 * kSecond, 1000, 5000).result == Result::Baseline);
+    Reading reading = read(rate, 12 * kSecond, 3000, 5000);
+    CHECK(reading.result == Result::Rate);
+    CHECK(reading.rx == 1000.0);
+    CHECK(reading.tx == 0.0);
+    // Intervals are not rounded to seconds
+    reading = read(rate, 12 * kSecond + 250000, 3000 + 250, 5000 + 25000);
+    CHECK(reading.result == Result::Rate);
+    CHECK_NEAR(reading.rx, 1000.0, 1e-9);
+    CHECK_NEAR(reading.tx, 100000.0, 1e-9);
+}
+
+TEST(ThirtyTwoBitCountersWrap) {
+    ByteCounterRate rate;
+    read(rate, 0, kCounter32 - 1000, kCounter32 - 1);
+    Reading reading = read(rate, kSecond, 500, 99);
+    CHECK(reading.result == Result::Rate);
+    CHECK(reading.rx == 1500.0);
+    CHECK(reading.tx == 100.0);
+
+    // At gigabit speeds a 32-bit counter wraps every 4 seconds
+    const uint64_t gigabit = 125000000;
+    uint64_t rx = 4000000000;
+    read(rate, 10 * kSecond, rx, 0);
+    reading = read(rate, 11 * kSecond, (rx + gigabit) % kCounter32, 0);
+    CHECK(reading.result == Result::Rate);
+    CHECK(reading.rx == static_cast<double>(gigabit));
+}
+
+TEST(SixtyFourBitCountersWrap) {
+    ByteCounterRate rate;
+    read(rate, 0, kMax64 - 999, 7000000000);
+    Reading reading = read(rate, kSecond, 1000, 7000000000 + 4096);
+    CHECK(reading.result == Result::Rate);
+    CHECK(reading.rx == 2000.0);
+    CHECK(reading.tx == 4096.0);
+}
+
+TEST(ImplausibleDropsAreResets) {
+    ByteCounterRate rate;
+    // A 64-bit counter restarted with the interface
+    read(rate, 0, 50000000000, 1000);
+    Reading reading = read(rate, kSecond, 1000, 2000);
+    CHECK(reading.result == Result::Reset);
+    CHECK(reading.rx == -1.0);
+    // The reading is the new baseline
+    reading = read(rate, 2 * kSecond, 3000, 2000);
+    CHECK(reading.result == Result::Rate);
+    CHECK(reading.rx == 2000.0);
+
+    // A 32-bit counter dropping further than a second of the fastest port could wrap it
+    read(rate, 10 * kSecond, 1000000, 0);
+    CHECK(read(rate, 11 * kSecond, 10, 0).result == Result::Reset);
+    read(rate, 20 * kSecond, 3000000000, 0);
+    CHECK(read(rate, 21 * kSecond, 100, 0).result == Result::Reset);
+
+    // Only one direction was reset
+    read(rate, 30 * kSecond, 5000, 5000000000);
+    CHECK(read(rate, 31 * kSecond, 6000, 10).result == Result::Reset);
+}
+
+TEST(ImplausibleJumpsAreResets) {
+    ByteCounterRate rate;
+    read(rate, 0, 1000, 1000);
+    // More than 10 Gbit/s
+    CHECK(read(rate, kSecond, 1000 + 5000000000, 1000).result == Result::Reset);
+    // Large deltas are fine when the readings are far apart
+    CHECK(read(rate, 101 * kSecond, 1000 + 5000000000 + 100000000000, 1000).result == Result::Rate);
+}
+
+TEST(TimeMustIncrease) {
+    ByteCounterRate rate;
+    read(rate, 10 * kSecond, 1000, 1000);
+    CHECK(read(rate, 10 * kSecond, 2000, 2000).result == Result::Baseline);
+    CHECK(read(rate, 5 * kSecond, 3000, 3000).result == Result::Baseline);
+    Reading reading = read(rate, 6 * kSecond, 4000, 3000);
+    CHECK(reading.result == Result::Rate);
+    CHECK(reading.rx == 1000.0);
+
+    rate.reset();
+    CHECK(read(rate, 7 * kSecond, 5000, 3000).result == Result::Baseline);
+}
+
+TEST(LongGapsStartNewBaseline) {
+    // Polled every second, the router rebooted meanwhile: a 64-bit counter below 2^32 came back near zero,
+    // which over 60 seconds would pass for a wrap of a 32-bit counter
+    ByteCounterRate rate(3 * kSecond);
+    read(rate, 0, 3000000000, 1000);
+    Reading reading = read(rate, 60 * kSecond, 1000, 2000);
+    CHECK(reading.result == Result::Baseline);
+    CHECK(reading.rx == -1.0);
+    reading = read(rate, 61 * kSecond, 3000, 2500);
+    CHECK(reading.result == Result::Rate);
+    CHECK(reading.rx == 2000.0);
+    CHECK(reading.tx == 500.0);
+
+    // Within the interval wraps are still recognized
+    read(rate, 70 * kSecond, kCounter32 - 1000, 0);
+    reading = read(rate, 73 * kSecond, 2000, 0);
+    CHECK(reading.result == Result::Rate);
+    CHECK(reading.rx == 1000.0);
+}
@@ -0,0 +1,125 @@
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "Core/Network/CurlMultiReactor.h"
+#include "Core/Network/NetworkClient.h"
+#include "MockRouter.h"
+#include "TestUtils.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+MockRouter::Handler delayedHandler(std::chrono::milliseconds delay) {
+    return [delay](const MockRequest&) {
+        MockResponse response;
+        response.body = "ok";
+        response.delay = delay;
+        return response;
+    };
+}
+
+// Starts a GET of the client on the reactor, the future receives the curl result
+std::future<CURLcode> startGet(CurlMultiReactor& reactor, NetworkClient& client, const std::string& url) {
+    auto done = std::make_shared<std::promise<CURLcode>>();
+    std::future<CURLcode> future = done->get_future();
+    client.prepareGet(url);
+    reactor.post([&reactor, &client, done] {
+        reactor.addTransfer(client.getCurlHandle(), [done](CURLcode result) {
+            done->set_value(result);
+        });
+    });
+    return future;
+}
+
+}
+
+TEST(TasksRunOnReactorThread) {
+    CurlMultiReactor reactor;
+    reactor.start();
+    std::promise<bool> done;
+    CHECK(reactor.post([&] { done.set_value(reactor.isReactorThread()); }));
+    CHECK(done.get_future().get());
+    CHECK(!reactor.isReactorThread());
+
+    int value = 0;
+    reactor.invoke([&] { value = 42; });
+    CHECK(value == 42);
+}
+
+TEST(PostFailsAfterStop) {
+    CurlMultiReactor reactor;
+    reactor.start();
+    reactor.stop();
+    CHECK(!reactor.post([] {}));
+    // Nothing else can touch the state, so the task runs on the calling thread
+    bool invoked = false;
+    reactor.invoke([&] { invoked = true; });
+    CHECK(invoked);
+}
+
+TEST(TimersFireInOrderUnlessCancelled) {
+    CurlMultiReactor reactor;
+    reactor.start();
+    std::vector<int> fired;
+    std::promise<void> done;
+    auto now = Clock::now();
+    reactor.scheduleAt(now + std::chrono::milliseconds(30), [&] { fired.push_back(2); });
+    CurlMultiReactor::TimerId cancelled = reactor.scheduleAt(now + std::chrono::milliseconds(20), [&] { fired.push_back(99); });
+    reactor.scheduleAt(now + std::chrono::milliseconds(10), [&] { fired.push_back(1); });
+    reactor.scheduleAt(now + std::chrono::milliseconds(60), [&] { done.set_value(); });
+    reactor.cancelTimer(cancelled);
+    done.get_future().wait();
+    CHECK((fired == std::vector<int>{ 1, 2 }));
+}
+
+TEST(TransfersRunConcurrently) {
+    MockRouter router(delayedHandler(std::chrono::milliseconds(200)));
+    CurlMultiReactor reactor;
+    reactor.start();
+
+    std::vector<std::unique_ptr<NetworkClient>> clients;
+    std::vector<std::future<CURLcode>> results;
+    auto start = Clock::now();
+    for (int i = 0; i < 10; i++) {
+        clients.push_back(std::make_unique<NetworkClient>());
+        results.push_back(startGet(reactor, *clients.back(), router.url()));
+    }
+    for (size_t i = 0; i < results.size(); i++) {
+        CHECK(results[i].get() == CURLE_OK);
+        reactor.invoke([&] { clients[i]->completeRequest(CURLE_OK); });
+        CHECK(clients[i]->responseCode() == 200);
+        CHECK(clients[i]->responseBodyView() == "ok");
+    }
+    // Ten sequential requests would take two seconds
+    CHECK(Clock::now() - start < std::chrono::milliseconds(1000));
+}
+
+TEST(StopDrainsTransfersInFlight) {
+    MockRouter router(delayedHandler(std::chrono::milliseconds(50)));
+    CurlMultiReactor reactor;
+    reactor.start();
+    NetworkClient client;
+    std::future<CURLcode> result = startGet(reactor, client, router.url());
+    reactor.invoke([] {});
+    reactor.stop(std::chrono::milliseconds(1000));
+    CHECK(result.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    CHECK(result.get() == CURLE_OK);
+}
+
+TEST(StopAbortsTransfersAfterDrainTimeout) {
+    MockRouter router(delayedHandler(std::chrono::milliseconds(10000)));
+    CurlMultiReactor reactor;
+    reactor.start();
+    NetworkClient client;
+    std::future<CURLcode> result = startGet(reactor, client, router.url());
+    reactor.invoke([] {});
+
+    auto start = Clock::now();
+    reactor.stop(std::chrono::milliseconds(100));
+    CHECK(Clock::now() - start < std::chrono::milliseconds(1000));
+    CHECK(result.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    CHECK(result.get() == CURLE_ABORTED_BY_CALLBACK);
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Plugin/Downsampler.h"
+#include "ReferenceLttb.h"
+#include "TestUtils.h"
+
+namespace {
+
+struct Series {
+    std::vector<double> x;
+    std::vector<double> y;
+
+    void add(double px, double py) {
+        x.push_back(px);
+        y.push_back(py);
+    }
+
+    std::vector<PlotPoint> points() const {
+        std::vector<PlotPoint> res;
+        for (size_t i = 0; i < x.size(); i++) {
+            res.push_back(PlotPoint{ x[i], y[i] });
+        }
+        return res;
+    }
+};
+
+std::vector<PlotPoint> lttb(const Series& series, size_t threshold) {
+    std::vector<PlotPoint> out;
+    Downsampler::lttb(series.x.data(), series.y.data(), series.x.size(), threshold, out);
+    return out;
+}
+
+bool samePoints(const std::vector<PlotPoint>& a, const std::vector<PlotPoint>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].x != b[i].x || a[i].y != b[i].y) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Background traffic of a second of the day with bursts
+Series traffic(size_t size, unsigned seed) {
+    Series series;
+    unsigned state = seed;
+    for (size_t i = 0; i < size; i++) {
+        state = state * 1664525u + 1013904223u;
+        double noise = (state >> 8) % 1000;
+        series.add(static_cast<double>(i), (i / 600) % 7 == 3 ? 5e6 + noise * 100 : noise);
+    }
+    return series;
+}
+
+}
+
+TEST(PointsAreCopiedWhenFewEnough) {
+    Series series = traffic(100, 1);
+    CHECK(samePoints(lttb(series, 100), series.points()));
+    CHECK(samePoints(lttb(series, 500), series.points()));
+    CHECK(lttb(Series(), 10).empty());
+}
+
+TEST(EndpointsAreKept) {
+    Series series = traffic(1000, 2);
+    for (size_t threshold : { 1, 2, 3, 4, 17, 220, 999 }) {
+        std::vector<PlotPoint> out = lttb(series, threshold);
+        CHECK(out.size() == threshold);
+        CHECK(out.front().x == 0.0);
+        if (threshold > 1) {
+            CHECK(out.back().x == 999.0);
+        }
+        // Points are picked from the input, in order
+        for (size_t i = 1; i < out.size(); i++) {
+            CHECK(out[i - 1].x < out[i].x);
+            CHECK(out[i].y == series.y[static_cast<size_t>(out[i].x)]);
+        }
+    }
+    CHECK(lttb(series, 0).empty());
+}
+
+TEST(PeaksArePreserved) {
+    // A day of an idle link with a few one-second spikes, drawn with 220 points
+    Series series;
+    const size_t spikes[] = { 1000, 30000, 30001, 54321, 86000 };
+    for (size_t i = 0; i < 86400; i++) {
+        bool spike = std::find(std::begin(spikes), std::end(spikes), i) != std::end(spikes);
+        series.add(static_cast<double>(i), spike ? 1e8 + i : 100.0 + i % 3);
+    }
+    std::vector<PlotPoint> out = lttb(series, 220);
+    CHECK(out.size() == 220);
+    for (size_t spike : { 1000, 30000, 54321, 86000 }) {
+        bool found = false;
+        for (const PlotPoint& point : out) {
+            // Adjacent spikes share a bucket, one of them is kept
+            found = found || (point.x >= spike && point.x <= spike + 1 && point.y >= 1e8);
+        }
+        CHECK(found);
+    }
+
+    // Averaging buckets of the same size would lose them
+    double averagePeak = 0.0;
+    size_t bucket = series.y.size() / 220;
+    for (size_t begin = 0; begin + bucket <= series.y.size(); begin += bucket) {
+        double sum = 0.0;
+        for (size_t i = begin; i < begin + bucket; i++) {
+            sum += series.y[i];
+        }
+        averagePeak = std::max(averagePeak, sum / bucket);
+    }
+    CHECK(averagePeak < 1e8 / 100);
+}
+
+TEST(MatchesTheReferenceImplementation) {
+    std::vector<PlotPoint> expected;
+    for (unsigned seed = 1; seed <= 20; seed++) {
+        Series series = traffic(1000 + seed * 397, seed);
+        for (size_t threshold : { 3, 5, 50, 220, 999 }) {
+            referenceLttb(series.points(), threshold, expected);
+            CHECK(samePoints(lttb(series, threshold), expected));
+        }
+    }
+
+    // Uneven spacing, like rollup buckets clamped to the range
+    Series uneven;
+    double x = 0.0;
+    for (size_t i = 0; i < 5000; i++) {
+        x += 1.0 + (i % 13) * 0.25;
+        uneven.add(x, std::sin(i * 0.01) * 1000 + (i % 97 == 0 ? 5000 : 0));
+    }
+    referenceLttb(uneven.points(), 220, expected);
+    CHECK(samePoints(lttb(uneven, 220), expected));
+}
+
+TEST(OutputIsReused) {
+    std::vector<PlotPoint> out(500, PlotPoint{ -1.0, -1.0 });
+    Series series = traffic(1000, 3);
+    Downsampler::lttb(series.x.data(), series.y.data(), series.x.size(), 10, out);
+    CHECK(out.size() == 10);
+    CHECK(out.front().x == 0.0);
+}
@@ -0,0 +1,115 @@
+#include <cstdint>
+#include <string>
+
+#include "AllocCounter.h"
+#include "Core/Network/NetworkClient.h"
+#include "MockRouter.h"
+#include "TestUtils.h"
+
+namespace {
+
+// "/redirect" sends to "/final", the responses have headers of the same names with different values
+MockResponse respond(const MockRequest& request) {
+    MockResponse response;
+    if (request.path == "/redirect") {
+        response.status = 302;
+        response.headers = { { "Location", "/final" }, { "X-Response", "redirect" },
+            { "Content-Type", "text/html" } };
+    } else {
+        response.headers = { { "Content-Type", "application/json" }, { "X-NDM-Realm", "Keenetic Giga" },
+            { "Set-Cookie", "first=1" }, { "X-Response", "final" }, { "set-cookie", "second=2" },
+            { "X-Empty", "" } };
+        response.body = "{}";
+    }
+    return response;
+}
+
+}
+
+TEST(NamesAreComparedCaseInsensitively) {
+    MockRouter router(respond);
+    NetworkClient client;
+    CHECK(client.doGet(router.url() + "/final"));
+    CHECK(client.responseHeaderByName("Content-Type") == "application/json");
+    CHECK(client.responseHeaderByName("content-type") == "application/json");
+    CHECK(client.responseHeaderByName("CONTENT-TYPE") == "application/json");
+    CHECK(client.responseHeaderView("x-ndm-realm") == "Keenetic Giga");
+    // Present but empty, and absent
+    CHECK(client.responseHeaderByName("X-Empty").empty());
+    CHECK(client.responseHeaderByName("X-Missing").empty());
+    CHECK(client.responseHeaderByName("Content").empty());
+    CHECK(client.responseHeaderByName("Content-Type-Extra").empty());
+}
+
+TEST(RepeatedHeaderResolvesToFirst) {
+    MockRouter router(respond);
+    NetworkClient client;
+    CHECK(client.doGet(router.url() + "/final"));
+    CHECK(client.responseHeaderByName("Set-Cookie") == "first=1");
+    CHECK(client.responseHeaderByName("SET-COOKIE") == "first=1");
+    // Both occurrences are listed in the order received, with the names as sent
+    std::string name;
+    bool first = false;
+    bool second = false;
+    for (int i = 0; i < client.responseHeaderCount(); i++) {
+        std::string value = client.responseHeaderByIndex(i, name);
+        first = first || (name == "Set-Cookie" && value == "first=1");
+        second = second || (first && name == "set-cookie" && value == "second=2");
+    }
+    CHECK(first);
+    CHECK(second);
+    CHECK(client.responseHeaderByIndex(client.responseHeaderCount(), name).empty());
+}
+
+TEST(RedirectKeepsHeadersOfFinalResponse) {
+    MockRouter router(respond);
+    NetworkClient client;
+    CHECK(client.doGet(router.url() + "/redirect"));
+    CHECK(client.responseCode() == 200);
+    CHECK(router.requestCount() == 2);
+    CHECK(client.responseHeaderByName("X-Response") == "final");
+    CHECK(client.responseHeaderByName("Content-Type") == "application/json");
+    CHECK(client.responseHeaderByName("Location").empty());
+    // Content-Length is added by the router
+    CHECK(client.responseHeaderCount() == 7);
+    // The text has both responses
+    std::string text = client.responseHeaderText();
+    CHECK(text.find("HTTP/1.1 302") != std::string::npos);
+    CHECK(text.find("X-Response: redirect") != std::string::npos);
+
+    // A 401 answer and the next request, the headers are those of the last request only
+    MockRouter auth([](const MockRequest& request) {
+        MockResponse response;
+        if (request.method == "GET") {
+            response.status = 401;
+            response.headers = { { "X-NDM-Challenge", "challenge" }, { "X-NDM-Realm", "Keenetic Giga" } };
+        } else {
+            response.headers = { { "X-NDM-Realm", "after login" } };
+        }
+        return response;
+    });
+    client.enableResponseCodeChecking(false);
+    CHECK(client.doGet(auth.url() + "/auth"));
+    CHECK(client.responseCode() == 401);
+    CHECK(client.responseHeaderByName("X-NDM-Challenge") == "challenge");
+    CHECK(client.doPost("{}"));
+    CHECK(client.responseCode() == 200);
+    CHECK(client.responseHeaderByName("X-NDM-Challenge").empty());
+    CHECK(client.responseHeaderByName("x-ndm-realm") == "after login");
+}
+
+TEST(HeadersAreParsedOnlyWhenAccessed) {
+    MockRouter router(respond);
+    NetworkClient client;
+    CHECK(client.doGet(router.url() + "/final"));
+    // Polls which never read the headers leave them unparsed: the first access builds the index and allocates it,
+    // which it would not have to do if the request had parsed them already
+    uint64_t before = AllocCounter::threadAllocations();
+    CHECK(client.responseHeaderView("X-Response") == "final");
+    CHECK(AllocCounter::threadAllocations() > before);
+    // Parsed once per response
+    before = AllocCounter::threadAllocations();
+    CHECK(client.responseHeaderView("Content-Type") == "application/json");
+    CHECK(client.responseHeaderCount() == 7);
+    CHECK(AllocCounter::threadAllocations() == before);
+}
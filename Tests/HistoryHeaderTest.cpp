@@ -0,0 +1,98 @@
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "Plugin/HistoryHeader.h"
+#include "TestUtils.h"
+
+namespace {
+
+bool isState(const HistoryCommitState* state, uint64_t sequence, uint64_t block, uint32_t count, uint32_t bits) {
+    return state && state->sequence == sequence && state->block == block && state->count == count
+        && state->bits == bits;
+}
+
+}
+
+TEST(ResetHeaderHasEmptyState) {
+    // Whatever was in the file before
+    std::vector<char> memory(sizeof(HistoryFileHeader), '\x5a');
+    auto* header = reinterpret_cast<HistoryFileHeader*>(memory.data());
+    CHECK(!header->matches(100));
+    CHECK(header->committed() == nullptr);
+
+    header->reset(100);
+    CHECK(header->matches(100));
+    CHECK(isState(header->committed(), 0, 0, 0, 0));
+}
+
+TEST(StaleHeaderIsNotMatched) {
+    HistoryFileHeader header;
+    header.reset(100);
+    // A file created for another number of blocks
+    CHECK(!header.matches(99));
+    CHECK(!header.matches(101));
+
+    HistoryFileHeader other = header;
+    other.version++;
+    CHECK(!other.matches(100));
+    other = header;
+    other.blockSize /= 2;
+    CHECK(!other.matches(100));
+    other = header;
+    other.magic[0] = 'X';
+    CHECK(!other.matches(100));
+}
+
+TEST(NewestIntactStateIsCommitted) {
+    HistoryFileHeader header;
+    header.reset(10);
+    for (uint64_t sequence = 1; sequence <= 5; sequence++) {
+        auto count = static_cast<uint32_t>(sequence * 10);
+        header.commit(sequence, sequence / 2, count, count * 10);
+        CHECK(isState(header.committed(), sequence, sequence / 2, count, count * 10));
+    }
+    // The copies alternate, the older one is the previous state
+    CHECK(isState(&header.states[0], 4, 2, 40, 400));
+    CHECK(isState(&header.states[1], 5, 2, 50, 500));
+
+    // The newest copy damaged: the previous state, whichever slot it is in
+    HistoryFileHeader damaged = header;
+    damaged.states[1].count++;
+    CHECK(isState(damaged.committed(), 4, 2, 40, 400));
+    header.commit(6, 3, 60, 600);
+    damaged = header;
+    damaged.states[0].checksum ^= 1;
+    CHECK(isState(damaged.committed(), 5, 2, 50, 500));
+
+    // Both damaged, nothing can be trusted
+    damaged.states[1].block++;
+    CHECK(damaged.committed() == nullptr);
+}
+
+TEST(TornCommitFallsBackToPreviousState) {
+    HistoryFileHeader before;
+    before.reset(10);
+    before.commit(1, 0, 100, 2000);
+    before.commit(2, 0, 101, 2020);
+    HistoryFileHeader after = before;
+    after.commit(3, 1, 1, 100);
+
+    // The copy being written stopped after any number of bytes, the rest of it as before
+    const size_t offset = offsetof(HistoryFileHeader, states) + sizeof(HistoryCommitState);
+    bool ok = true;
+    for (size_t written = 0; written < sizeof(HistoryCommitState); written++) {
+        HistoryFileHeader torn = before;
+        std::memcpy(reinterpret_cast<char*>(&torn) + offset, reinterpret_cast<const char*>(&after) + offset, written);
+        // Either the state before the commit, or the new one when only equal bytes were left to write
+        const HistoryCommitState* state = torn.committed();
+        ok = ok && (isState(state, 2, 0, 101, 2020) || isState(state, 3, 1, 1, 100));
+    }
+    CHECK(ok);
+    CHECK(isState(after.committed(), 3, 1, 1, 100));
+
+    // A copy which was never written (zeros) loses to any intact one
+    HistoryFileHeader header = before;
+    std::memset(&header.states[1], 0, sizeof(HistoryCommitState));
+    CHECK(isState(header.committed(), 2, 0, 101, 2020));
+}
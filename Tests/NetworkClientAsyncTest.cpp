@@ -0,0 +1,198 @@
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Core/Network/CurlMultiReactor.h"
+#include "Core/Network/NetworkClient.h"
+#include "MockRouter.h"
+#include "TestUtils.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Answers "/slow" after 10 seconds, anything else after delay, and records the requests
+class Server {
+public:
+    explicit Server(std::chrono::milliseconds delay = std::chrono::milliseconds(0)) :
+        router_([this, delay](const MockRequest& request) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                requests_.push_back(request.method + " " + request.path + " " + request.body);
+            }
+            MockResponse response;
+            response.delay = request.path == "/slow" ? std::chrono::milliseconds(10000) : delay;
+            response.body = "ok " + request.path;
+            return response;
+        }) {
+    }
+
+    std::string url(const std::string& path) const {
+        return router_.url() + path;
+    }
+
+    std::vector<std::string> requests() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return requests_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::string> requests_;
+    MockRouter router_;
+};
+
+}
+
+TEST(FuturesRunConcurrently) {
+    Server server(std::chrono::milliseconds(200));
+    CurlMultiReactor reactor;
+    reactor.start();
+
+    std::vector<std::unique_ptr<NetworkClient>> clients;
+    std::vector<std::future<bool>> results;
+    auto start = Clock::now();
+    for (int i = 0; i < 10; i++) {
+        clients.push_back(std::make_unique<NetworkClient>());
+        clients.back()->setReactor(&reactor);
+        results.push_back(clients.back()->doGetAsync(server.url("/" + std::to_string(i))));
+    }
+    for (size_t i = 0; i < results.size(); i++) {
+        CHECK(results[i].get());
+        CHECK(clients[i]->responseCode() == 200);
+        CHECK(clients[i]->responseBodyView() == "ok /" + std::to_string(i));
+        CHECK(!clients[i]->asyncRequestInProgress());
+    }
+    // Ten sequential requests would take two seconds
+    CHECK(Clock::now() - start < std::chrono::milliseconds(1000));
+}
+
+TEST(CallbacksChainRequests) {
+    Server server;
+    CurlMultiReactor reactor;
+    reactor.start();
+    NetworkClient client;
+    client.setReactor(&reactor);
+    auto request = std::make_shared<const NetworkClient::PreparedRequest>(server.url("/rci/show/interface/rrd"),
+        "POST", std::vector<std::pair<std::string, std::string>>{ { "Content-Type", "application/json" } }, "[]");
+
+    // Authentication, then the same prepared request twice, each started from the previous callback
+    std::promise<std::vector<std::string>> done;
+    std::vector<std::string> bodies;
+    bool onReactorThread = true;
+    client.prepareGet(server.url("/auth"));
+    client.performAsync([&](bool success) {
+        onReactorThread = onReactorThread && reactor.isReactorThread();
+        bodies.push_back(success ? client.responseBody() : "failed");
+        client.setUrl(server.url("/auth"));
+        client.preparePost("{\"login\":\"admin\"}");
+        client.performAsync([&](bool success) {
+            onReactorThread = onReactorThread && reactor.isReactorThread();
+            bodies.push_back(success ? client.responseBody() : "failed");
+            client.prepareRequest(request);
+            client.performAsync([&](bool success) {
+                onReactorThread = onReactorThread && reactor.isReactorThread();
+                bodies.push_back(success ? client.responseBody() : "failed");
+                client.prepareRequest(request);
+                client.performAsync([&](bool success) {
+                    onReactorThread = onReactorThread && reactor.isReactorThread();
+                    bodies.push_back(success ? client.responseBody() : "failed");
+                    done.set_value(bodies);
+                });
+            });
+        });
+    });
+    std::future<std::vector<std::string>> result = done.get_future();
+    CHECK(result.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    CHECK((result.get() == std::vector<std::string>{ "ok /auth", "ok /auth", "ok /rci/show/interface/rrd",
+        "ok /rci/show/interface/rrd" }));
+    CHECK(onReactorThread);
+    CHECK((server.requests() == std::vector<std::string>{ "GET /auth ", "POST /auth {\"login\":\"admin\"}",
+        "POST /rci/show/interface/rrd []", "POST /rci/show/interface/rrd []" }));
+}
+
+TEST(CancelledRequestsReportNothing) {
+    Server server;
+    CurlMultiReactor reactor;
+    reactor.start();
+    NetworkClient client;
+    client.setReactor(&reactor);
+
+    bool called = false;
+    client.prepareGet(server.url("/slow"));
+    client.performAsync([&](bool) { called = true; });
+    CHECK(client.asyncRequestInProgress());
+    auto start = Clock::now();
+    reactor.invoke([&] { client.cancelAsync(); });
+    CHECK(!client.asyncRequestInProgress());
+
+    // A future receives AbortedException
+    std::future<bool> result = client.doGetAsync(server.url("/slow"));
+    reactor.invoke([&] { client.cancelAsync(); });
+    CHECK(result.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    bool aborted = false;
+    try {
+        result.get();
+    } catch (const NetworkClient::AbortedException&) {
+        aborted = true;
+    }
+    CHECK(aborted);
+    CHECK(Clock::now() - start < std::chrono::milliseconds(1000));
+
+    // The client is usable after cancellation, the cancelled callback is never called
+    CHECK(client.doGetAsync(server.url("/next")).get());
+    CHECK(client.responseBodyView() == "ok /next");
+    reactor.invoke([] {});
+    CHECK(!called);
+    // Cancelling without a request in flight does nothing
+    reactor.invoke([&] { client.cancelAsync(); });
+}
+
+TEST(BlockingCallsArePerformedOnReactor) {
+    Server server;
+    CurlMultiReactor reactor;
+    reactor.start();
+    NetworkClient client;
+    client.setReactor(&reactor);
+
+    // The reactor is busy, so the blocking request waits for it
+    auto start = Clock::now();
+    reactor.post([] { std::this_thread::sleep_for(std::chrono::milliseconds(200)); });
+    CHECK(client.doGet(server.url("/blocking")));
+    CHECK(Clock::now() - start >= std::chrono::milliseconds(200));
+    CHECK(client.responseBodyView() == "ok /blocking");
+
+    // On the reactor thread the request is performed directly
+    bool success = false;
+    reactor.invoke([&] { success = client.doPost("data"); });
+    CHECK(success);
+    CHECK(client.responseBodyView() == "ok /blocking");
+    CHECK(server.requests().back() == "POST /blocking data");
+}
+
+TEST(RequestsFailWithoutRunningReactor) {
+    Server server;
+    NetworkClient client;
+    // Asynchronous requests need a reactor
+    CHECK(!client.doGetAsync(server.url("/")).get());
+
+    CurlMultiReactor reactor;
+    reactor.start();
+    reactor.stop();
+    client.setReactor(&reactor);
+    bool reported = false;
+    bool result = true;
+    client.prepareGet(server.url("/"));
+    client.performAsync([&](bool success) {
+        reported = true;
+        result = success;
+    });
+    CHECK(reported);
+    CHECK(!result);
+    CHECK(!client.doGet(server.url("/")));
+    CHECK(server.requests().empty());
+}
@@ -0,0 +1,115 @@
+#include <chrono>
+
+#include "Plugin/PollScheduler.h"
+#include "TestUtils.h"
+
+namespace {
+
+using Clock = PollScheduler::Clock;
+using std::chrono::milliseconds;
+
+constexpr milliseconds kPeriod(1000);
+
+// Time of the simulated poll loop, the scheduler only sees the times it is given
+struct FakeClock {
+    Clock::time_point now = Clock::now();
+
+    void advance(Clock::duration duration) {
+        now += duration;
+    }
+};
+
+// Fires the next poll when it is due and lets the request take latency
+Clock::time_point poll(PollScheduler& scheduler, FakeClock& clock, Clock::duration latency,
+    Clock::time_point lastFrame = Clock::time_point()) {
+    Clock::time_point deadline = scheduler.nextDeadline(clock.now, lastFrame);
+    clock.now = deadline + milliseconds(2);
+    scheduler.onFired(clock.now);
+    Clock::time_point started = clock.now;
+    clock.advance(latency);
+    scheduler.onCompleted(started, clock.now);
+    return deadline;
+}
+
+// Distance from the deadline to the next frame, frames come every period from the first one
+Clock::duration leadBeforeFrame(Clock::time_point deadline, Clock::time_point firstFrame) {
+    Clock::duration lead = (firstFrame - deadline) % kPeriod;
+    return lead < Clock::duration::zero() ? lead + kPeriod : lead;
+}
+
+}
+
+TEST(SlowRequestsDoNotDelayTheGrid) {
+    FakeClock clock;
+    Clock::time_point start = clock.now;
+    PollScheduler scheduler(kPeriod);
+    // The grid is anchored when the scheduler is created
+    Clock::time_point first = poll(scheduler, clock, milliseconds(300));
+    CHECK(first >= start);
+    CHECK(first <= start + kPeriod);
+    for (int k = 1; k <= 1000; k++) {
+        // A request taking most of the period, polls are still exactly a period apart
+        Clock::time_point deadline = poll(scheduler, clock, milliseconds(k % 2 ? 900 : 300));
+        CHECK(deadline == first + k * kPeriod);
+    }
+    PollScheduler::Stats stats = scheduler.stats();
+    CHECK(stats.polls == 1001);
+    CHECK(stats.missedDeadlines == 0);
+    CHECK_NEAR(stats.meanJitterMs, 2.0, 1e-6);
+    CHECK_NEAR(stats.maxJitterMs, 2.0, 1e-6);
+
+    scheduler.resetStats();
+    CHECK(scheduler.stats().polls == 0);
+    CHECK(scheduler.period() == kPeriod);
+}
+
+TEST(PhaseConvergesBeforeFrames) {
+    FakeClock clock;
+    PollScheduler scheduler(kPeriod);
+    scheduler.setPhaseAlignment(true);
+    // Frames at an arbitrary phase of the grid, the requests take 100 ms
+    Clock::time_point firstFrame = clock.now + milliseconds(370);
+    Clock::time_point previous;
+    for (int k = 0; k < 40; k++) {
+        Clock::time_point lastFrame = firstFrame + ((clock.now - firstFrame) / kPeriod) * kPeriod;
+        Clock::time_point deadline = poll(scheduler, clock, milliseconds(100), lastFrame < clock.now ? lastFrame
+            : Clock::time_point());
+        if (k) {
+            // Shifting the phase never makes two polls within one period
+            CHECK(deadline - previous >= kPeriod / 2);
+        }
+        previous = deadline;
+    }
+    // The response is expected the 30 ms guard before the frame
+    CHECK(std::chrono::abs(leadBeforeFrame(previous, firstFrame) - milliseconds(130)) <= milliseconds(1));
+    CHECK(scheduler.stats().missedDeadlines == 0);
+}
+
+TEST(LeadIsLimitedToHalfThePeriod) {
+    FakeClock clock;
+    PollScheduler scheduler(kPeriod);
+    scheduler.setPhaseAlignment(true);
+    Clock::time_point firstFrame = clock.now + milliseconds(100);
+    Clock::time_point deadline;
+    for (int k = 0; k < 40; k++) {
+        Clock::time_point lastFrame = firstFrame + ((clock.now - firstFrame) / kPeriod) * kPeriod;
+        deadline = poll(scheduler, clock, milliseconds(800), lastFrame < clock.now ? lastFrame : Clock::time_point());
+    }
+    CHECK(std::chrono::abs(leadBeforeFrame(deadline, firstFrame) - kPeriod / 2) <= milliseconds(1));
+}
+
+TEST(SkippedTicksAreMissedDeadlines) {
+    FakeClock clock;
+    PollScheduler scheduler(kPeriod);
+    Clock::time_point first = poll(scheduler, clock, milliseconds(100));
+    // The request took two and a half periods, the ticks it overlapped are skipped
+    clock.now = first + milliseconds(2500);
+    Clock::time_point deadline = scheduler.nextDeadline(clock.now, Clock::time_point());
+    CHECK(deadline == first + 3 * kPeriod);
+    CHECK(scheduler.stats().missedDeadlines == 2);
+
+    clock.now = deadline;
+    scheduler.onFired(clock.now);
+    CHECK(scheduler.nextDeadline(clock.now, Clock::time_point()) == first + 4 * kPeriod);
+    CHECK(scheduler.stats().missedDeadlines == 2);
+}
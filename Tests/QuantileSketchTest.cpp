@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "Plugin/QuantileSketch.h"
+#include "TestUtils.h"
+
+namespace {
+
+constexpr double kQuantiles[] = { 0.0, 0.01, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.999, 1.0 };
+
+// Same rank as the sketch: the element at q * (n - 1) of the sorted values
+double exactQuantile(std::vector<double> values, double q) {
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(q * (values.size() - 1))];
+}
+
+// Positive values are returned within the relative accuracy, zeros and negative ones as zero
+bool withinAccuracy(double estimate, double exact) {
+    if (exact <= 0.0) {
+        return estimate == 0.0;
+    }
+    return std::fabs(estimate - exact) <= QuantileSketch::kRelativeAccuracy * exact * (1 + 1e-9);
+}
+
+bool checkSketch(const std::vector<double>& values, const char* name) {
+    QuantileSketch sketch;
+    for (double value : values) {
+        sketch.add(value);
+    }
+    bool ok = sketch.count() == values.size();
+    for (double q : kQuantiles) {
+        double exact = exactQuantile(values, q);
+        double estimate = sketch.quantile(q);
+        if (!withinAccuracy(estimate, exact)) {
+            printf("%s: q %g estimate %g exact %g\n", name, q, estimate, exact);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+std::vector<double> generate(size_t count, const std::function<double(std::mt19937_64&)>& next) {
+    std::mt19937_64 random(42);
+    std::vector<double> values;
+    for (size_t i = 0; i < count; i++) {
+        values.push_back(next(random));
+    }
+    return values;
+}
+
+}
+
+TEST(QuantilesAreWithinRelativeAccuracy) {
+    std::uniform_real_distribution<double> uniform(1.0, 1e8);
+    std::exponential_distribution<double> exponential(1e-6);
+    std::lognormal_distribution<double> lognormal(10.0, 2.0);
+    CHECK(checkSketch(generate(50000, [&](std::mt19937_64& r) { return uniform(r); }), "uniform"));
+    CHECK(checkSketch(generate(50000, [&](std::mt19937_64& r) { return exponential(r); }), "exponential"));
+    CHECK(checkSketch(generate(50000, [&](std::mt19937_64& r) { return lognormal(r); }), "lognormal"));
+    // An idle link with downloads now and then, many exact zeros
+    CHECK(checkSketch(generate(50000, [&](std::mt19937_64& r) {
+        uint64_t n = r() % 100;
+        return n < 30 ? 0.0 : n < 90 ? static_cast<double>(r() % 2000) : 5e7 + static_cast<double>(r() % 50000000);
+    }), "bimodal"));
+    CHECK(checkSketch(std::vector<double>(1000, 123456.0), "constant"));
+    CHECK(checkSketch({ 1.0, 1e3, 1e8 }, "sparse"));
+}
+
+TEST(EmptyZeroAndNegativeValues) {
+    QuantileSketch sketch;
+    CHECK(sketch.quantile(0.5) == 0.0);
+    sketch.add(0.0);
+    sketch.add(-5.0);
+    sketch.add(std::nan(""));
+    CHECK(sketch.count() == 3);
+    CHECK(sketch.zeros() == 3);
+    CHECK(sketch.quantile(1.0) == 0.0);
+    sketch.add(1000.0);
+    CHECK(sketch.quantile(0.5) == 0.0);
+    CHECK(withinAccuracy(sketch.quantile(1.0), 1000.0));
+    // Out of range quantiles are clamped
+    CHECK(withinAccuracy(sketch.quantile(7.0), 1000.0));
+    CHECK(sketch.quantile(-1.0) == 0.0);
+
+    sketch.clear();
+    CHECK(sketch.count() == 0);
+    CHECK(sketch.quantile(1.0) == 0.0);
+}
+
+TEST(WideRangesKeepHighQuantiles) {
+    // Values spanning 30 decades, more than the bins cover, the lowest ones are merged
+    std::vector<double> values;
+    for (int i = 0; i < 30000; i++) {
+        values.push_back(std::pow(10.0, -10.0 + i / 1000.0));
+    }
+    std::shuffle(values.begin(), values.end(), std::mt19937_64(1));
+    QuantileSketch sketch;
+    for (double value : values) {
+        sketch.add(value);
+    }
+    for (double q : { 0.75, 0.9, 0.99, 1.0 }) {
+        CHECK(withinAccuracy(sketch.quantile(q), exactQuantile(values, q)));
+    }
+    // Values below 1e-9 count as zeros, the merged ones are reported at the lowest bin kept
+    CHECK(sketch.quantile(0.0) == 0.0);
+    CHECK(sketch.quantile(0.05) > 1e10);
+    CHECK(sketch.quantile(0.05) < exactQuantile(values, 0.75));
+}
+
+TEST(SaturatedBinsKeepTheirValue) {
+    QuantileSketch sketch;
+    for (int i = 0; i < 200000; i++) {
+        sketch.add(i % 4 ? 1e6 : 10.0);
+    }
+    CHECK(sketch.count() == 200000);
+    CHECK(withinAccuracy(sketch.quantile(0.1), 10.0));
+    CHECK(withinAccuracy(sketch.quantile(0.5), 1e6));
+    CHECK(withinAccuracy(sketch.quantile(1.0), 1e6));
+}
+
+TEST(MergeMatchesOneSketchOfBothStreams) {
+    std::lognormal_distribution<double> busy(14.0, 1.5);
+    std::exponential_distribution<double> idle(1e-3);
+    std::vector<double> first = generate(30000, [&](std::mt19937_64& r) { return r() % 5 ? busy(r) : 0.0; });
+    std::vector<double> second = generate(20000, [&](std::mt19937_64& r) { return idle(r); });
+    QuantileSketch a;
+    QuantileSketch b;
+    QuantileSketch both;
+    for (double value : first) {
+        a.add(value);
+        both.add(value);
+    }
+    for (double value : second) {
+        b.add(value);
+        both.add(value);
+    }
+    std::vector<double> all = first;
+    all.insert(all.end(), second.begin(), second.end());
+
+    MergedQuantiles merged;
+    merged.merge(a);
+    merged.merge(QuantileSketch());
+    merged.merge(b);
+    CHECK(merged.count() == both.count());
+    for (double q : kQuantiles) {
+        CHECK(merged.quantile(q) == both.quantile(q));
+        CHECK(withinAccuracy(merged.quantile(q), exactQuantile(all, q)));
+    }
+
+    // The order does not matter, a lower range extends the bins downwards
+    MergedQuantiles reversed;
+    reversed.merge(b);
+    reversed.merge(a);
+    for (double q : kQuantiles) {
+        CHECK(reversed.quantile(q) == merged.quantile(q));
+    }
+
+    merged.clear();
+    CHECK(merged.count() == 0);
+    CHECK(merged.quantile(0.5) == 0.0);
+}
+
+TEST(MergedBinsDoNotSaturate) {
+    QuantileSketch a;
+    for (int i = 0; i < 90000; i++) {
+        a.add(i < 50000 ? 10.0 : 1e6);
+    }
+    MergedQuantiles merged;
+    merged.merge(a);
+    merged.merge(a);
+    // 100000 values of 10 and 80000 of 1e6, the bins of a single sketch would hold 65535 of each
+    CHECK(merged.count() == 180000);
+    CHECK(withinAccuracy(merged.quantile(0.5), 10.0));
+    CHECK(withinAccuracy(merged.quantile(0.6), 1e6));
+}
+
+TEST(SlidingWindowsUseTheFinestTier) {
+    // An hour in minute panes and a day in 10 minute panes, as the history keeps them
+    SlidingQuantiles quantiles({ { 60, 60 }, { 600, 144 } });
+    std::vector<double> lastHour;
+    std::vector<double> lastDay;
+    const int64_t end = 2 * 24 * 3600;
+    std::mt19937_64 random(3);
+    for (int64_t time = 0; time < end; time++) {
+        // The last ten minutes are busy
+        double value = time >= end - 600 ? 1e7 + static_cast<double>(random() % 1000000)
+                                         : 1000.0 + static_cast<double>(random() % 100000);
+        quantiles.add(time, value);
+        if (time >= end - 3600) {
+            lastHour.push_back(value);
+        }
+        if (time >= end - 24 * 3600) {
+            lastDay.push_back(value);
+        }
+    }
+    int64_t now = end - 1;
+    std::vector<double> lastTen(lastHour.end() - 600, lastHour.end());
+    for (double q : { 0.5, 0.9, 0.99 }) {
+        // Windows which are whole panes are exact up to the sketch accuracy
+        CHECK(withinAccuracy(quantiles.quantile(now, 600, q), exactQuantile(lastTen, q)));
+        CHECK(withinAccuracy(quantiles.quantile(now, 3600, q), exactQuantile(lastHour, q)));
+        CHECK(withinAccuracy(quantiles.quantile(now, 24 * 3600, q), exactQuantile(lastDay, q)));
+    }
+    CHECK(quantiles.quantile(now, 600, 0.01) > 1e7 * (1 - QuantileSketch::kRelativeAccuracy));
+    CHECK(quantiles.quantile(now, 3600, 0.5) < 1e6);
+}
+
+TEST(SlidingWindowsForgetOldPanes) {
+    SlidingQuantiles quantiles({ { 60, 10 } });
+    for (int64_t time = 0; time < 600; time++) {
+        quantiles.add(time, 5000.0);
+    }
+    // Nothing was added for longer than the ring covers
+    CHECK(quantiles.quantile(100000, 600, 0.5) == 0.0);
+    quantiles.add(100000, 7.0);
+    CHECK(withinAccuracy(quantiles.quantile(100000, 600, 1.0), 7.0));
+
+    quantiles.clear();
+    CHECK(quantiles.quantile(100000, 600, 1.0) == 0.0);
+    CHECK(quantiles.memoryUsage() >= 10 * sizeof(QuantileSketch));
+}
@@ -0,0 +1,161 @@
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "AllocCounter.h"
+#include "Core/Network/BodySink.h"
+#include "Core/Network/NetworkClient.h"
+#include "MockRouter.h"
+#include "TestUtils.h"
+
+namespace {
+
+constexpr size_t kLarge = 2 * 1024 * 1024;
+// More than the receive buffer keeps for the following responses
+constexpr size_t kHuge = 5 * 1024 * 1024;
+
+std::string makeBody(size_t size) {
+    std::string body(size, ' ');
+    for (size_t i = 0; i < size; i++) {
+        body[i] = static_cast<char>('a' + i % 26);
+    }
+    return body;
+}
+
+// Serves "/<size>" with a body of that size, as large custom command responses
+class BodyServer {
+public:
+    BodyServer() : router_([this](const MockRequest& request) {
+        MockResponse response;
+        auto it = bodies_.find(request.path);
+        if (it == bodies_.end()) {
+            response.status = 404;
+        } else {
+            response.body = it->second;
+        }
+        return response;
+    }) {
+    }
+
+    std::string url(size_t size) {
+        return router_.url() + path(size);
+    }
+
+    const std::string& body(size_t size) {
+        return bodies_.at(path(size));
+    }
+
+private:
+    static std::string path(size_t size) {
+        return "/" + std::to_string(size);
+    }
+
+    // Written before the router is started, only read by its threads
+    std::map<std::string, std::string> bodies_{
+        { path(100), makeBody(100) }, { path(kLarge), makeBody(kLarge) }, { path(kHuge), makeBody(kHuge) } };
+    MockRouter router_;
+};
+
+struct Received {
+    bool success;
+    // Allocated by the client thread, curl itself allocates with malloc and is not counted
+    uint64_t bytes;
+};
+
+Received get(NetworkClient& client, const std::string& url) {
+    uint64_t before = AllocCounter::threadAllocatedBytes();
+    bool success = client.doGet(url);
+    return { success, AllocCounter::threadAllocatedBytes() - before };
+}
+
+}
+
+TEST(BodyIsReceivedIntoOneReservedBuffer) {
+    BodyServer server;
+    NetworkClient client;
+    Received received = get(client, server.url(kLarge));
+    CHECK(received.success);
+    CHECK(client.responseBodyView() == server.body(kLarge));
+    // Reserved from Content-Length: growing the buffer by doubling would allocate about twice the body
+    CHECK(received.bytes >= kLarge);
+    CHECK(received.bytes < kLarge + kLarge / 4);
+}
+
+TEST(BufferIsReusedByFollowingResponses) {
+    BodyServer server;
+    NetworkClient client;
+    CHECK(get(client, server.url(kLarge)).success);
+    const char* data = client.responseBodyView().data();
+    for (int i = 0; i < 5; i++) {
+        Received received = get(client, server.url(i % 2 ? 100 : kLarge));
+        CHECK(received.success);
+        CHECK(received.bytes < 64 * 1024);
+        CHECK(client.responseBodyView().data() == data);
+    }
+    CHECK(client.responseBodyView() == server.body(kLarge));
+    // A copy is still available
+    CHECK(client.responseBody() == server.body(kLarge));
+}
+
+TEST(TakenBodyIsNotReused) {
+    BodyServer server;
+    NetworkClient client;
+    CHECK(get(client, server.url(kLarge)).success);
+    uint64_t before = AllocCounter::threadAllocatedBytes();
+    std::string body = client.takeResponseBody();
+    CHECK(AllocCounter::threadAllocatedBytes() == before);
+    CHECK(body == server.body(kLarge));
+    CHECK(client.responseBodyView().empty());
+
+    // The next response gets a new buffer, the taken body is left untouched
+    Received received = get(client, server.url(kLarge));
+    CHECK(received.success);
+    CHECK(received.bytes >= kLarge);
+    CHECK(client.responseBodyView().data() != body.data());
+    CHECK(body == server.body(kLarge));
+}
+
+TEST(HugeBuffersAreReleased) {
+    BodyServer server;
+    NetworkClient client;
+    CHECK(get(client, server.url(kHuge)).success);
+    CHECK(client.responseBodyView() == server.body(kHuge));
+    Received received = get(client, server.url(kHuge));
+    CHECK(received.success);
+    CHECK(received.bytes >= kHuge);
+    CHECK(client.responseBodyView() == server.body(kHuge));
+
+    // The small response does not keep the huge buffer
+    CHECK(get(client, server.url(100)).success);
+    CHECK(client.responseBodyView() == server.body(100));
+    received = get(client, server.url(kLarge));
+    CHECK(received.bytes >= kLarge);
+    CHECK(received.bytes < kLarge + kLarge / 4);
+}
+
+TEST(MemoryBodySinkReservesAnnouncedLength) {
+    MemoryBodySink sink;
+    CHECK(sink.begin(-1));
+    CHECK(sink.write("abc", 3));
+    sink.end();
+    CHECK(sink.data() == "abc");
+
+    sink.clear();
+    CHECK(sink.data().empty());
+    CHECK(sink.begin(100000));
+    CHECK(sink.data().capacity() >= 100000);
+    std::string chunk(1000, 'x');
+    uint64_t before = AllocCounter::threadAllocations();
+    for (int i = 0; i < 100; i++) {
+        sink.write(chunk.data(), chunk.size());
+    }
+    CHECK(AllocCounter::threadAllocations() == before);
+    CHECK(sink.data().size() == 100000);
+
+    // Kept for the next response, unless larger than 4 MB
+    sink.clear();
+    CHECK(sink.data().capacity() >= 100000);
+    CHECK(sink.begin(static_cast<int64_t>(kHuge)));
+    sink.clear();
+    CHECK(sink.data().capacity() < kHuge);
+}
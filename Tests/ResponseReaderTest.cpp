@@ -0,0 +1,172 @@
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Plugin/ResponseReader.h"
+#include "RouterResponses.h"
+#include "TestUtils.h"
+
+// Every parser must read the same values as jsoncpp, whichever one is selected by the Parser option
+
+namespace {
+
+std::vector<std::pair<const char*, std::unique_ptr<ResponseReader>>> readersUnderTest() {
+    std::vector<std::pair<const char*, std::unique_ptr<ResponseReader>>> readers;
+    readers.emplace_back("default", ResponseReader::create(ResponseParser::Default));
+#ifdef KEENETIC_WITH_SIMDJSON
+    readers.emplace_back("simdjson", ResponseReader::create(ResponseParser::SimdJson));
+#endif
+    return readers;
+}
+
+bool sameSeries(const RrdSeries& a, const RrdSeries& b) {
+    if (a.value != b.value || a.time != b.time || a.hasValue != b.hasValue || a.failed != b.failed
+        || a.message != b.message || a.samples.size() != b.samples.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.samples.size(); i++) {
+        if (a.samples[i].time != b.samples[i].time || a.samples[i].value != b.samples[i].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sameCounters(const InterfaceCounters& a, const InterfaceCounters& b) {
+    return a.rxBytes == b.rxBytes && a.txBytes == b.txBytes && a.hasValue == b.hasValue && a.failed == b.failed
+        && a.message == b.message;
+}
+
+void checkRrd(const std::string& body, bool withSamples) {
+    std::vector<RrdSeries> expected;
+    CHECK(ResponseReader::create(ResponseParser::JsonCpp)->readRrd(body, expected, withSamples));
+    for (auto& reader : readersUnderTest()) {
+        // Series left from a larger response must not leak into the result
+        std::vector<RrdSeries> actual(expected.size() + 3);
+        actual.back().message = "stale";
+        bool ok = reader.second->readRrd(body, actual, withSamples);
+        if (!ok) {
+            printf("%s: %s\n", reader.first, reader.second->error().c_str());
+        }
+        CHECK(ok);
+        CHECK(actual.size() == expected.size());
+        for (size_t i = 0; i < actual.size() && i < expected.size(); i++) {
+            CHECK(sameSeries(actual[i], expected[i]));
+        }
+    }
+}
+
+void checkCounters(const std::string& body) {
+    std::vector<InterfaceCounters> expected;
+    CHECK(ResponseReader::create(ResponseParser::JsonCpp)->readCounters(body, expected));
+    for (auto& reader : readersUnderTest()) {
+        std::vector<InterfaceCounters> actual(expected.size() + 2);
+        bool ok = reader.second->readCounters(body, actual);
+        if (!ok) {
+            printf("%s: %s\n", reader.first, reader.second->error().c_str());
+        }
+        CHECK(ok);
+        CHECK(actual.size() == expected.size());
+        for (size_t i = 0; i < actual.size() && i < expected.size(); i++) {
+            CHECK(sameCounters(actual[i], expected[i]));
+        }
+    }
+}
+
+std::vector<double> checkFields(const std::string& body, const std::vector<std::string>& paths) {
+    std::vector<JsonFieldPath> compiled(paths.size());
+    std::vector<const JsonFieldPath*> fields;
+    for (size_t i = 0; i < paths.size(); i++) {
+        std::string error;
+        CHECK(compiled[i].compile(paths[i], error));
+        fields.push_back(&compiled[i]);
+    }
+    std::vector<double> expected;
+    CHECK(ResponseReader::create(ResponseParser::JsonCpp)->readFields(body, fields, expected));
+    for (auto& reader : readersUnderTest()) {
+        std::vector<double> actual{ 42.0 };
+        bool ok = reader.second->readFields(body, fields, actual);
+        if (!ok) {
+            printf("%s: %s\n", reader.first, reader.second->error().c_str());
+        }
+        CHECK(ok);
+        CHECK(actual == expected);
+    }
+    return expected;
+}
+
+}
+
+TEST(RrdMatchesJsonCpp) {
+    for (size_t series : { 0, 1, 3, 64 }) {
+        for (size_t samples : { 0, 1, 60 }) {
+            checkRrd(rrdResponse(series, 1700000000, samples), false);
+            checkRrd(rrdResponse(series, 1700000000, samples), true);
+        }
+    }
+    checkRrd(R"([
+        {"status": [{"status": "error", "message": "no such interface: \"Wg\""}, {"status": "error", "message": "x"}]},
+        {"status": [{"message": "ok", "status": "message"}], "data": [{"v": 1.5, "t": 5, "extra": [1, {"v": 9}]}]},
+        {"data": [], "status": []},
+        {"data": [{"t": 7}, {"v": 2}]},
+        {"unknown": {"data": [{"t": 1, "v": 1}]}}
+    ])", true);
+}
+
+TEST(CountersMatchJsonCpp) {
+    for (size_t interfaces : { 0, 1, 16 }) {
+        checkCounters(interfaceResponse(interfaces));
+    }
+    std::vector<InterfaceCounters> counters;
+    CHECK(ResponseReader::create(ResponseParser::JsonCpp)->readCounters(interfaceResponse(3), counters));
+    CHECK(counters[2].hasValue);
+    CHECK(counters[2].rxBytes == 15000000000ULL);
+    CHECK(counters[2].txBytes == 9000000000ULL);
+
+    checkCounters(R"([
+        {"rxbytes": "18446744073709551615", "txbytes": 18446744073709551615},
+        {"rxbytes": 1, "txbytes": -1},
+        {"rxbytes": "12a", "txbytes": 1},
+        {"rxbytes": 1.5, "txbytes": 1},
+        {"rxbytes": 1},
+        {"status": [{"status": "error", "message": "not found"}]},
+        {"txbytes": 2, "rxbytes": "3", "status": [{"status": "ok"}]}
+    ])");
+}
+
+TEST(FieldsMatchJsonCpp) {
+    std::vector<std::string> paths = { ".mtu", ".stat.rxspeed", ".ports[1].speed", ".rxbytes", ".txbytes",
+        ".missing", ".traits[0]", ".traits[9]", ".summary.layer", ".ports.speed", "" };
+    for (size_t interfaces : { 0, 1, 16 }) {
+        checkFields(interfaceResponse(interfaces), paths);
+    }
+    std::vector<double> values = checkFields(interfaceResponse(4), paths);
+    CHECK(values.size() == 4 * paths.size());
+    const double* third = &values[2 * paths.size()];
+    CHECK(third[0] == 1498.0);
+    CHECK(third[1] == 2001.0);
+    CHECK(third[2] == 200.0);
+    CHECK(third[3] == 15000000000.0);
+    CHECK(third[5] == 0.0);
+
+    // Elements of a custom command need not be objects
+    checkFields(R"([1.5, "2", [3, [4]], {"a": {"b": "5e1"}}, null, true])", { "", "[0]", "[1][0]", ".a.b" });
+}
+
+TEST(MalformedResponsesAreRejectedByAll) {
+    std::vector<RrdSeries> series;
+    std::vector<InterfaceCounters> counters;
+    std::vector<double> values;
+    std::vector<const JsonFieldPath*> fields;
+    std::string full = interfaceResponse(2);
+    for (const std::string& body : { std::string("{}"), full.substr(0, full.size() / 2), full + " ]", full + "x" }) {
+        for (auto& reader : readersUnderTest()) {
+            CHECK(!reader.second->readRrd(body, series, false));
+            CHECK(!reader.second->readCounters(body, counters));
+            CHECK(!reader.second->readFields(body, fields, values));
+            CHECK(!reader.second->error().empty());
+        }
+    }
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "Plugin/RollingSeries.h"
+#include "TestUtils.h"
+
+namespace {
+
+struct Sample {
+    int64_t time;
+    double value;
+};
+
+/**
+ * Aggregates computed from scratch: the newest samples since the last clear, at most capacity of them,
+ * not older than the window at the latest time seen.
+ */
+class BruteForce {
+public:
+    BruteForce(const std::vector<int64_t>& windows, const std::vector<size_t>& capacities) :
+        windows_(windows), capacities_(capacities) {
+    }
+
+    void push(int64_t time, double value) {
+        samples_.push_back({ time, value });
+        now_ = std::max(now_, time);
+    }
+
+    void expire(int64_t now) {
+        now_ = std::max(now_, now);
+    }
+
+    void clear() {
+        samples_.clear();
+    }
+
+    RollingSeries::Aggregates aggregates(size_t window) const {
+        RollingSeries::Aggregates res;
+        size_t first = samples_.size() > capacities_[window] ? samples_.size() - capacities_[window] : 0;
+        double sum = 0.0;
+        for (size_t i = first; i < samples_.size(); i++) {
+            const Sample& sample = samples_[i];
+            if (sample.time <= now_ - windows_[window]) {
+                continue;
+            }
+            sum += sample.value;
+            res.peak = res.count ? std::max(res.peak, sample.value) : sample.value;
+            res.minimum = res.count ? std::min(res.minimum, sample.value) : sample.value;
+            res.count++;
+        }
+        res.average = res.count ? sum / res.count : 0.0;
+        return res;
+    }
+
+private:
+    std::vector<int64_t> windows_;
+    std::vector<size_t> capacities_;
+    std::vector<Sample> samples_;
+    int64_t now_ = std::numeric_limits<int64_t>::min();
+};
+
+bool sameAggregates(const RollingSeries& series, const BruteForce& expected, size_t window) {
+    RollingSeries::Aggregates actual = series.aggregates(window);
+    RollingSeries::Aggregates exact = expected.aggregates(window);
+    bool same = actual.count == exact.count && actual.peak == exact.peak && actual.minimum == exact.minimum
+        && std::fabs(actual.average - exact.average) <= 1e-9 * std::max(1.0, std::fabs(exact.average));
+    if (!same) {
+        printf("window %zu: count %zu/%zu peak %g/%g minimum %g/%g average %g/%g\n", window, actual.count, exact.count,
+            actual.peak, exact.peak, actual.minimum, exact.minimum, actual.average, exact.average);
+    }
+    return same;
+}
+
+}
+
+TEST(AggregatesMatchBruteForceWindows) {
+    // Durations and capacities as the measures use them: the capacity limits the short windows,
+    // the duration the long one
+    const std::vector<int64_t> windows = { 10, 60, 300 };
+    const std::vector<size_t> capacities = { 8, 100, 1000 };
+    RollingSeries series(windows, capacities);
+    BruteForce expected(windows, capacities);
+    size_t memory = series.memoryUsage();
+
+    std::mt19937_64 random(5);
+    int64_t time = 0;
+    bool ok = true;
+    // Many times the ring size, so positions wrap around the ring and the queues
+    for (int i = 0; i < 20000 && ok; i++) {
+        uint64_t action = random() % 1000;
+        if (action < 5) {
+            // A gap longer than some of the windows, or all of them
+            time += static_cast<int64_t>(random() % 500);
+            series.expire(time);
+            expected.expire(time);
+        } else if (action < 6) {
+            series.clear();
+            expected.clear();
+        } else {
+            time += static_cast<int64_t>(random() % 4);
+            // Few distinct values, so that equal ones meet in the queues
+            double value = static_cast<double>(random() % 20) * 0.5 - 2.0;
+            series.push(time, value);
+            expected.push(time, value);
+            CHECK(series.lastTime() == time);
+        }
+        for (size_t window = 0; window < windows.size(); window++) {
+            ok = ok && sameAggregates(series, expected, window);
+        }
+    }
+    CHECK(ok);
+    CHECK(series.windowCount() == 3);
+    CHECK(series.memoryUsage() == memory);
+}
+
+TEST(SamplesExpireAcrossGaps) {
+    RollingSeries series({ 10, 100 }, { 100, 100 });
+    for (int64_t time = 0; time < 50; time++) {
+        series.push(time, static_cast<double>(time));
+    }
+    CHECK(series.aggregates(0).count == 10);
+    CHECK(series.aggregates(0).minimum == 40.0);
+    CHECK(series.aggregates(1).count == 50);
+    CHECK(series.aggregates(1).average == 24.5);
+
+    // Nothing arrived for a while, the short window is empty, the long one keeps the newest samples
+    series.expire(120);
+    CHECK(series.aggregates(0).count == 0);
+    CHECK(series.aggregates(0).peak == 0.0);
+    CHECK(series.aggregates(0).average == 0.0);
+    CHECK(series.aggregates(1).count == 29);
+    CHECK(series.aggregates(1).minimum == 21.0);
+    CHECK(series.aggregates(1).peak == 49.0);
+
+    // The first sample after a gap longer than every window is alone in all of them
+    series.push(1000, -5.0);
+    for (size_t window : { 0, 1 }) {
+        RollingSeries::Aggregates aggregates = series.aggregates(window);
+        CHECK(aggregates.count == 1);
+        CHECK(aggregates.average == -5.0);
+        CHECK(aggregates.peak == -5.0);
+        CHECK(aggregates.minimum == -5.0);
+    }
+}
+
+TEST(ClearForgetsSamples) {
+    RollingSeries series({ 60 }, { 60 });
+    CHECK(series.lastTime() == std::numeric_limits<int64_t>::min());
+    series.push(1, 3.0);
+    series.push(2, 7.0);
+    series.clear();
+    CHECK(series.lastTime() == std::numeric_limits<int64_t>::min());
+    CHECK(series.aggregates(0).count == 0);
+    series.push(3, 1.0);
+    CHECK(series.aggregates(0).count == 1);
+    CHECK(series.aggregates(0).peak == 1.0);
+    // Windows which do not exist are empty
+    CHECK(series.aggregates(1).count == 0);
+}
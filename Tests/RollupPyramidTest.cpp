@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Plugin/RollupPyramid.h"
+#include "TestUtils.h"
+
+namespace {
+
+// 1 s, 10 s and 1 min buckets, for 1 min, 10 min and 1 hour
+const std::vector<RollupPyramid::Level> kLevels = { { 1, 60 }, { 10, 60 }, { 60, 60 } };
+
+// Bucket start below or at time, a multiple of the duration
+int64_t alignDown(int64_t time, int64_t duration) {
+    int64_t start = time / duration * duration;
+    return start > time ? start - duration : start;
+}
+
+/**
+ * Buckets of one level computed from all the samples, only the newest ones kept.
+ */
+std::vector<RollupBucket> bruteForce(const std::vector<std::pair<int64_t, double>>& samples,
+    const RollupPyramid::Level& level) {
+    std::map<int64_t, RollupBucket> all;
+    for (const auto& [time, value] : samples) {
+        int64_t start = alignDown(time, level.duration);
+        auto v = static_cast<float>(value);
+        auto [it, inserted] = all.try_emplace(start);
+        RollupBucket& bucket = it->second;
+        if (inserted) {
+            bucket.start = start;
+            bucket.minimum = bucket.maximum = v;
+        }
+        bucket.count++;
+        bucket.minimum = std::min(bucket.minimum, v);
+        bucket.maximum = std::max(bucket.maximum, v);
+        bucket.sum += value;
+    }
+    std::vector<RollupBucket> res;
+    for (const auto& item : all) {
+        res.push_back(item.second);
+    }
+    if (res.size() > level.buckets) {
+        res.erase(res.begin(), res.end() - static_cast<ptrdiff_t>(level.buckets));
+    }
+    return res;
+}
+
+bool sameBuckets(const std::vector<RollupBucket>& actual, const std::vector<RollupBucket>& expected) {
+    if (actual.size() != expected.size()) {
+        printf("%zu buckets, expected %zu\n", actual.size(), expected.size());
+        return false;
+    }
+    for (size_t i = 0; i < actual.size(); i++) {
+        const RollupBucket& a = actual[i];
+        const RollupBucket& e = expected[i];
+        if (a.start != e.start || a.count != e.count || a.minimum != e.minimum || a.maximum != e.maximum
+            || a.sum != e.sum) {
+            printf("bucket %zu: start %lld/%lld count %u/%u\n", i, static_cast<long long>(a.start),
+                static_cast<long long>(e.start), a.count, e.count);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<RollupBucket> query(const RollupPyramid& pyramid, int64_t from, int64_t to, int64_t resolution,
+    int64_t* duration = nullptr) {
+    std::vector<RollupBucket> buckets;
+    int64_t used = pyramid.query(from, to, resolution, buckets);
+    if (duration) {
+        *duration = used;
+    }
+    return buckets;
+}
+
+}
+
+TEST(BucketsMatchBruteForce) {
+    RollupPyramid pyramid(kLevels);
+    std::vector<std::pair<int64_t, double>> samples;
+    std::mt19937_64 random(3);
+    // Negative times too, buckets are aligned by floor division
+    int64_t time = -1000;
+    bool ok = true;
+    for (int i = 0; i < 5000 && ok; i++) {
+        // Mostly several samples a second, sometimes a gap skipping buckets
+        time += random() % 100 ? static_cast<int64_t>(random() % 2) : static_cast<int64_t>(random() % 700);
+        double value = static_cast<double>(random() % 1000) / 8.0 - 20.0;
+        pyramid.add(time, value);
+        samples.emplace_back(time, value);
+        if (i % 97) {
+            continue;
+        }
+        for (const RollupPyramid::Level& level : kLevels) {
+            // The whole level, its resolution selects it and the range is within the ring
+            std::vector<RollupBucket> expected = bruteForce(samples, level);
+            int64_t duration = 0;
+            std::vector<RollupBucket> actual = query(pyramid, expected.front().start, time + 1, level.duration,
+                &duration);
+            ok = ok && duration == level.duration && sameBuckets(actual, expected);
+            for (const RollupBucket& bucket : actual) {
+                ok = ok && alignDown(bucket.start, level.duration) == bucket.start;
+            }
+        }
+    }
+    CHECK(ok);
+}
+
+TEST(ResolutionSelectsCoarsestLevelNotLonger) {
+    RollupPyramid pyramid(kLevels);
+    for (int64_t time = 0; time < 600; time++) {
+        pyramid.add(time, static_cast<double>(time));
+    }
+    int64_t duration = 0;
+    // The last 30 seconds, within every level
+    query(pyramid, 570, 600, 1, &duration);
+    CHECK(duration == 1);
+    query(pyramid, 570, 600, 9, &duration);
+    CHECK(duration == 1);
+    query(pyramid, 570, 600, 10, &duration);
+    CHECK(duration == 10);
+    query(pyramid, 570, 600, 59, &duration);
+    CHECK(duration == 10);
+    query(pyramid, 570, 600, 3600, &duration);
+    CHECK(duration == 60);
+    // Finer than every level
+    std::vector<RollupBucket> buckets = query(pyramid, 570, 600, 0, &duration);
+    CHECK(duration == 1);
+    CHECK(buckets.size() == 30);
+    CHECK(buckets.front().start == 570);
+    CHECK(buckets.back().start == 599);
+
+    // Buckets overlapping [from, to): 10 s buckets from 560 to 590
+    buckets = query(pyramid, 565, 595, 10, &duration);
+    CHECK(buckets.size() == 4);
+    CHECK(buckets.front().start == 560);
+    CHECK(buckets.back().start == 590);
+    CHECK(buckets.front().count == 10);
+    CHECK(buckets.front().minimum == 560.0f);
+    CHECK(buckets.front().maximum == 569.0f);
+    CHECK(buckets.front().average() == 564.5);
+
+    // Nothing in an empty range
+    CHECK(query(pyramid, 1000, 2000, 1).empty());
+    CHECK(query(pyramid, 300, 300, 10).empty());
+}
+
+TEST(EvictedRangeFallsBackToCoarserLevel) {
+    RollupPyramid pyramid(kLevels);
+    for (int64_t time = 0; time < 1200; time++) {
+        pyramid.add(time, 1.0);
+    }
+    int64_t duration = 0;
+    // The 1 s ring keeps the last minute, the 10 s ring the last 10 minutes
+    std::vector<RollupBucket> buckets = query(pyramid, 1140, 1200, 1, &duration);
+    CHECK(duration == 1);
+    CHECK(buckets.size() == 60);
+    buckets = query(pyramid, 1000, 1200, 1, &duration);
+    CHECK(duration == 10);
+    CHECK(buckets.size() == 20);
+    CHECK(buckets.front().start == 1000);
+    buckets = query(pyramid, 0, 1200, 1, &duration);
+    CHECK(duration == 60);
+    CHECK(buckets.size() == 20);
+    CHECK(buckets.front().start == 0);
+    // Older than every level, the coarsest one returns what it has
+    buckets = query(pyramid, -100000, 1200, 1, &duration);
+    CHECK(duration == 60);
+    CHECK(buckets.size() == 20);
+
+    // A ring which is not full has evicted nothing, there is no older data anywhere
+    RollupPyramid young(kLevels);
+    for (int64_t time = 100; time < 130; time++) {
+        young.add(time, 1.0);
+    }
+    buckets = query(young, 0, 130, 1, &duration);
+    CHECK(duration == 1);
+    CHECK(buckets.size() == 30);
+    CHECK(buckets.front().start == 100);
+}
+
+TEST(MemoryDoesNotGrowWithSamples) {
+    RollupPyramid pyramid(kLevels);
+    const size_t expected = (60 + 60 + 60) * sizeof(RollupBucket);
+    CHECK(pyramid.memoryUsage() == expected);
+    CHECK(pyramid.retention() == 3600);
+    for (int64_t time = 0; time < 100000; time++) {
+        pyramid.add(time, static_cast<double>(time % 7));
+    }
+    CHECK(pyramid.memoryUsage() == expected);
+    pyramid.clear();
+    CHECK(pyramid.memoryUsage() == expected);
+    CHECK(query(pyramid, 0, 100000, 1).empty());
+
+    // Levels without buckets or duration still keep one bucket
+    RollupPyramid degenerate({ { 0, 0 } });
+    CHECK(degenerate.memoryUsage() == sizeof(RollupBucket));
+    degenerate.add(5, 1.0);
+    degenerate.add(6, 2.0);
+    std::vector<RollupBucket> buckets = query(degenerate, 0, 10, 1);
+    CHECK(buckets.size() == 1);
+    CHECK(buckets.front().start == 6);
+
+    RollupPyramid empty({});
+    CHECK(empty.memoryUsage() == 0);
+    CHECK(empty.retention() == 0);
+    CHECK(query(empty, 0, 10, 1).empty());
+}
@@ -0,0 +1,164 @@
+#include <string>
+#include <vector>
+
+#include "Plugin/RouterTimeline.h"
+#include "Plugin/RrdParser.h"
+#include "TestUtils.h"
+
+// Consecutive show/interface/rrd responses of a router polled every second, for two interfaces
+// (download and upload series of each), read the way the worker reads them
+
+namespace {
+
+using Result = RouterTimeline::Result;
+
+// Polled every second, three missed polls are a gap
+constexpr int64_t kMaxStep = 3;
+
+class Poller {
+public:
+    explicit Poller(size_t interfaces) : timeline_(interfaces), interfaces_(interfaces) {
+    }
+
+    std::vector<Result> poll(const std::string& response) {
+        CHECK(parser_.parse(response.data(), response.size(), series_));
+        std::vector<Result> results;
+        for (size_t slot = 0; slot < interfaces_; slot++) {
+            // A response shorter than requested has no series for the last interfaces
+            const RrdSeries* download = slot * 2 < series_.size() ? &series_[slot * 2] : nullptr;
+            const RrdSeries* upload = slot * 2 + 1 < series_.size() ? &series_[slot * 2 + 1] : nullptr;
+            results.push_back(timeline_.update(slot, download, upload, kMaxStep));
+        }
+        return results;
+    }
+
+    RouterTimeline& timeline() {
+        return timeline_;
+    }
+
+private:
+    RrdParser parser_;
+    std::vector<RrdSeries> series_;
+    RouterTimeline timeline_;
+    size_t interfaces_;
+};
+
+// Only these are published and added to the history
+bool isFresh(Result result) {
+    return result == Result::New || result == Result::Gap;
+}
+
+}
+
+TEST(RepeatedTimestampsAreNotFresh) {
+    Poller poller(2);
+    std::vector<Result> results = poller.poll(R"([
+        {"data": [{"t": 1700000100, "v": 81920}], "status": []},
+        {"data": [{"t": 1700000100, "v": 4096}], "status": []},
+        {"data": [{"t": 1700000100, "v": 0}], "status": []},
+        {"data": [{"t": 1700000100, "v": 0}], "status": []}
+    ])");
+    CHECK((results == std::vector<Result>{ Result::New, Result::New }));
+
+    // Polled again before the router produced the next sample of the first interface
+    results = poller.poll(R"([
+        {"data": [{"t": 1700000100, "v": 81920}], "status": []},
+        {"data": [{"t": 1700000100, "v": 4096}], "status": []},
+        {"data": [{"t": 1700000101, "v": 512}], "status": []},
+        {"data": [{"t": 1700000101, "v": 0}], "status": []}
+    ])");
+    CHECK((results == std::vector<Result>{ Result::Repeated, Result::New }));
+    CHECK(!isFresh(results[0]));
+
+    results = poller.poll(R"([
+        {"data": [{"t": 1700000101, "v": 90112}], "status": []},
+        {"data": [{"t": 1700000101, "v": 4096}], "status": []},
+        {"data": [{"t": 1700000101, "v": 512}], "status": []},
+        {"data": [{"t": 1700000101, "v": 0}], "status": []}
+    ])");
+    CHECK((results == std::vector<Result>{ Result::New, Result::Repeated }));
+}
+
+TEST(SkippedTimestampsAreGaps) {
+    Poller poller(1);
+    auto response = [](int64_t time) {
+        std::string t = std::to_string(time);
+        return "[{\"data\": [{\"t\": " + t + ", \"v\": 100}], \"status\": []},"
+            " {\"data\": [{\"t\": " + t + ", \"v\": 200}], \"status\": []}]";
+    };
+    CHECK(poller.poll(response(1700000100))[0] == Result::New);
+    // Late polls within the expected step
+    CHECK(poller.poll(response(1700000103))[0] == Result::New);
+    // The router's history holds samples we have not seen
+    CHECK(poller.poll(response(1700000110))[0] == Result::Gap);
+    CHECK(isFresh(Result::Gap));
+    CHECK(poller.poll(response(1700000111))[0] == Result::New);
+    // The router's clock was set back
+    CHECK(poller.poll(response(1700000050))[0] == Result::New);
+    CHECK(poller.poll(response(1700000050))[0] == Result::Repeated);
+}
+
+TEST(MissingSeriesAreNotFresh) {
+    Poller poller(2);
+    std::string full = R"([
+        {"data": [{"t": 1700000100, "v": 1}], "status": []},
+        {"data": [{"t": 1700000100, "v": 2}], "status": []},
+        {"data": [{"t": 1700000100, "v": 3}], "status": []},
+        {"data": [{"t": 1700000100, "v": 4}], "status": []}
+    ])";
+    poller.poll(full);
+
+    // The second interface was removed from the router, the response is shorter than the request
+    std::vector<Result> results = poller.poll(R"([
+        {"data": [{"t": 1700000101, "v": 1}], "status": []},
+        {"data": [{"t": 1700000101, "v": 2}], "status": []}
+    ])");
+    CHECK((results == std::vector<Result>{ Result::New, Result::Missing }));
+
+    results = poller.poll(R"([
+        {"data": [{"t": 1700000102, "v": 1}], "status": []},
+        {"data": [{"t": 1700000102, "v": 2}], "status": []},
+        {"status": [{"status": "error", "code": "7405600", "ident": "Core::Rrd", "message": "no such interface"}]},
+        {"data": [], "status": []}
+    ])");
+    CHECK((results == std::vector<Result>{ Result::New, Result::Missing }));
+
+    // A missing sample does not move the timeline, the old one is still not fresh when it comes back
+    results = poller.poll(full);
+    CHECK(results[1] == Result::Repeated);
+}
+
+TEST(DirectionsShareTheNewestTimestamp) {
+    Poller poller(1);
+    poller.poll(R"([{"data": [{"t": 1700000100, "v": 1}]}, {"data": [{"t": 1700000100, "v": 2}]}])");
+    // Only the upload series has advanced
+    CHECK(poller.poll(R"([{"data": [{"t": 1700000100, "v": 1}]}, {"data": [{"t": 1700000101, "v": 2}]}])")[0]
+        == Result::New);
+    // Only one of the series is present
+    CHECK(poller.poll(R"([{"data": [{"t": 1700000102, "v": 1}]}, {"data": []}])")[0] == Result::New);
+    CHECK(poller.poll(R"([{"data": []}, {"data": [{"t": 1700000102, "v": 2}]}])")[0] == Result::Repeated);
+}
+
+TEST(SamplesWithoutTimestampsAreAlwaysNew) {
+    Poller poller(1);
+    std::string untimed = R"([{"data": [{"v": 1}]}, {"data": [{"v": 2}]}])";
+    CHECK(poller.poll(untimed)[0] == Result::New);
+    CHECK(poller.poll(untimed)[0] == Result::New);
+
+    // They do not count as the previous sample when timestamps appear
+    std::string timed = R"([{"data": [{"t": 1700000100, "v": 1}]}, {"data": [{"t": 1700000100, "v": 2}]}])";
+    CHECK(poller.poll(timed)[0] == Result::New);
+    CHECK(poller.poll(untimed)[0] == Result::New);
+    CHECK(poller.poll(timed)[0] == Result::Repeated);
+}
+
+TEST(ResetForgetsTheLatestSample) {
+    Poller poller(2);
+    std::string response = R"([
+        {"data": [{"t": 1700000100, "v": 1}]}, {"data": [{"t": 1700000100, "v": 2}]},
+        {"data": [{"t": 1700000100, "v": 3}]}, {"data": [{"t": 1700000100, "v": 4}]}
+    ])";
+    poller.poll(response);
+    poller.timeline().reset(1);
+    CHECK((poller.poll(response) == std::vector<Result>{ Result::Repeated, Result::New }));
+}
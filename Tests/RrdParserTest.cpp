@@ -0,0 +1,160 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <json/version.h>
+
+#include "Plugin/ResponseReader.h"
+#include "Plugin/RrdParser.h"
+#include "RouterResponses.h"
+#include "TestUtils.h"
+
+// The streaming parser must read show/interface/rrd responses exactly like the jsoncpp path
+
+namespace {
+
+bool sameSeries(const RrdSeries& a, const RrdSeries& b) {
+    if (a.value != b.value || a.time != b.time || a.hasValue != b.hasValue || a.failed != b.failed
+        || a.message != b.message || a.samples.size() != b.samples.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.samples.size(); i++) {
+        if (a.samples[i].time != b.samples[i].time || a.samples[i].value != b.samples[i].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Both readers accept the response and produce the same series, which are returned
+std::vector<RrdSeries> readBoth(const std::string& body, bool withSamples) {
+    std::unique_ptr<ResponseReader> streaming = ResponseReader::create(ResponseParser::Default);
+    std::unique_ptr<ResponseReader> jsoncpp = ResponseReader::create(ResponseParser::JsonCpp);
+    std::vector<RrdSeries> expected;
+    std::vector<RrdSeries> actual;
+    CHECK(jsoncpp->readRrd(body, expected, withSamples));
+    CHECK(streaming->readRrd(body, actual, withSamples));
+    CHECK(actual.size() == expected.size());
+    for (size_t i = 0; i < actual.size() && i < expected.size(); i++) {
+        CHECK(sameSeries(actual[i], expected[i]));
+    }
+    return actual;
+}
+
+}
+
+TEST(GeneratedResponsesMatchJsonCpp) {
+    for (size_t series : { 0, 1, 2, 16, 128 }) {
+        for (size_t samples : { 0, 1, 60 }) {
+            std::string body = rrdResponse(series, 1700000000, samples);
+            readBoth(body, false);
+            readBoth(body, true);
+        }
+    }
+
+    std::vector<RrdSeries> result = readBoth(rrdResponse(2, 1700000000, 3, 60), true);
+    CHECK(result[1].hasValue);
+    CHECK(result[1].value == 2000.0);
+    CHECK(result[1].time == 1700000000);
+    CHECK(result[1].samples.size() == 3);
+    CHECK(result[1].samples[2].time == 1700000000 - 120);
+    CHECK(result[1].samples[2].value == 2002.0);
+}
+
+TEST(ErrorStatusIsReported) {
+    std::string body = R"([
+        {"status": [{"status": "error", "code": "7405600", "ident": "Core::Rrd", "message": "no such interface: \"Wg\"\n\u00e9"}]},
+        {"status": [{"status": "message", "message": "ok"}], "data": [{"t": 5, "v": 1}]}
+    ])";
+    std::vector<RrdSeries> result = readBoth(body, false);
+    CHECK(result[0].failed);
+    CHECK(!result[0].hasValue);
+    CHECK(result[0].message == "no such interface: \"Wg\"\n\xC3\xA9");
+    CHECK(!result[1].failed);
+    CHECK(result[1].hasValue);
+}
+
+TEST(UnknownKeysAndOddValuesAreSkipped) {
+    std::string body = R"( [ { "extra" : { "nested" : [ 1, -2.5e3, true, null, { "a" : "]}" } ] } ,
+        "data" : [ { "x" : [ ], "v" : 12.75 , "t" : 1700000001 , "q" : "v" } , { "t" : 1700000000, "v" : -1 } ] ,
+        "status" : [ ] } , { "data" : [ ] } , { "data" : [ { "v" : 3 } ] } ] )";
+    std::vector<RrdSeries> result = readBoth(body, true);
+    CHECK(result.size() == 3);
+    CHECK(result[0].value == 12.75);
+    CHECK(result[0].time == 1700000001);
+    CHECK(result[0].samples.size() == 2);
+    // Empty data, and a sample without a timestamp
+    CHECK(!result[1].hasValue);
+    CHECK(result[2].hasValue);
+    CHECK(result[2].time == 0);
+}
+
+TEST(OutOfRangeNumbersMatchJsonCpp) {
+    // Too small magnitudes are zero
+    std::string body = R"([{"data": [{"t": 2, "v": 1e-400}, {"t": 1, "v": -2.5e-999}], "extra": [1e-999]}])";
+    std::vector<RrdSeries> result = readBoth(body, true);
+    CHECK(result[0].samples.size() == 2);
+    CHECK(result[0].samples[0].value == 0.0);
+    CHECK(result[0].samples[1].value == 0.0);
+
+    // Too large ones are infinite, jsoncpp rejected them before 1.9.6, which the plugin is built with
+    body = R"([{"data": [{"t": 2, "v": 1e400}, {"t": 1, "v": -1e400}], "extra": [1e999]}])";
+#if JSONCPP_VERSION_HEXA >= 0x01090600
+    result = readBoth(body, true);
+#else
+    RrdParser parser;
+    CHECK(parser.parse(body.data(), body.size(), result, true));
+#endif
+    CHECK(result[0].samples.size() == 2);
+    CHECK(std::isinf(result[0].samples[0].value) && result[0].samples[0].value > 0);
+    CHECK(std::isinf(result[0].samples[1].value) && result[0].samples[1].value < 0);
+}
+
+TEST(NonJsonNumbersAreRejected) {
+    std::unique_ptr<ResponseReader> streaming = ResponseReader::create(ResponseParser::Default);
+    std::unique_ptr<ResponseReader> jsoncpp = ResponseReader::create(ResponseParser::JsonCpp);
+    std::vector<RrdSeries> series;
+    for (const char* value : { "inf", "-inf", "nan", "NaN", "infinity", "-Infinity", ".5" }) {
+        for (const char* format : { R"([{"data": [{"t": 1, "v": %s}]}])", R"([{"data": [], "extra": %s}])" }) {
+            char body[128];
+            snprintf(body, sizeof(body), format, value);
+            CHECK(!jsoncpp->readRrd(body, series, false));
+            CHECK(!streaming->readRrd(body, series, false));
+        }
+    }
+}
+
+TEST(MalformedResponsesAreRejected) {
+    RrdParser parser;
+    std::vector<RrdSeries> series;
+    for (const char* body : {
+            "", "{}", "[", "[{\"data\": [{\"v\": 1}]}", "[{\"data\": [{\"v\": 1}]}] x",
+            "[{\"data\": [{\"v\": }]}]", "[{\"status\": [{\"message\": \"\\u12\"}]}]", "[1 2]" }) {
+        CHECK(!parser.parse(body, strlen(body), series));
+        CHECK(!parser.error().empty());
+    }
+
+    // Deep nesting does not exhaust the stack
+    std::string deep = "[{\"x\": " + std::string(100000, '[') + std::string(100000, ']') + "}]";
+    CHECK(!parser.parse(deep.data(), deep.size(), series));
+}
+
+TEST(SeriesAreReusedBetweenPolls) {
+    RrdParser parser;
+    std::vector<RrdSeries> series;
+    std::string large = rrdResponse(8, 1700000000, 5);
+    CHECK(parser.parse(large.data(), large.size(), series, true));
+    CHECK(series.size() == 8);
+
+    std::string failed = R"([{"status": [{"status": "error", "message": "gone"}]}])";
+    CHECK(parser.parse(failed.data(), failed.size(), series));
+    CHECK(series.size() == 1);
+    // Nothing is left over from the previous response
+    CHECK(!series[0].hasValue);
+    CHECK(series[0].value == 0.0);
+    CHECK(series[0].samples.empty());
+    CHECK(series[0].message == "gone");
+}
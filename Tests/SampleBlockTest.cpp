@@ -0,0 +1,228 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "Plugin/SampleBlock.h"
+#include "TestUtils.h"
+
+namespace {
+
+struct Block {
+    alignas(8) uint8_t data[SampleBlock::kSize];
+};
+
+bool sameRecord(const HistoryRecord& a, const HistoryRecord& b) {
+    // Values are compared bitwise, NaN and negative zero must survive as well
+    return a.time == b.time && std::memcmp(&a.download, &b.download, sizeof(float)) == 0
+        && std::memcmp(&a.upload, &b.upload, sizeof(float)) == 0;
+}
+
+bool sameValue(double a, double b) {
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+std::vector<HistoryRecord> decode(const Block& block) {
+    std::vector<HistoryRecord> records;
+    SampleBlock::Reader reader(block.data);
+    HistoryRecord record;
+    while (reader.next(record)) {
+        records.push_back(record);
+    }
+    return records;
+}
+
+// Appends records until the block is full, returns the ones accepted
+std::vector<HistoryRecord> fill(SampleBlock::Writer& writer, const std::vector<HistoryRecord>& records) {
+    std::vector<HistoryRecord> accepted;
+    for (const HistoryRecord& record : records) {
+        if (!writer.append(record)) {
+            break;
+        }
+        accepted.push_back(record);
+    }
+    return accepted;
+}
+
+bool sameRecords(const std::vector<HistoryRecord>& a, const std::vector<HistoryRecord>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!sameRecord(a[i], b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t nextRandom(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+// Timestamps of every size class of the delta-of-delta encoding, values of every kind of XOR
+std::vector<HistoryRecord> mixedRecords(size_t count) {
+    std::vector<HistoryRecord> records;
+    uint32_t random = 1;
+    int64_t time = 1700000000000;
+    const int64_t steps[] = { 1000, 1000, 1000, 1003, 997, 1100, 1000, 5000, 1000, 3600000, 1000, 1, 86400000000 };
+    const float values[] = { 0.0f, 0.0f, 125000.0f, 125000.0f, 125001.5f, -0.0f, 1e-40f, 3.4e38f,
+        std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(), 42.0f };
+    for (size_t i = 0; i < count; i++) {
+        time += steps[nextRandom(random) % (sizeof(steps) / sizeof(steps[0]))];
+        float download = values[nextRandom(random) % (sizeof(values) / sizeof(values[0]))];
+        float upload = i % 5 ? static_cast<float>(nextRandom(random) % 100000) : download;
+        records.push_back(HistoryRecord{ time, download, upload });
+    }
+    return records;
+}
+
+}
+
+TEST(RecordsRoundTripUntilTheBlockIsFull) {
+    Block block;
+    SampleBlock::Writer writer;
+    writer.start(block.data);
+    std::vector<HistoryRecord> records = mixedRecords(10000);
+    std::vector<HistoryRecord> accepted = fill(writer, records);
+    CHECK(accepted.size() > 100);
+    CHECK(accepted.size() < records.size());
+    CHECK(writer.header().bits <= SampleBlock::kCapacityBits);
+    CHECK(sameRecords(decode(block), accepted));
+
+    // A rejected record leaves the block as it was
+    SampleBlockHeader header = writer.header();
+    CHECK(!writer.append(records[accepted.size()]));
+    CHECK(std::memcmp(&header, &writer.header(), sizeof(header)) == 0);
+    CHECK(sameRecords(decode(block), accepted));
+}
+
+TEST(HeaderSummarizesTheBlock) {
+    Block block;
+    SampleBlock::Writer writer;
+    writer.start(block.data);
+    CHECK(decode(block).empty());
+    std::vector<HistoryRecord> records;
+    for (int i = 0; i < 100; i++) {
+        records.push_back(HistoryRecord{ 1000 * (i + 1), static_cast<float>(i % 10), static_cast<float>(50 - i) });
+    }
+    CHECK(fill(writer, records).size() == records.size());
+    const SampleBlockHeader& header = writer.header();
+    CHECK(header.count == 100);
+    CHECK(header.firstTime == 1000);
+    CHECK(header.lastTime == 100000);
+    CHECK(header.download.minimum == 0.0f);
+    CHECK(header.download.maximum == 9.0f);
+    CHECK(header.download.sum == 450.0);
+    CHECK(header.upload.minimum == -49.0f);
+    CHECK(header.upload.maximum == 50.0f);
+    CHECK(header.upload.sum == 50.0 * 100 - 4950.0);
+}
+
+TEST(RegularSamplesTakeFewBits) {
+    Block block;
+    SampleBlock::Writer writer;
+    writer.start(block.data);
+    std::vector<HistoryRecord> records;
+    for (int i = 0; i < 100000; i++) {
+        // An idle link: evenly spaced samples, the speed rarely changes
+        records.push_back(HistoryRecord{ 1000 * i, i % 50 ? 0.0f : 1200.0f, 0.0f });
+    }
+    std::vector<HistoryRecord> accepted = fill(writer, records);
+    // Against 16 bytes of a raw record
+    CHECK(SampleBlock::kSize / static_cast<double>(accepted.size()) < 1.0);
+    CHECK(sameRecords(decode(block), accepted));
+}
+
+TEST(ResumeContinuesTheCommittedSamples) {
+    Block block;
+    SampleBlock::Writer writer;
+    writer.start(block.data);
+    std::vector<HistoryRecord> records = mixedRecords(2000);
+    std::vector<HistoryRecord> accepted = fill(writer, std::vector<HistoryRecord>(records.begin(), records.begin() + 60));
+    CHECK(accepted.size() == 60);
+
+    // The crash came after 40 samples were committed, the header and data are ahead of them
+    SampleBlock::Reader reader(block.data);
+    HistoryRecord record;
+    for (int i = 0; i < 40; i++) {
+        CHECK(reader.next(record));
+    }
+    uint32_t committedBits = reader.state().bits;
+
+    SampleBlock::Writer resumed;
+    CHECK(resumed.resume(block.data, 40, committedBits));
+    CHECK(resumed.header().count == 40);
+    CHECK(resumed.header().lastTime == records[39].time);
+
+    // New samples are encoded against the state of the last committed one
+    std::vector<HistoryRecord> more(records.begin() + 40, records.end());
+    std::vector<HistoryRecord> expected(records.begin(), records.begin() + 40);
+    std::vector<HistoryRecord> added = fill(resumed, more);
+    expected.insert(expected.end(), added.begin(), added.end());
+    CHECK(added.size() > 40);
+    CHECK(sameRecords(decode(block), expected));
+
+    // The rebuilt summary is the one of the records in the block
+    Block fresh;
+    SampleBlock::Writer direct;
+    direct.start(fresh.data);
+    fill(direct, expected);
+    const SampleBlockHeader& a = resumed.header();
+    const SampleBlockHeader& b = direct.header();
+    CHECK(a.count == b.count && a.bits == b.bits && a.firstTime == b.firstTime && a.lastTime == b.lastTime);
+    CHECK(sameValue(a.download.minimum, b.download.minimum) && sameValue(a.download.maximum, b.download.maximum));
+    CHECK(sameValue(a.download.sum, b.download.sum) && sameValue(a.upload.sum, b.upload.sum));
+}
+
+TEST(ResumeOfAnEmptyBlock) {
+    Block block;
+    SampleBlock::Writer writer;
+    writer.start(block.data);
+    fill(writer, mixedRecords(10));
+
+    SampleBlock::Writer resumed;
+    CHECK(resumed.resume(block.data, 0, 0));
+    CHECK(resumed.header().count == 0);
+    std::vector<HistoryRecord> records = mixedRecords(5);
+    CHECK(fill(resumed, records).size() == 5);
+    CHECK(sameRecords(decode(block), records));
+}
+
+TEST(DamagedBlocksAreRejected) {
+    Block block;
+    SampleBlock::Writer writer;
+    writer.start(block.data);
+    std::vector<HistoryRecord> accepted = fill(writer, mixedRecords(10000));
+
+    // Committed state which does not match the data
+    SampleBlock::Writer resumed;
+    Block copy = block;
+    CHECK(!resumed.resume(copy.data, static_cast<uint32_t>(accepted.size()), writer.header().bits - 1));
+    copy = block;
+    CHECK(!resumed.resume(copy.data, static_cast<uint32_t>(accepted.size()) + 1, writer.header().bits));
+    copy = block;
+    CHECK(!resumed.resume(copy.data, 1, SampleBlock::kCapacityBits + 8));
+
+    // A header claiming more bits than a block holds is not decoded at all
+    copy = block;
+    reinterpret_cast<SampleBlockHeader*>(copy.data)->bits = SampleBlock::kCapacityBits + 1;
+    CHECK(decode(copy).empty());
+
+    // Damaged data never reads past the encoded bits, the records decoded are a prefix of the block
+    uint32_t random = 7;
+    for (int i = 0; i < 2000; i++) {
+        copy = block;
+        size_t offset = sizeof(SampleBlockHeader) + nextRandom(random) % (SampleBlock::kSize - sizeof(SampleBlockHeader));
+        copy.data[offset] ^= static_cast<uint8_t>(1 + nextRandom(random) % 255);
+        std::vector<HistoryRecord> records = decode(copy);
+        CHECK(records.size() <= accepted.size());
+        SampleBlock::Reader reader(copy.data);
+        HistoryRecord record;
+        while (reader.next(record)) {
+        }
+        CHECK(reader.state().bits <= writer.header().bits);
+    }
+}
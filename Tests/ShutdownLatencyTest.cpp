@@ -0,0 +1,103 @@
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <memory>
+
+#include "Core/Network/CurlMultiReactor.h"
+#include "Core/Network/NetworkClient.h"
+#include "MockRouter.h"
+#include "TestUtils.h"
+
+// Shutting the plugin down must not keep the UI thread waiting for a slow or unreachable router
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Well within a Rainmeter frame
+constexpr auto kMaxShutdownLatency = std::chrono::milliseconds(10);
+
+// Logout takes 100 ms, polls are stalled
+MockRouter::Handler slowHandler() {
+    return [](const MockRequest& request) {
+        MockResponse response;
+        response.delay = request.method == "DELETE" ? std::chrono::milliseconds(100) : std::chrono::milliseconds(10000);
+        return response;
+    };
+}
+
+std::future<CURLcode> startRequest(CurlMultiReactor& reactor, NetworkClient& client, const std::string& url,
+    const std::string& method) {
+    auto done = std::make_shared<std::promise<CURLcode>>();
+    std::future<CURLcode> future = done->get_future();
+    client.setUrl(url);
+    client.setMethod(method);
+    client.preparePost({});
+    reactor.invoke([&reactor, &client, done] {
+        reactor.addTransfer(client.getCurlHandle(), [done](CURLcode result) {
+            done->set_value(result);
+        });
+    });
+    return future;
+}
+
+std::chrono::milliseconds elapsed(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+}
+
+}
+
+TEST(StopWakesIdleLoopAtOnce) {
+    CurlMultiReactor reactor;
+    reactor.start();
+    // The loop sleeps until the timer is due
+    reactor.scheduleAt(Clock::now() + std::chrono::seconds(30), [] {});
+    reactor.invoke([] {});
+
+    auto start = Clock::now();
+    reactor.stop();
+    CHECK(Clock::now() - start < kMaxShutdownLatency);
+}
+
+TEST(DetachedStopReturnsAtOnceWhileRouterIsSlow) {
+    MockRouter router(slowHandler());
+    auto reactor = std::make_unique<CurlMultiReactor>();
+    reactor->start();
+    NetworkClient poll;
+    NetworkClient logout;
+    std::future<CURLcode> pollResult = startRequest(*reactor, poll, router.url() + "/rci/show/interface/rrd", "POST");
+    std::future<CURLcode> logoutResult = startRequest(*reactor, logout, router.url() + "/auth", "DELETE");
+
+    auto stopped = std::make_shared<std::promise<void>>();
+    auto start = Clock::now();
+    CurlMultiReactor::stopDetached(std::move(reactor), [stopped] { stopped->set_value(); },
+        std::chrono::milliseconds(300));
+    auto latency = Clock::now() - start;
+    printf("detached stop returned in %.3f ms\n", std::chrono::duration<double, std::milli>(latency).count());
+    CHECK(latency < kMaxShutdownLatency);
+
+    // The logout completes during the drain, the stalled poll is aborted when it runs out
+    CHECK(stopped->get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    CHECK(elapsed(start) >= std::chrono::milliseconds(250));
+    CHECK(elapsed(start) < std::chrono::milliseconds(2000));
+    CHECK(logoutResult.get() == CURLE_OK);
+    CHECK(pollResult.get() == CURLE_ABORTED_BY_CALLBACK);
+}
+
+TEST(DetachedStopFinishesEarlyWhenDrained) {
+    MockRouter router(slowHandler());
+    auto reactor = std::make_unique<CurlMultiReactor>();
+    reactor->start();
+    NetworkClient logout;
+    std::future<CURLcode> logoutResult = startRequest(*reactor, logout, router.url() + "/auth", "DELETE");
+
+    auto stopped = std::make_shared<std::promise<void>>();
+    auto start = Clock::now();
+    CurlMultiReactor::stopDetached(std::move(reactor), [stopped] { stopped->set_value(); });
+    CHECK(Clock::now() - start < kMaxShutdownLatency);
+    CHECK(stopped->get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    // Nothing is left to wait for once the logout is answered
+    CHECK(elapsed(start) >= std::chrono::milliseconds(80));
+    CHECK(elapsed(start) < std::chrono::milliseconds(400));
+    CHECK(logoutResult.get() == CURLE_OK);
+}
@@ -0,0 +1,80 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "Plugin/SpeedTable.h"
+#include "TestUtils.h"
+
+namespace {
+
+// Snapshot number n has download n and upload -n on every interface
+std::vector<InterfaceSpeed> snapshot(size_t size, double n) {
+    return std::vector<InterfaceSpeed>(size, InterfaceSpeed{ n, -n });
+}
+
+}
+
+TEST(ReadsPublishedSpeeds) {
+    SpeedTable table(3);
+    CHECK(table.size() == 3);
+    CHECK(table.read(1).download == 0.0);
+
+    table.publish({ { 1.0, 2.0 }, { 3.0, 4.0 }, { 5.0, 6.0 } });
+    CHECK(table.read(1).download == 3.0);
+    CHECK(table.read(1).upload == 4.0);
+    // Out of range reads are zero
+    CHECK(table.read(3).download == 0.0);
+
+    // Only the given interfaces are updated
+    table.publish({ { 7.0, 8.0 } });
+    CHECK(table.read(0).download == 7.0);
+    CHECK(table.read(2).upload == 6.0);
+
+    table.clear();
+    CHECK(table.read(0).download == 0.0);
+    CHECK(table.read(2).upload == 0.0);
+}
+
+TEST(ReadersNeverSeeTornSnapshots) {
+    constexpr size_t kInterfaces = 16;
+    constexpr int kReaders = 4;
+    SpeedTable table(kInterfaces);
+    std::atomic_bool stop{ false };
+    std::atomic<uint64_t> torn{ 0 };
+    std::atomic<uint64_t> reversed{ 0 };
+    std::atomic<uint64_t> reads{ 0 };
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < kReaders; r++) {
+        readers.emplace_back([&, r] {
+            double last = 0.0;
+            uint64_t count = 0;
+            while (!stop) {
+                InterfaceSpeed speed = table.read((r + count) % kInterfaces);
+                // Both values come from the same publish(), and publishes are seen in order
+                torn += speed.upload != -speed.download;
+                reversed += speed.download < last;
+                last = speed.download;
+                count++;
+            }
+            reads += count;
+        });
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    std::vector<InterfaceSpeed> speeds;
+    double n = 0.0;
+    while (std::chrono::steady_clock::now() < deadline) {
+        speeds = snapshot(kInterfaces, ++n);
+        table.publish(speeds);
+    }
+    stop = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    CHECK(n > 1000.0);
+    CHECK(reads > 1000);
+    CHECK(torn == 0);
+    CHECK(reversed == 0);
+}
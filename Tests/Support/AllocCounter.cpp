@@ -0,0 +1,97 @@
+#include "AllocCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocationCount{ 0 };
+std::atomic<uint64_t> byteCount{ 0 };
+thread_local uint64_t threadAllocationCount = 0;
+thread_local uint64_t threadByteCount = 0;
+
+void* allocate(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    threadAllocationCount++;
+    byteCount.fetch_add(size, std::memory_order_relaxed);
+    threadByteCount += size;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* allocateAligned(size_t size, size_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    threadAllocationCount++;
+    byteCount.fetch_add(size, std::memory_order_relaxed);
+    threadByteCount += size;
+#ifdef _WIN32
+    void* p = _aligned_malloc(size ? size : 1, alignment);
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, size ? size : 1)) {
+        p = nullptr;
+    }
+#endif
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void freeAligned(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+}
+
+namespace AllocCounter {
+
+uint64_t allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+uint64_t threadAllocations() {
+    return threadAllocationCount;
+}
+
+uint64_t allocatedBytes() {
+    return byteCount.load(std::memory_order_relaxed);
+}
+
+uint64_t threadAllocatedBytes() {
+    return threadByteCount;
+}
+
+}
+
+// The array and nothrow forms call these ones by default
+void* operator new(size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return allocateAligned(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    freeAligned(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    freeAligned(p);
+}
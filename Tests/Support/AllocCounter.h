@@ -0,0 +1,28 @@
+#ifndef KEENETIC_TESTS_ALLOCCOUNTER_H
+#define KEENETIC_TESTS_ALLOCCOUNTER_H
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Counts the heap allocations of the whole process by replacing the global operator new.
+ * Linked only into the executables which measure allocations, see keenetic_alloc_counter.
+ */
+namespace AllocCounter {
+
+// Allocations made so far, by all threads
+uint64_t allocations();
+
+// Allocations made so far by the calling thread, e.g. a client while a mock server runs in other threads
+uint64_t threadAllocations();
+
+// Bytes requested by all the allocations
+uint64_t allocatedBytes();
+
+// Bytes requested by the allocations of the calling thread
+uint64_t threadAllocatedBytes();
+
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef KEENETIC_TESTS_BENCHUTILS_H
+#define KEENETIC_TESTS_BENCHUTILS_H
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Measurements shared by the benchmarks. Results are printed as plain text tables, the numbers
+ * are only comparable between runs on the same machine.
+ */
+namespace BenchUtils {
+
+/**
+ * Calls func repeatedly for at least minTime, after one warm-up call.
+ * @return average time of a call, in nanoseconds.
+ */
+template<class Func>
+double nsPerCall(Func&& func, std::chrono::milliseconds minTime = std::chrono::milliseconds(300)) {
+    func();
+    uint64_t calls = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    do {
+        func();
+        calls++;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed < minTime);
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / calls;
+}
+
+// Keeps a computed value alive, so the compiler cannot drop the computation
+void consume(double value);
+
+// CPU time (user and kernel) of the calling thread, in seconds
+double threadCpuSeconds();
+
+// CPU time (user and kernel) of the whole process, in seconds
+double processCpuSeconds();
+
+// Resident memory of the process, in bytes
+size_t residentBytes();
+
+}
+
+#endif
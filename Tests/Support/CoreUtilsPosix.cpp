@@ -0,0 +1,22 @@
+// Conversions which Core/Utils implements only in Utils_win.cpp, for the test builds on other platforms
+
+#include "Core/Utils/CoreUtils.h"
+
+#include <codecvt>
+#include <locale>
+
+namespace IuCoreUtils {
+
+const std::wstring Utf8ToWstring(const std::string& str) {
+    return std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(str);
+}
+
+const std::string WstringToUtf8(const std::wstring& str) {
+    return std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(str);
+}
+
+std::string Utf16ToUtf8(const std::u16string& src) {
+    return std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>().to_bytes(src);
+}
+
+}
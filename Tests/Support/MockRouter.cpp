@@ -0,0 +1,298 @@
+#include "MockRouter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "RouterResponses.h"
+
+namespace {
+
+#ifdef _WIN32
+using NativeSocket = SOCKET;
+constexpr int kShutdownBoth = SD_BOTH;
+constexpr int kSendFlags = 0;
+
+void closeSocket(NativeSocket s) {
+    closesocket(s);
+}
+
+// Winsock is initialized once for the process and never cleaned up
+void initSockets() {
+    static bool initialized = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    (void)initialized;
+}
+#else
+using NativeSocket = int;
+constexpr NativeSocket INVALID_SOCKET = -1;
+constexpr int kShutdownBoth = SHUT_RDWR;
+constexpr int kSendFlags = MSG_NOSIGNAL;
+
+void closeSocket(NativeSocket s) {
+    close(s);
+}
+
+void initSockets() {
+}
+#endif
+
+NativeSocket native(intptr_t s) {
+    return static_cast<NativeSocket>(s);
+}
+
+bool sendAll(intptr_t s, const char* data, size_t size) {
+    while (size) {
+        int chunk = static_cast<int>(std::min<size_t>(size, 1 << 20));
+        int sent = send(native(s), data, chunk, kSendFlags);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+std::string lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+const char* reasonPhrase(int status) {
+    switch (status) {
+    case 200:
+        return "OK";
+    case 401:
+        return "Unauthorized";
+    case 404:
+        return "Not Found";
+    default:
+        return "Status";
+    }
+}
+
+}
+
+MockRouter::MockRouter(Handler handler) : handler_(std::move(handler)) {
+    initSockets();
+    NativeSocket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET) {
+        throw std::runtime_error("socket() failed");
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t length = sizeof(addr);
+    if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(s, 128) != 0
+        || getsockname(s, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        closeSocket(s);
+        throw std::runtime_error("Unable to listen on the loopback interface");
+    }
+    listenSocket_ = static_cast<Socket>(s);
+    port_ = ntohs(addr.sin_port);
+    acceptThread_ = std::thread(&MockRouter::acceptConnections, this);
+}
+
+MockRouter::~MockRouter() {
+    stop();
+}
+
+std::string MockRouter::url() const {
+    return "http://127.0.0.1:" + std::to_string(port_);
+}
+
+uint16_t MockRouter::port() const {
+    return port_;
+}
+
+size_t MockRouter::requestCount() const {
+    return requests_;
+}
+
+void MockRouter::stop() {
+    if (stopped_.exchange(true)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stopCondition_.notify_all();
+        for (Socket s : connections_) {
+            shutdown(native(s), kShutdownBoth);
+        }
+    }
+    // Wakes up accept(), on Windows only closing the socket does
+    shutdown(native(listenSocket_), kShutdownBoth);
+#ifdef _WIN32
+    closeSocket(native(listenSocket_));
+#endif
+    acceptThread_.join();
+#ifndef _WIN32
+    closeSocket(native(listenSocket_));
+#endif
+    // No new threads are started once the accepting thread is finished
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void MockRouter::acceptConnections() {
+    while (!stopped_) {
+        NativeSocket s = accept(native(listenSocket_), nullptr, nullptr);
+        if (s == INVALID_SOCKET) {
+            continue;
+        }
+        int noDelay = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (stopped_) {
+            closeSocket(s);
+            break;
+        }
+        connections_.push_back(static_cast<Socket>(s));
+        threads_.emplace_back(&MockRouter::serve, this, static_cast<Socket>(s));
+    }
+}
+
+void MockRouter::serve(Socket socket) {
+    std::string buffer;
+    MockRequest request;
+    while (!stopped_ && readRequest(socket, buffer, request)) {
+        requests_++;
+        MockResponse response = handler_(request);
+        auto connection = request.headers.find("connection");
+        bool keepAlive = connection == request.headers.end() || lower(connection->second) != "close";
+        if (!sendResponse(socket, response) || !keepAlive) {
+            break;
+        }
+    }
+    std::lock_guard<std::mutex> lk(mutex_);
+    connections_.erase(std::find(connections_.begin(), connections_.end(), socket));
+    closeSocket(native(socket));
+}
+
+bool MockRouter::readRequest(Socket socket, std::string& buffer, MockRequest& request) {
+    char chunk[16384];
+    size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+        int received = recv(native(socket), chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(received));
+    }
+
+    request = MockRequest();
+    size_t lineEnd = buffer.find("\r\n");
+    std::string requestLine = buffer.substr(0, lineEnd);
+    size_t methodEnd = requestLine.find(' ');
+    size_t pathEnd = requestLine.find(' ', methodEnd + 1);
+    if (methodEnd == std::string::npos || pathEnd == std::string::npos) {
+        return false;
+    }
+    request.method = requestLine.substr(0, methodEnd);
+    request.path = requestLine.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd) {
+        size_t end = buffer.find("\r\n", pos);
+        size_t colon = buffer.find(':', pos);
+        if (colon != std::string::npos && colon < end) {
+            size_t valueBegin = buffer.find_first_not_of(' ', colon + 1);
+            request.headers[lower(buffer.substr(pos, colon - pos))] = buffer.substr(valueBegin, end - valueBegin);
+        }
+        pos = end + 2;
+    }
+    buffer.erase(0, headerEnd + 4);
+
+    auto contentLength = request.headers.find("content-length");
+    size_t bodySize = contentLength == request.headers.end() ? 0 : strtoull(contentLength->second.c_str(), nullptr, 10);
+    while (buffer.size() < bodySize) {
+        int received = recv(native(socket), chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(received));
+    }
+    request.body = buffer.substr(0, bodySize);
+    buffer.erase(0, bodySize);
+    return true;
+}
+
+bool MockRouter::sendResponse(Socket socket, const MockResponse& response) {
+    if (!wait(response.delay)) {
+        return false;
+    }
+    std::string head = "HTTP/1.1 " + std::to_string(response.status) + " " + reasonPhrase(response.status) + "\r\n";
+    for (const auto& header : response.headers) {
+        head += header.first + ": " + header.second + "\r\n";
+    }
+    head += "Content-Length: " + std::to_string(response.body.size()) + "\r\n\r\n";
+    if (!sendAll(socket, head.data(), head.size())) {
+        return false;
+    }
+
+    size_t chunkSize = response.chunkSize ? response.chunkSize : response.body.size();
+    for (size_t pos = 0; pos < response.body.size(); pos += chunkSize) {
+        if (pos && !wait(response.chunkDelay)) {
+            return false;
+        }
+        if (!sendAll(socket, response.body.data() + pos, std::min(chunkSize, response.body.size() - pos))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MockRouter::wait(std::chrono::milliseconds duration) {
+    if (duration.count() <= 0) {
+        return !stopped_;
+    }
+    std::unique_lock<std::mutex> lk(mutex_);
+    return !stopCondition_.wait_for(lk, duration, [this] { return stopped_.load(); });
+}
+
+MockRouter::Handler keeneticHandler(std::chrono::milliseconds delay) {
+    return [delay](const MockRequest& request) {
+        MockResponse response;
+        response.delay = delay;
+        if (request.path == "/auth") {
+            if (request.method == "GET") {
+                response.status = 401;
+                response.headers = { { "X-NDM-Challenge", "abc" }, { "X-NDM-Realm", "Keenetic" } };
+            }
+            return response;
+        }
+        if (request.path.compare(0, 5, "/rci/") != 0) {
+            response.status = 404;
+            return response;
+        }
+        // One series per "attribute" of the request
+        size_t series = 0;
+        for (size_t pos = request.body.find("\"attribute\""); pos != std::string::npos;
+            pos = request.body.find("\"attribute\"", pos + 1)) {
+            series++;
+        }
+        auto now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+        response.headers = { { "Content-Type", "application/json" } };
+        response.body = rrdResponse(series, now.count());
+        return response;
+    };
+}
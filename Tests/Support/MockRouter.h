@@ -0,0 +1,93 @@
+#ifndef KEENETIC_TESTS_MOCKROUTER_H
+#define KEENETIC_TESTS_MOCKROUTER_H
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct MockRequest {
+    std::string method;
+    std::string path;
+    // Names are in lower case
+    std::map<std::string, std::string> headers;
+    std::string body;
+};
+
+struct MockResponse {
+    int status = 200;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    // Wait before anything is sent
+    std::chrono::milliseconds delay{ 0 };
+    // The body is sent in chunks of this size with chunkDelay before each one, zero sends it at once
+    size_t chunkSize = 0;
+    std::chrono::milliseconds chunkDelay{ 0 };
+};
+
+/**
+ * HTTP/1.1 stand-in for a router, listening on a free port of the loopback interface.
+ *
+ * Every connection is served by its own thread and kept alive, the handler is called from these threads.
+ * Delays are cut short when the server is stopped, the connection is then closed without a response,
+ * so tests never wait for a slow server to finish.
+ */
+class MockRouter {
+public:
+    using Handler = std::function<MockResponse(const MockRequest&)>;
+
+    // Throws std::runtime_error if the server cannot listen
+    explicit MockRouter(Handler handler);
+    ~MockRouter();
+
+    MockRouter(const MockRouter&) = delete;
+    MockRouter& operator=(const MockRouter&) = delete;
+
+    // "http://127.0.0.1:port"
+    std::string url() const;
+    uint16_t port() const;
+
+    size_t requestCount() const;
+
+    // Closes all connections and waits for their threads, called by the destructor
+    void stop();
+
+private:
+    using Socket = intptr_t;
+
+    void acceptConnections();
+    void serve(Socket socket);
+    bool readRequest(Socket socket, std::string& buffer, MockRequest& request);
+    bool sendResponse(Socket socket, const MockResponse& response);
+    // Returns false if the server was stopped meanwhile
+    bool wait(std::chrono::milliseconds duration);
+
+    Handler handler_;
+    Socket listenSocket_;
+    uint16_t port_ = 0;
+    std::atomic<size_t> requests_{ 0 };
+    std::atomic_bool stopped_{ false };
+
+    std::mutex mutex_;
+    std::condition_variable stopCondition_;
+    std::vector<Socket> connections_;
+    std::vector<std::thread> threads_;
+    std::thread acceptThread_;
+};
+
+/**
+ * Handler imitating the RCI of a Keenetic router: challenge authentication on /auth and
+ * show/interface/rrd on /rci/, answered with one sample of speed per requested series.
+ */
+MockRouter::Handler keeneticHandler(std::chrono::milliseconds delay = std::chrono::milliseconds(0));
+
+#endif
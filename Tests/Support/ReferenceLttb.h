@@ -0,0 +1,63 @@
+#ifndef KEENETIC_TESTS_REFERENCELTTB_H
+#define KEENETIC_TESTS_REFERENCELTTB_H
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "Plugin/Downsampler.h"
+
+/**
+ * Largest-Triangle-Three-Buckets written as in the original paper, computing the area of every
+ * triangle from its three vertices. Downsampler::lttb must pick the same points.
+ */
+inline void referenceLttb(const std::vector<PlotPoint>& data, size_t threshold, std::vector<PlotPoint>& out) {
+    out.clear();
+    if (threshold >= data.size()) {
+        out = data;
+        return;
+    }
+    if (threshold < 3) {
+        for (size_t i = 0; i < threshold; i++) {
+            out.push_back(i ? data.back() : data.front());
+        }
+        return;
+    }
+    double every = static_cast<double>(data.size() - 2) / (threshold - 2);
+    size_t a = 0;
+    out.push_back(data[0]);
+    for (size_t i = 0; i < threshold - 2; i++) {
+        size_t rangeBegin = static_cast<size_t>(std::floor(i * every)) + 1;
+        size_t rangeEnd = static_cast<size_t>(std::floor((i + 1) * every)) + 1;
+        size_t nextEnd = static_cast<size_t>(std::floor((i + 2) * every)) + 1;
+        if (nextEnd > data.size()) {
+            nextEnd = data.size();
+        }
+        double avgX = 0.0;
+        double avgY = 0.0;
+        for (size_t j = rangeEnd; j < nextEnd; j++) {
+            avgX += data[j].x;
+            avgY += data[j].y;
+        }
+        avgX /= nextEnd - rangeEnd;
+        avgY /= nextEnd - rangeEnd;
+
+        double maxArea = -1.0;
+        size_t next = rangeBegin;
+        for (size_t j = rangeBegin; j < rangeEnd; j++) {
+            double area = std::fabs((data[a].x - avgX) * (data[j].y - data[a].y)
+                - (data[a].x - data[j].x) * (avgY - data[a].y)) * 0.5;
+            if (area > maxArea) {
+                maxArea = area;
+                next = j;
+            }
+        }
+        out.push_back(data[next]);
+        a = next;
+    }
+    out.push_back(data.back());
+}
+
+#endif
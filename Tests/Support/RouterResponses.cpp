@@ -0,0 +1,41 @@
+#include "RouterResponses.h"
+
+std::string rrdResponse(size_t series, int64_t time, size_t samples, int64_t step) {
+    std::string out = "[";
+    for (size_t s = 0; s < series; s++) {
+        out += s ? ", " : "";
+        out += "{\"data\": [";
+        for (size_t i = 0; i < samples; i++) {
+            out += i ? ", " : "";
+            out += "{\"t\": " + std::to_string(time - static_cast<int64_t>(i) * step)
+                + ", \"v\": " + std::to_string(1000 * (s + 1) + i) + "}";
+        }
+        out += "], \"status\": []}";
+    }
+    out += "]";
+    return out;
+}
+
+std::string interfaceResponse(size_t interfaces) {
+    std::string out = "[";
+    for (size_t i = 0; i < interfaces; i++) {
+        std::string n = std::to_string(i);
+        out += i ? ", " : "";
+        out += "{\"id\": \"GigabitEthernet0/Vlan" + n + "\", \"index\": " + n
+            + ", \"interface-name\": \"Vlan" + n + "\", \"type\": \"Vlan\", \"description\": \"Segment \\\"" + n
+            + "\\\"\", \"traits\": [\"Ethernet\", \"Ip\", \"Ip6\", \"Mac\"], \"link\": \"up\", \"connected\": \"yes\", "
+            "\"state\": \"up\", \"mtu\": " + std::to_string(1500 - static_cast<int>(i))
+            + ", \"tx-queue-length\": 1000, \"address\": \"192.168." + std::to_string(i % 256)
+            + ".1\", \"mask\": \"255.255.255.0\", \"uptime\": " + std::to_string(86400 + i)
+            + ", \"global\": false, \"defaultgw\": null, \"rxpackets\": \"" + std::to_string(4000000 * (i + 1))
+            + "\", \"rxbytes\": \"" + std::to_string(5000000000ULL * (i + 1))
+            + "\", \"txbytes\": " + std::to_string(3000000000ULL * (i + 1))
+            + ", \"stat\": {\"rxspeed\": " + std::to_string(1000.5 * i) + ", \"txspeed\": 0.25, \"errors\": 0}"
+            ", \"summary\": {\"layer\": {\"conf\": \"running\", \"link\": \"running\", \"ipv4\": \"running\", "
+            "\"ipv6\": \"disabled\", \"ctrl\": \"running\"}}, \"ports\": [{\"id\": \"1\", \"speed\": 1000, "
+            "\"duplex\": \"full\"}, {\"id\": \"2\", \"speed\": " + std::to_string(100 * i)
+            + ", \"duplex\": \"half\"}], \"status\": []}";
+    }
+    out += "]";
+    return out;
+}
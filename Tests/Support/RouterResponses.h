@@ -0,0 +1,28 @@
+#ifndef KEENETIC_TESTS_ROUTERRESPONSES_H
+#define KEENETIC_TESTS_ROUTERRESPONSES_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Responses of show/interface/rrd in the form sent by the router, for the mock router,
+ * parser tests and benchmarks. Values are deterministic: sample i of series s is 1000 * (s + 1) + i.
+ *
+ * @param series - number of elements of the top-level array.
+ * @param time - router timestamp of the newest sample, in seconds.
+ * @param samples - samples per series, newest first, step seconds apart.
+ */
+std::string rrdResponse(size_t series, int64_t time, size_t samples = 1, int64_t step = 1);
+
+/**
+ * Response of show/interface, or of show/interface/stat for the same interfaces: one object of
+ * about 700 bytes per interface with nested objects and arrays, as custom commands return.
+ * Interface i has rxbytes of "5000000000 * (i + 1)" as a string and txbytes of 3000000000 * (i + 1)
+ * as a number, mtu of 1500 - i, stat.rxspeed of 1000.5 * i and ports[1].speed of 100 * i.
+ */
+std::string interfaceResponse(size_t interfaces);
+
+#endif
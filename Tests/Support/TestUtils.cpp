@@ -0,0 +1,75 @@
+#include "TestUtils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+namespace TestUtils {
+
+namespace {
+
+struct TestCase {
+    const char* name;
+    TestFunc func;
+};
+
+std::vector<TestCase>& registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+int failures = 0;
+
+bool selected(const char* name, int argc, char* argv[]) {
+    if (argc < 2) {
+        return true;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+Registrar::Registrar(const char* name, TestFunc func) {
+    registry().push_back({ name, func });
+}
+
+void fail(const char* file, int line, const char* expression) {
+    failures++;
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+}
+
+int runTests(int argc, char* argv[]) {
+    int failedTests = 0;
+    for (const TestCase& test : registry()) {
+        if (!selected(test.name, argc, argv)) {
+            continue;
+        }
+        int before = failures;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            test.func();
+        } catch (const std::exception& e) {
+            fail(__FILE__, __LINE__, e.what());
+        } catch (...) {
+            fail(__FILE__, __LINE__, "unknown exception");
+        }
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        bool passed = failures == before;
+        failedTests += passed ? 0 : 1;
+        printf("[%s] %s (%lld ms)\n", passed ? "  OK  " : "FAILED", test.name, static_cast<long long>(ms));
+    }
+    return failedTests ? 1 : 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    return TestUtils::runTests(argc, argv);
+}
@@ -0,0 +1,41 @@
+#ifndef KEENETIC_TESTS_TESTUTILS_H
+#define KEENETIC_TESTS_TESTUTILS_H
+
+#pragma once
+
+#include <cmath>
+
+/**
+ * Minimal harness of the standalone tests. TEST() registers a test case, CHECK() reports a failed
+ * condition and lets the test case continue. Every test executable runs all of its test cases,
+ * or the ones named on the command line, and exits with a non-zero code if any check failed.
+ */
+namespace TestUtils {
+
+using TestFunc = void (*)();
+
+struct Registrar {
+    Registrar(const char* name, TestFunc func);
+};
+
+void fail(const char* file, int line, const char* expression);
+
+int runTests(int argc, char* argv[]);
+
+}
+
+#define TEST(name) \
+    static void name(); \
+    static TestUtils::Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            TestUtils::fail(__FILE__, __LINE__, #condition); \
+        } \
+    } while (false)
+
+#define CHECK_NEAR(value, expected, tolerance) CHECK(std::fabs((value) - (expected)) <= (tolerance))
+
+#endif